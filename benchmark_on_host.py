@@ -0,0 +1,576 @@
+from argparse import ArgumentParser
+from os import makedirs, urandom
+from os.path import join, isfile
+from re import search
+from resource import getrusage, RUSAGE_CHILDREN
+from shlex import split
+from shutil import rmtree
+from signal import SIGINT
+from subprocess import run, Popen, DEVNULL, TimeoutExpired
+from tempfile import mkdtemp
+from time import sleep
+
+from evaluation import percentile, read_log, read_trace, compute_stage_metrics, CYCLE_COLUMN, PATH_COLUMN
+
+# general configuration constants
+OPC_UA_SERVER_START_PORT = 4840
+PUBSUB_URLS = {'udp': 'opc.udp://224.0.0.1:15000/', 'eth': 'opc.eth://01-00-5E-7F-00-01'}
+# the subscriber of the echo mode sends every received counter back to the publisher on this address
+ECHO_URLS = {'udp': 'opc.udp://224.0.0.2:15001/', 'eth': 'opc.eth://01-00-5E-7F-00-02'}
+# the publisher sends a copy of every message over the redundant path to this address
+REDUNDANT_URLS = {'udp': 'opc.udp://224.0.0.3:15002/', 'eth': 'opc.eth://01-00-5E-7F-00-03'}
+BENCHMARK_FILE_NAME = './logs/benchmark.csv'
+NAMESPACE_PREFIX = 'opcua_bench'
+LOOPBACK_IP = '127.0.0.1'
+PUB_VETH_IP = '10.47.0.1'
+SUB_VETH_IP = '10.47.0.2'
+PUB_REDUNDANT_VETH_IP = '10.47.1.1'
+SUB_REDUNDANT_VETH_IP = '10.47.1.2'
+SUBSCRIBER_STARTUP_SECONDS = 1
+SUBSCRIBER_DRAIN_SECONDS = 1
+TIMEOUT_MARGIN_SECONDS = 10
+DEFAULT_CYCLE_TIMES_NS = [1_000_000, 500_000, 250_000, 100_000]
+DEFAULT_MEASUREMENTS = 10_000
+DEFAULT_ETF_DELTA_NS = 100_000
+DECODE_BENCHMARK_CYCLE_TIME_NS = 1_000_000
+# the counter field is always published, the payload sweep adds a single float array field
+COUNTER_SIZE_BYTES = 8
+ARRAY_ELEMENT_SIZE_BYTES = 4
+MAX_PAYLOAD_SIZE_BYTES = 1400
+DEFAULT_PAYLOAD_SIZES = [8, 64, 256, 512, 1024, MAX_PAYLOAD_SIZE_BYTES]
+# every publisher of the fan in sweep starts its own opc ua server, the subscriber is limited by MAX_SOURCES in opcua_pubsub.h
+MAX_FAN_IN = 256
+PUBLISHER_STARTUP_SECONDS = 0.05
+# every process of a benchmark point writes its standard output into this file of its directory
+OUTPUT_FILE_NAME = 'output.txt'
+# the publish threads of the core count sweep take the first cpus of this list, keep it within MAX_PUBLISH_THREADS of opcua_pubsub.h
+DEFAULT_PUBLISH_CPUS = [0, 1, 2, 3]
+SECURITY_MODES = ['none', 'sign', 'sign-and-encrypt']
+# signing key, encrypting key and key nonce of the security sweep, keep in sync with SECURITY_KEYS_LENGTH in opcua_pubsub.h
+SECURITY_KEYS_LENGTH = 52
+
+
+# run a shell command and fail loudly if it does not succeed
+def sh(command, check=True):
+    run(command, shell=True, check=check, stdout=DEVNULL, stderr=DEVNULL)
+
+
+# create the network namespaces of the selected topology and return (prefix, interfaces) for publisher and subscriber,
+# the interface of the udp transport is given by its ip and the one of the ethernet transport by its name, the redundant path
+# is a second veth pair whose frames can be delayed or dropped by netem, the loopback topologies run both paths over lo
+def setup_topology(topology, etf_delta_ns=None, redundant_netem=None):
+    loopback_interfaces = {'udp': LOOPBACK_IP, 'eth': 'lo', 'redundant_udp': LOOPBACK_IP, 'redundant_eth': 'lo'}
+    if topology == 'host':
+        return ([], loopback_interfaces), ([], loopback_interfaces)
+    teardown_topology(topology)
+    if topology == 'lo':
+        namespace = f'{NAMESPACE_PREFIX}_lo'
+        sh(f'ip netns add {namespace}')
+        sh(f'ip -n {namespace} link set lo up multicast on')
+        sh(f'ip -n {namespace} route add 224.0.0.0/4 dev lo')
+        prefix = ['ip', 'netns', 'exec', namespace]
+        return (prefix, loopback_interfaces), (prefix, loopback_interfaces)
+    pub_namespace, sub_namespace = f'{NAMESPACE_PREFIX}_pub', f'{NAMESPACE_PREFIX}_sub'
+    sh(f'ip netns add {pub_namespace}')
+    sh(f'ip netns add {sub_namespace}')
+    sh(f'ip link add veth_pub netns {pub_namespace} type veth peer name veth_sub netns {sub_namespace}')
+    sh(f'ip link add veth_pub2 netns {pub_namespace} type veth peer name veth_sub2 netns {sub_namespace}')
+    for namespace, interface, ip in [(pub_namespace, 'veth_pub', PUB_VETH_IP), (sub_namespace, 'veth_sub', SUB_VETH_IP)]:
+        sh(f'ip -n {namespace} link set lo up')
+        sh(f'ip -n {namespace} addr add {ip}/24 dev {interface}')
+        sh(f'ip -n {namespace} link set {interface} up multicast on')
+        sh(f'ip -n {namespace} route add 224.0.0.0/4 dev {interface}')
+    for namespace, interface, ip in [(pub_namespace, 'veth_pub2', PUB_REDUNDANT_VETH_IP), (sub_namespace, 'veth_sub2', SUB_REDUNDANT_VETH_IP)]:
+        # the more specific route keeps the multicast group of the redundant path on the second pair
+        sh(f'ip -n {namespace} addr add {ip}/24 dev {interface}')
+        sh(f'ip -n {namespace} link set {interface} up multicast on')
+        sh(f'ip -n {namespace} route add {REDUNDANT_URLS["udp"].split("/")[2].split(":")[0]}/32 dev {interface}')
+    if etf_delta_ns is not None:
+        # software ETF qdisc that releases each frame delta ns before its SO_TXTIME launch time
+        sh(f'ip netns exec {pub_namespace} tc qdisc replace dev veth_pub root etf clockid CLOCK_TAI delta {etf_delta_ns}')
+    if redundant_netem is not None:
+        sh(f'ip netns exec {pub_namespace} tc qdisc replace dev veth_pub2 root netem {redundant_netem}')
+    return (['ip', 'netns', 'exec', pub_namespace], {'udp': PUB_VETH_IP, 'eth': 'veth_pub', 'redundant_udp': PUB_REDUNDANT_VETH_IP,
+                                                     'redundant_eth': 'veth_pub2'}), \
+           (['ip', 'netns', 'exec', sub_namespace], {'udp': SUB_VETH_IP, 'eth': 'veth_sub', 'redundant_udp': SUB_REDUNDANT_VETH_IP,
+                                                     'redundant_eth': 'veth_sub2'})
+
+
+# remove all network namespaces created for the selected topology
+def teardown_topology(topology):
+    for suffix in {'host': [], 'lo': ['lo'], 'veth': ['pub', 'sub']}[topology]:
+        sh(f'ip netns del {NAMESPACE_PREFIX}_{suffix}', check=False)
+
+
+# warn if the executables were built with the coverage profile as their timings are meaningless
+def check_build_type(build_dir):
+    cache_file = join(build_dir, 'CMakeCache.txt')
+    if isfile(cache_file):
+        with open(cache_file) as cache:
+            for line in cache:
+                if line.startswith('CMAKE_BUILD_TYPE:') and line.strip().split('=')[-1] not in ['Release', 'RelWithDebInfo']:
+                    print(f'warning: {build_dir} uses build type {line.strip().split("=")[-1]}, configure with -DCMAKE_BUILD_TYPE=Release')
+
+
+# return the command line options that make the published data set as large as the given payload size
+def payload_options(payload_size):
+    array_length = (payload_size - COUNTER_SIZE_BYTES) // ARRAY_ELEMENT_SIZE_BYTES
+    return ['--array-fields', '1', '--array-length', str(array_length)] if array_length > 0 else []
+
+
+# return the command line of the publisher or subscriber for one benchmark point, host is the (prefix, interfaces) pair of its
+# side of the topology
+def pubsub_command(build_dir, exec_type, host, transport, port, cycle_time_ns, measurements, options):
+    prefix, interfaces = host
+    return prefix + [join(build_dir, f'opcua_{exec_type}_x86')] + options + \
+        [interfaces[transport], PUBSUB_URLS[transport], str(port), str(cycle_time_ns), str(measurements)]
+
+
+# start the (directory, command, startup seconds, waited) processes one after another, each in its own directory of a temporary
+# run directory, wait up to timeout seconds for every waited process and stop the other ones with SIGINT if they did not finish
+# within the drain time, then return the files of the run directory read with the readers of the given {path: reader} dict and
+# the output of every process by its directory, or None on failure
+def run_processes(specs, readers, timeout):
+    run_dir = mkdtemp(prefix=f'{NAMESPACE_PREFIX}_')
+    processes = []
+    try:
+        for directory, command, startup_seconds, _ in specs:
+            makedirs(join(run_dir, directory))
+            # the output goes to a file, a pipe nobody reads while the process runs could fill up and block it
+            with open(join(run_dir, directory, OUTPUT_FILE_NAME), 'w') as output:
+                processes.append(Popen(command, cwd=join(run_dir, directory), stdout=output, stderr=DEVNULL))
+            sleep(startup_seconds)
+        try:
+            for process, (_, _, _, waited) in zip(processes, specs):
+                if waited:
+                    process.wait(timeout)
+            for process, (_, _, _, waited) in zip(processes, specs):
+                if not waited:
+                    try:
+                        process.wait(SUBSCRIBER_DRAIN_SECONDS)
+                    except TimeoutExpired:
+                        # frames were lost or the process runs until it is stopped, SIGINT lets it complete its log with the
+                        # received records
+                        process.send_signal(SIGINT)
+                        process.wait(TIMEOUT_MARGIN_SECONDS)
+        except TimeoutExpired:
+            return None
+        if any(process.returncode != 0 for process in processes):
+            return None
+        files = {path: reader(join(run_dir, path)) for path, reader in readers.items() if isfile(join(run_dir, path))}
+        outputs = {}
+        for directory, _, _, _ in specs:
+            with open(join(run_dir, directory, OUTPUT_FILE_NAME)) as output:
+                outputs[directory] = output.read()
+        return files, outputs
+    finally:
+        for process in processes:
+            if process.poll() is None:
+                process.kill()
+                process.wait()
+        rmtree(run_dir, ignore_errors=True)
+
+
+# run publisher and subscriber against each other for one benchmark point and return both logs or None on failure, the echo mode
+# returns the echo log of the publisher as third log and the redundant mode sends every message over both paths, with trace the trace
+# files of both sides of a PUBSUB_TRACE build follow as last element
+def run_point(build_dir, publisher, subscriber, transport, cycle_time_ns, payload_size, measurements, extra_args, echo=False,
+              redundant=False, trace=False):
+    specs = []
+    for index, (exec_type, host) in enumerate([('subscriber', subscriber), ('publisher', publisher)]):
+        options = payload_options(payload_size) + extra_args[exec_type] + (['--echo', ECHO_URLS[transport]] if echo else []) + \
+            (['--redundant-path', f'{host[1]["redundant_" + transport]},{REDUNDANT_URLS[transport]}'] if redundant else [])
+        command = pubsub_command(build_dir, exec_type, host, transport, OPC_UA_SERVER_START_PORT + index, cycle_time_ns, measurements, options)
+        specs.append((exec_type, command, SUBSCRIBER_STARTUP_SECONDS if exec_type == 'subscriber' else 0, exec_type == 'publisher'))
+    log_paths = [join('publisher', 'publish.bin'), join('subscriber', 'subscribe.bin')] + ([join('publisher', 'echo.bin')] if echo else [])
+    trace_paths = [join('publisher', 'publish_trace.bin'), join('subscriber', 'subscribe_trace.bin')] if trace else []
+    point = run_processes(specs, {**{path: read_log for path in log_paths}, **{path: read_trace for path in trace_paths}},
+                          cycle_time_ns * measurements * 1E-9 + TIMEOUT_MARGIN_SECONDS)
+    if point is None:
+        return None
+    files, _ = point
+    logs = tuple(files[path] for path in log_paths)
+    if trace:
+        if not all(path in files for path in trace_paths):
+            raise RuntimeError('the executables write no trace files, configure them with -DPUBSUB_TRACE=ON')
+        logs += (tuple(files[path] for path in trace_paths),)
+    return logs
+
+
+# run the decode benchmark of the subscriber against a publisher for one payload size and return the ns per message of the
+# full decoder and of the fixed layout decoder or None on failure
+def run_decode_point(build_dir, publisher, subscriber, transport, payload_size, messages, extra_args):
+    # the subscriber stops after the decoded messages, the publisher runs until it is stopped
+    options = payload_options(payload_size)
+    point = run_processes([('subscriber', pubsub_command(build_dir, 'subscriber', subscriber, transport, OPC_UA_SERVER_START_PORT,
+                                                         DECODE_BENCHMARK_CYCLE_TIME_NS, 0,
+                                                         options + extra_args['subscriber'] + ['--benchmark-decode', str(messages)]),
+                            SUBSCRIBER_STARTUP_SECONDS, True),
+                           ('publisher', pubsub_command(build_dir, 'publisher', publisher, transport, OPC_UA_SERVER_START_PORT + 1,
+                                                        DECODE_BENCHMARK_CYCLE_TIME_NS, 0, options + extra_args['publisher']), 0, False)],
+                          {}, TIMEOUT_MARGIN_SECONDS)
+    if point is None:
+        return None
+    _, outputs = point
+    times = [search(rf'{name}: ([0-9.]+) ns per message', outputs['subscriber']) for name in ['full decode', 'fixed layout decode']]
+    if None in times:
+        return None
+    return tuple(float(time.group(1)) for time in times)
+
+
+# run one benchmark point with batches of the given size on both sides and return both logs and the cpu seconds both processes
+# spent, or None on failure
+def run_batch_point(build_dir, publisher, subscriber, transport, cycle_time_ns, batch_size, measurements, extra_args):
+    batch_args = {exec_type: extra_args[exec_type] + ['--batch-size', str(batch_size)] for exec_type in extra_args}
+    before = getrusage(RUSAGE_CHILDREN)
+    logs = run_point(build_dir, publisher, subscriber, transport, cycle_time_ns, COUNTER_SIZE_BYTES, measurements, batch_args)
+    after = getrusage(RUSAGE_CHILDREN)
+    if logs is None:
+        return None
+    return logs, after.ru_utime + after.ru_stime - before.ru_utime - before.ru_stime
+
+
+# run one subscriber against the given number of publishers, each publishing its own source, and return the publish logs, the
+# subscribe log and the cpu time of the subscribe thread in us per message, or None on failure
+def run_fan_in_point(build_dir, publisher, subscriber, transport, cycle_time_ns, sources, measurements, extra_args):
+    # publisher id 0 is not valid, the sources are numbered from 1
+    source_args = [f'{index + 1}:1:1' for index in range(sources)]
+    specs = [('subscriber', pubsub_command(build_dir, 'subscriber', subscriber, transport, OPC_UA_SERVER_START_PORT, cycle_time_ns, measurements,
+                                           extra_args['subscriber'] + [x for source in source_args for x in ['--source', source]]),
+              SUBSCRIBER_STARTUP_SECONDS, False)]
+    specs += [(f'publisher{index}', pubsub_command(build_dir, 'publisher', publisher, transport, OPC_UA_SERVER_START_PORT + 1 + index,
+                                                   cycle_time_ns, measurements, extra_args['publisher'] + ['--source', source]),
+               PUBLISHER_STARTUP_SECONDS, True) for index, source in enumerate(source_args)]
+    log_paths = [join(f'publisher{index}', 'publish.bin') for index in range(sources)] + [join('subscriber', 'subscribe.bin')]
+    point = run_processes(specs, {path: read_log for path in log_paths}, cycle_time_ns * measurements * 1E-9 + TIMEOUT_MARGIN_SECONDS)
+    if point is None:
+        return None
+    files, outputs = point
+    cpu_time = search(r'subscribe thread cpu time: [0-9]+ us for [0-9]+ messages of [0-9]+ sources, ([0-9.]+) us per message',
+                      outputs['subscriber'])
+    if cpu_time is None:
+        return None
+    return [files[path] for path in log_paths[:-1]], files[log_paths[-1]], float(cpu_time.group(1))
+
+
+# run a publisher with one publish thread per given cpu against a subscriber of all their writer groups and return the publish log
+# of every thread and the subscribe log, or None on failure
+def run_threads_point(build_dir, publisher, subscriber, transport, cycle_time_ns, cpus, measurements, extra_args):
+    # the publish threads use consecutive writer group ids starting at the one of opcua_dataset.h
+    thread_args = {'subscriber': [x for index in range(len(cpus)) for x in ['--source', f'1:{index + 1}:1']],
+                   'publisher': ['--publish-cpus', ','.join(str(cpu) for cpu in cpus)]}
+    specs = [(exec_type, pubsub_command(build_dir, exec_type, host, transport, OPC_UA_SERVER_START_PORT + index, cycle_time_ns, measurements,
+                                        extra_args[exec_type] + thread_args[exec_type]),
+              SUBSCRIBER_STARTUP_SECONDS if exec_type == 'subscriber' else 0, exec_type == 'publisher')
+             for index, (exec_type, host) in enumerate([('subscriber', subscriber), ('publisher', publisher)])]
+    log_paths = [join('publisher', 'publish.bin' if index == 0 else f'publish{index}.bin') for index in range(len(cpus))] + \
+        [join('subscriber', 'subscribe.bin')]
+    point = run_processes(specs, {path: read_log for path in log_paths}, cycle_time_ns * measurements * 1E-9 + TIMEOUT_MARGIN_SECONDS)
+    if point is None:
+        return None
+    files, _ = point
+    return [files[path] for path in log_paths[:-1]], files[log_paths[-1]]
+
+
+# return the latencies in us of all sources of a fan in point, the subscribe records carry the index of their source in column 7
+def compute_fan_in_latencies(publish_logs, subscribe_data):
+    sent_timestamps = {(source, record[0]): send_timestamp(record) for source, publish_data in enumerate(publish_logs) for record in publish_data}
+    return [(record[1] - sent_timestamps[(record[7], record[0])]) * 1E-3 for record in subscribe_data if (record[7], record[0]) in sent_timestamps]
+
+
+# return the time a publish record was sent, which is the requested launch time if the frame was scheduled with SO_TXTIME
+def send_timestamp(record):
+    return record[3] if len(record) > 3 and record[3] > 0 else record[1]
+
+
+# compute the latency and jitter metrics of one benchmark point in microseconds
+def compute_point_metrics(publish_data, subscribe_data, cycle_time_ns, echo_data=None):
+    sent_timestamps = {record[0]: send_timestamp(record) for record in publish_data}
+    latencies = [(record[1] - sent_timestamps[record[0]]) * 1E-3 for record in subscribe_data if record[0] in sent_timestamps]
+    # a cycle the publisher skipped after an overrun leaves a gap in the cycle column instead of shifting all later targets
+    publish_jitters = [(send_timestamp(record) - send_timestamp(publish_data[0]) -
+                        (record[CYCLE_COLUMN] - publish_data[0][CYCLE_COLUMN] if len(record) > CYCLE_COLUMN else index) * cycle_time_ns) * 1E-3
+                       for index, record in enumerate(publish_data)]
+    subscribe_intervals = [(after[1] - before[1]) * 1E-3 for before, after in zip(subscribe_data, subscribe_data[1:])]
+    subscribe_jitters = [interval - cycle_time_ns * 1E-3 for interval in subscribe_intervals]
+    publish_durations = [(record[2] - record[1]) * 1E-3 for record in publish_data]
+    subscribe_durations = [(record[2] - record[1]) * 1E-3 for record in subscribe_data]
+    metrics = [('latency [us]', latencies), ('publish duration [us]', publish_durations), ('publish jitter [us]', publish_jitters),
+               ('subscribe duration [us]', subscribe_durations), ('subscribe interval jitter [us]', subscribe_jitters)]
+    # split the latency at the tx timestamp into the time in the publishing host stack and the time on the wire
+    tx_timestamps = {record[0]: record[4] for record in publish_data if len(record) > 4 and record[4] > 0}
+    if tx_timestamps:
+        host_stack_times = [(record[4] - record[1]) * 1E-3 for record in publish_data if record[0] in tx_timestamps]
+        wire_latencies = [(record[1] - tx_timestamps[record[0]]) * 1E-3 for record in subscribe_data if record[0] in tx_timestamps]
+        metrics += [('host stack [us]', host_stack_times), ('wire latency [us]', wire_latencies)]
+    # the round trip is sent and received on the clock of the publisher, half of it is the latency without any clock synchronization
+    # and the one way latency beyond that is the error of the clock sync plus the asymmetry of both directions
+    if echo_data:
+        round_trips = {record[0]: (record[1] - record[6]) * 1E-3 for record in echo_data}
+        one_way_errors = [(record[1] - sent_timestamps[record[0]]) * 1E-3 - round_trips[record[0]] / 2 for record in subscribe_data
+                          if record[0] in sent_timestamps and record[0] in round_trips]
+        metrics += [('round trip [us]', list(round_trips.values()))]
+        if one_way_errors:
+            metrics += [('one way - round trip / 2 [us]', one_way_errors)]
+    return metrics
+
+
+# write the header of the csv file, the point columns identify a point within its sweep
+def write_header(output, point_columns, sep=','):
+    output.write(sep.join(['topology', 'transport'] + point_columns + ['name', 'min', 'median', 'p99', 'p99.9', 'max', 'jitter', 'lost']) + '\n')
+
+
+# write one line per metric of a benchmark point in csv style, a metric measured once per point has a single value and metrics
+# without any value are skipped
+def write_point(output, topology, transport, point, metrics, lost, sep=','):
+    for name, lst in metrics:
+        if not lst:
+            continue
+        output.write(sep.join([topology, transport] + point + [name,
+                                                               f'{min(lst):.3f}',
+                                                               f'{percentile(lst, 50):.3f}',
+                                                               f'{percentile(lst, 99):.3f}',
+                                                               f'{percentile(lst, 99.9):.3f}',
+                                                               f'{max(lst):.3f}',
+                                                               f'{max(lst) - min(lst):.3f}',
+                                                               str(lost)]) + '\n')
+
+
+# the sweeps run their points for one transport and yield the point columns, the metrics and the lost messages of every point,
+# a failed point is reported and skipped
+
+# sweep the cycle times and payload sizes and yield the latency and jitter metrics of publisher and subscriber
+def sweep_latency(args, publisher, subscriber, transport, extra_args):
+    for cycle_time_ns in args.cycle_times:
+        for payload_size in args.payload_sizes:
+            logs = run_point(args.build_dir, publisher, subscriber, transport, cycle_time_ns, payload_size, args.measurements, extra_args,
+                             args.echo, args.redundant, args.trace)
+            if logs is None:
+                print(f'benchmark point failed: {transport}, cycle time {cycle_time_ns} ns, payload {payload_size} B')
+                continue
+            publish_data, subscribe_data = logs[:2]
+            if args.redundant:
+                first_copies = [sum(1 for x in subscribe_data if x[PATH_COLUMN] == path) for path in range(2)]
+                print(f'{transport}, cycle time {cycle_time_ns} ns, payload {payload_size} B: the primary path delivered '
+                      f'{first_copies[0]} and the redundant path {first_copies[1]} first copies')
+            metrics = compute_point_metrics(publish_data, subscribe_data, cycle_time_ns, logs[2] if args.echo else None)
+            if args.trace:
+                # both sides run on this host and share the trace clock, so the stages form one chain from the deadline
+                # of the publisher to the log of the subscriber
+                metrics += compute_stage_metrics(*logs[-1])
+            yield [str(cycle_time_ns), str(payload_size)], metrics, len(publish_data) - len(subscribe_data)
+
+
+# sweep the payload sizes and yield the decode time per message of the full and the fixed layout decoder
+def sweep_decode(args, publisher, subscriber, transport, extra_args):
+    for payload_size in args.payload_sizes:
+        times = run_decode_point(args.build_dir, publisher, subscriber, transport, payload_size, args.decode_benchmark, extra_args)
+        if times is None:
+            print(f'decode benchmark point failed: {transport}, payload {payload_size} B')
+            continue
+        yield [str(payload_size)], [('full decode [ns]', [times[0]]), ('fixed layout decode [ns]', [times[1]])], 'nan'
+
+
+# sweep the cycle times and batch sizes and yield the message rate, the cpu time per sample and the per sample latency
+def sweep_batch(args, publisher, subscriber, transport, extra_args):
+    for cycle_time_ns in args.cycle_times:
+        for batch_size in args.batch_sizes:
+            point = run_batch_point(args.build_dir, publisher, subscriber, transport, cycle_time_ns, batch_size, args.measurements, extra_args)
+            if point is None:
+                print(f'batch benchmark point failed: {transport}, cycle time {cycle_time_ns} ns, batch size {batch_size}')
+                continue
+            (publish_data, subscribe_data), cpu_seconds = point
+            latencies = dict(compute_point_metrics(publish_data, subscribe_data, cycle_time_ns))['latency [us]']
+            samples_per_second = 1E9 / cycle_time_ns
+            yield [str(cycle_time_ns), str(batch_size)], [('messages/s', [samples_per_second / batch_size]), ('samples/s', [samples_per_second]),
+                                                          ('cpu per sample [us]', [cpu_seconds * 1E6 / len(publish_data)]),
+                                                          ('latency [us]', latencies)], len(publish_data) - len(subscribe_data)
+
+
+# sweep the cycle times and publish thread counts and yield the aggregate message rate, the jitter and the latency of every thread
+def sweep_publish_threads(args, publisher, subscriber, transport, extra_args):
+    for cycle_time_ns in args.cycle_times:
+        for threads in args.publish_threads:
+            cpus = args.publish_cpus[:threads]
+            point = run_threads_point(args.build_dir, publisher, subscriber, transport, cycle_time_ns, cpus, args.measurements, extra_args)
+            if point is None:
+                print(f'publish threads benchmark point failed: {transport}, cycle time {cycle_time_ns} ns, {threads} threads')
+                continue
+            publish_logs, subscribe_data = point
+            # the message rate all threads reached together between the first and the last frame sent
+            first_sent = min(send_timestamp(log[0]) for log in publish_logs)
+            last_sent = max(send_timestamp(log[-1]) for log in publish_logs)
+            messages_per_second = (sum(len(log) for log in publish_logs) - 1) * 1E9 / max(last_sent - first_sent, 1)
+            for index, publish_data in enumerate(publish_logs):
+                # the subscriber lists the writer groups of the threads in order, so column 7 is the index of the thread
+                thread_records = [record for record in subscribe_data if record[7] == index]
+                metrics = dict(compute_point_metrics(publish_data, thread_records, cycle_time_ns))
+                yield [str(cycle_time_ns), str(threads), str(index), str(cpus[index])], \
+                    [('aggregate messages/s', [messages_per_second]), ('publish jitter [us]', [abs(x) for x in metrics['publish jitter [us]']]),
+                     ('latency [us]', metrics['latency [us]'])], len(publish_data) - len(thread_records)
+
+
+# sweep the cycle times and publisher counts and yield the latency and the cpu time and load of the subscribe thread
+def sweep_fan_in(args, publisher, subscriber, transport, extra_args):
+    for cycle_time_ns in args.cycle_times:
+        for sources in args.fan_in:
+            point = run_fan_in_point(args.build_dir, publisher, subscriber, transport, cycle_time_ns, sources, args.measurements, extra_args)
+            if point is None:
+                print(f'fan in benchmark point failed: {transport}, cycle time {cycle_time_ns} ns, {sources} publishers')
+                continue
+            publish_logs, subscribe_data, cpu_per_message = point
+            messages_per_second = sources * 1E9 / cycle_time_ns
+            yield [str(cycle_time_ns), str(sources)], [('messages/s', [messages_per_second]),
+                                                       ('latency [us]', compute_fan_in_latencies(publish_logs, subscribe_data)),
+                                                       ('subscribe cpu per message [us]', [cpu_per_message]),
+                                                       ('subscribe cpu load [%]', [cpu_per_message * messages_per_second * 1E-4])], \
+                sum(len(x) for x in publish_logs) - len(subscribe_data)
+
+
+# sweep the cycle times and payload sizes in every security mode with a random key and yield the latency, its overhead over the
+# first mode and the durations of both sides
+def sweep_security(args, publisher, subscriber, transport, extra_args):
+    key_dir = mkdtemp(prefix=f'{NAMESPACE_PREFIX}_key_')
+    key_file_name = join(key_dir, 'pubsub.key')
+    with open(key_file_name, 'wb') as key_file:
+        key_file.write(urandom(SECURITY_KEYS_LENGTH))
+    try:
+        for cycle_time_ns in args.cycle_times:
+            for payload_size in args.payload_sizes:
+                # the overhead of every mode is taken against the median latency of the first mode of this point
+                reference_median = None
+                for index, mode in enumerate(args.security_modes):
+                    security_args = [] if mode == 'none' else ['--security', f'{mode},{key_file_name}']
+                    mode_args = {exec_type: extra_args[exec_type] + security_args for exec_type in extra_args}
+                    logs = run_point(args.build_dir, publisher, subscriber, transport, cycle_time_ns, payload_size, args.measurements, mode_args,
+                                     False, args.redundant)
+                    if logs is None:
+                        print(f'security benchmark point failed: {transport}, cycle time {cycle_time_ns} ns, payload {payload_size} B, {mode}')
+                        continue
+                    publish_data, subscribe_data = logs
+                    metrics = dict(compute_point_metrics(publish_data, subscribe_data, cycle_time_ns))
+                    median = percentile(metrics['latency [us]'], 50)
+                    if index == 0:
+                        reference_median = median
+                    yield [str(cycle_time_ns), str(payload_size), mode], \
+                        [('latency [us]', metrics['latency [us]']),
+                         ('latency median overhead [us]', [median - reference_median] if reference_median is not None else []),
+                         ('publish duration [us]', metrics['publish duration [us]']),
+                         ('subscribe duration [us]', metrics['subscribe duration [us]'])], len(publish_data) - len(subscribe_data)
+    finally:
+        rmtree(key_dir)
+
+
+def main():
+    parser = ArgumentParser(description='run publisher and subscriber on this host and report latency and jitter')
+    parser.add_argument('--build-dir', default='./build', help='directory containing opcua_publisher_x86 and opcua_subscriber_x86')
+    parser.add_argument('--topology', choices=['lo', 'veth', 'host'], default='lo',
+                        help='lo: multicast over loopback in a namespace, veth: veth pair between two namespaces, host: loopback of the host')
+    parser.add_argument('--transports', choices=list(PUBSUB_URLS), nargs='+', default=['udp'],
+                        help='udp: uadp over udp multicast, eth: uadp over raw ethernet, both can be compared in one run')
+    parser.add_argument('--cycle-times', type=int, nargs='+', default=DEFAULT_CYCLE_TIMES_NS, help='cycle times in ns to sweep')
+    parser.add_argument('--payload-sizes', type=int, nargs='+', default=DEFAULT_PAYLOAD_SIZES,
+                        help=f'payload sizes in bytes to sweep, from {COUNTER_SIZE_BYTES} up to about {MAX_PAYLOAD_SIZE_BYTES} for a 1500 byte MTU')
+    parser.add_argument('--measurements', type=int, default=DEFAULT_MEASUREMENTS, help='measurements per benchmark point')
+    parser.add_argument('--txtime-offset', type=int, help='publish with SO_TXTIME, waking up this many ns before the cycle boundary '
+                                                          '(veth topology only, installs a software ETF qdisc)')
+    parser.add_argument('--etf-delta', type=int, default=DEFAULT_ETF_DELTA_NS, help='delta of the ETF qdisc in ns')
+    parser.add_argument('--tx-timestamps', action='store_true', help='log kernel tx timestamps and split the latency at them')
+    parser.add_argument('--warmup-cycles', type=int, default=0, help='cycles both sides run before the measurement starts')
+    parser.add_argument('--lock-memory', action='store_true', help='lock and prefault the memory of both sides')
+    parser.add_argument('--xdp', action='store_true', help='send and receive the frames through af_xdp sockets (eth transport only)')
+    parser.add_argument('--decode-benchmark', type=int, metavar='MESSAGES',
+                        help='instead of the latency sweep, measure the decode time per message of the subscriber over the payload sizes')
+    parser.add_argument('--batch-sizes', type=int, nargs='+', metavar='K',
+                        help='instead of the latency sweep, publish batches of K samples taken every cycle and report the message rate, '
+                             'the cpu time and the per sample latency for each K')
+    parser.add_argument('--fan-in', type=int, nargs='+', metavar='N',
+                        help=f'instead of the latency sweep, run N publishers with their own source against one subscriber, up to {MAX_FAN_IN}, '
+                             'and report the latency and the cpu time of the subscribe thread for each N')
+    parser.add_argument('--publish-threads', type=int, nargs='+', metavar='N',
+                        help='instead of the latency sweep, publish from N threads on the first N cpus of --publish-cpus and report the '
+                             'aggregate message rate and the jitter of every thread for each N')
+    parser.add_argument('--publish-cpus', type=int, nargs='+', default=DEFAULT_PUBLISH_CPUS, help='cpus of the publish threads')
+    parser.add_argument('--echo', action='store_true', help='let the subscriber echo every message back and add the round trip measured on the '
+                                                            'clock of the publisher to the latency sweep')
+    parser.add_argument('--redundant', action='store_true', help='send every message over a second path as well and report how often each '
+                                                                 'path delivered the first copy (veth topology: a second veth pair)')
+    parser.add_argument('--redundant-netem', metavar='ARGS', help='netem arguments for the second veth pair, e.g. "delay 50us loss 1%%"')
+    parser.add_argument('--trace', action='store_true', help='add the durations of the traced stages of publisher and subscriber to the '
+                                                             'latency sweep, needs executables configured with -DPUBSUB_TRACE=ON')
+    parser.add_argument('--cooperative', type=int, metavar='MARGIN_NS', help='run the server of both sides in the slack of their rt thread '
+                                                                            'until the margin before the next cycle instead of on a thread '
+                                                                            'of its own')
+    parser.add_argument('--security-modes', nargs='+', choices=SECURITY_MODES,
+                        help='instead of the latency sweep, run every payload size in each security mode with a random key and report '
+                             'the latency and its overhead over the first mode')
+    parser.add_argument('--publisher-args', default='', help='additional options passed to the publisher, e.g. "--scalar-fields 8"')
+    parser.add_argument('--subscriber-args', default='', help='additional options passed to the subscriber, e.g. "--blocking-receive"')
+    parser.add_argument('--output', default=BENCHMARK_FILE_NAME, help='csv file the results are written to')
+    args = parser.parse_args()
+    check_build_type(args.build_dir)
+    extra_args = {'publisher': split(args.publisher_args), 'subscriber': split(args.subscriber_args)}
+    if args.txtime_offset is not None:
+        if args.topology != 'veth' or 'eth' in args.transports:
+            parser.error('--txtime-offset needs the veth topology and the udp transport')
+        extra_args['publisher'] += ['--txtime-offset', str(args.txtime_offset)]
+    for exec_type in extra_args:
+        extra_args[exec_type] += ['--warmup-cycles', str(args.warmup_cycles)] + (['--lock-memory'] if args.lock_memory else [])
+    if args.tx_timestamps:
+        extra_args['publisher'] += ['--tx-timestamps']
+    if args.xdp:
+        if args.transports != ['eth'] or args.tx_timestamps:
+            parser.error('--xdp needs the eth transport and no tx timestamps')
+        for exec_type in extra_args:
+            extra_args[exec_type] += ['--xdp']
+    if args.batch_sizes is not None and (args.txtime_offset is not None or args.tx_timestamps):
+        parser.error('--batch-sizes cannot be combined with --txtime-offset or --tx-timestamps')
+    if args.fan_in is not None and any(not 0 < sources <= MAX_FAN_IN for sources in args.fan_in):
+        parser.error(f'--fan-in takes between 1 and {MAX_FAN_IN} publishers')
+    if args.publish_threads is not None and any(not 0 < threads <= len(args.publish_cpus) for threads in args.publish_threads):
+        parser.error(f'--publish-threads takes between 1 and {len(args.publish_cpus)} threads, one per cpu of --publish-cpus')
+    if args.echo and (args.xdp or any(x is not None for x in [args.decode_benchmark, args.batch_sizes, args.fan_in, args.publish_threads])):
+        parser.error('--echo belongs to the latency sweep without --xdp')
+    if args.redundant and (args.xdp or args.txtime_offset is not None or
+                           any(x is not None for x in [args.decode_benchmark, args.batch_sizes, args.fan_in, args.publish_threads])):
+        parser.error('--redundant belongs to the latency sweep without --xdp and --txtime-offset')
+    if args.redundant_netem is not None and (not args.redundant or args.topology != 'veth'):
+        parser.error('--redundant-netem needs --redundant and the veth topology')
+    if args.trace and any(x is not None for x in [args.decode_benchmark, args.batch_sizes, args.fan_in, args.publish_threads]):
+        parser.error('--trace belongs to the latency sweep')
+    if args.cooperative is not None:
+        if args.xdp or args.echo or any(x is not None for x in [args.decode_benchmark, args.batch_sizes, args.fan_in, args.publish_threads]):
+            parser.error('--cooperative belongs to the latency sweep without --xdp and --echo')
+        for exec_type in extra_args:
+            extra_args[exec_type] += ['--cooperative', str(args.cooperative)]
+    if args.security_modes is not None and (args.xdp or args.echo or
+                                            any(x is not None for x in [args.decode_benchmark, args.batch_sizes, args.fan_in, args.publish_threads])):
+        parser.error('--security-modes belongs to the latency sweep without --xdp and --echo')
+    publisher, subscriber = setup_topology(args.topology, args.etf_delta if args.txtime_offset is not None else None, args.redundant_netem)
+    # the point columns and the sweep of the selected mode, the latency sweep is the default
+    if args.decode_benchmark is not None:
+        point_columns, sweep = ['payload [B]'], sweep_decode
+    elif args.batch_sizes is not None:
+        point_columns, sweep = ['cycle time [ns]', 'batch size'], sweep_batch
+    elif args.publish_threads is not None:
+        point_columns, sweep = ['cycle time [ns]', 'threads', 'thread', 'cpu'], sweep_publish_threads
+    elif args.fan_in is not None:
+        point_columns, sweep = ['cycle time [ns]', 'publishers'], sweep_fan_in
+    elif args.security_modes is not None:
+        point_columns, sweep = ['cycle time [ns]', 'payload [B]', 'security'], sweep_security
+    else:
+        point_columns, sweep = ['cycle time [ns]', 'payload [B]'], sweep_latency
+    try:
+        with open(args.output, 'w') as file:
+            write_header(file, point_columns)
+            for transport in args.transports:
+                for point, metrics, lost in sweep(args, publisher, subscriber, transport, extra_args):
+                    write_point(file, args.topology, transport, point, metrics, lost)
+    finally:
+        teardown_topology(args.topology)
+    with open(args.output) as file:
+        print(file.read())
+
+
+if __name__ == '__main__':
+    main()
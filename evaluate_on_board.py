@@ -1,31 +1,20 @@
 from math import ceil
-from statistics import median, stdev, mean, quantiles
 from subprocess import run
 from time import sleep
 
 from paramiko import SSHClient, AutoAddPolicy
 from scp import SCPClient
 
-
-# write computed metrics to evaluation file in csv style
-def write_statistics(output, datasets, sep=','):
-    output.write(sep.join(['name', 'min', 'max', 'range', 'median', 'iqr', 'mean', 'stdev']) + '\n')
-    for name, lst in datasets:
-        output.write(sep.join([f'{name}',
-                               f'{min(lst):.3f}',
-                               f'{max(lst):.3f}',
-                               f'{max(lst) - min(lst):.3f}',
-                               f'{median(lst):.3f}',
-                               f'{quantiles(lst)[2] - quantiles(lst)[0]:.3f}',
-                               f'{mean(lst):.3f}',
-                               f'{stdev(lst):.3f}']) + '\n')
-
+from evaluation import write_statistics, read_log, compute_metrics, match_records
 
 # general configuration constants
 OPC_UA_SERVER_START_PORT = 4840
-PUBSUB_URL = 'opc.udp://224.0.0.1:15000/'
 EVALUATION_FILE_NAME = './logs/evaluation.csv'
 VLAN_ID = 1
+VLAN_PCP = 7
+# udp sends over the vlan interface, eth sends raw frames tagged by open62541 with VLAN_ID and VLAN_PCP
+TRANSPORT = 'udp'
+PUBSUB_URLS = {'udp': 'opc.udp://224.0.0.1:15000/', 'eth': f'opc.eth://01-00-5E-7F-00-01:{VLAN_ID}.{VLAN_PCP}'}
 TIMEOUT_QBV_START_SECONDS = 2
 # time interval from interrupt to return of publish callback
 MAX_PUBLISH_DELAY_NS = 300_000
@@ -92,14 +81,14 @@ sleep(2 * TIMEOUT_QBV_START_SECONDS)
 
 # start both executables and wait for termination
 outputs = []
-for index, (exec_type, ssh_client, scp_client, ssh_username, vlan_ip) \
+for index, (exec_type, ssh_client, scp_client, ssh_username, vlan_ip, interface) \
         in enumerate(zip(['subscriber', 'publisher'], [sub_ssh_client, pub_ssh_client],
                          [sub_scp_client, pub_scp_client], [SUB_SSH_USERNAME, PUB_SSH_USERNAME],
-                         [SUB_VLAN_IP, PUB_VLAN_IP])):
+                         [SUB_VLAN_IP, PUB_VLAN_IP], [SUB_INTERFACE, PUB_INTERFACE])):
     scp_client.put(f'./build/opcua_{exec_type}_arm', f'/home/{ssh_username}/opcua_{exec_type}_arm')
     ssh_client.exec_command(f'chmod +x /home/{ssh_username}/opcua_{exec_type}_arm')[1].read()
     _, stdout, _ = ssh_client.exec_command(f'/home/{ssh_username}/opcua_{exec_type}_arm '
-                                           f'{vlan_ip} {PUBSUB_URL} {OPC_UA_SERVER_START_PORT + index} {CYCLE_TIME_NS} {MEASUREMENTS}')
+                                           f'{vlan_ip if TRANSPORT == "udp" else interface} {PUBSUB_URLS[TRANSPORT]} {OPC_UA_SERVER_START_PORT + index} {CYCLE_TIME_NS} {MEASUREMENTS}')
     outputs.append(stdout)
 for out in outputs:
     out.read()
@@ -113,34 +102,21 @@ for ssh_client, interface, vlan_ip in zip([pub_ssh_client, sub_ssh_client], [PUB
     ssh_client.exec_command(f'bridge vlan del vid {VLAN_ID} dev {interface}')[1].read()
 
 # collect produced log files during execution
-pub_scp_client.get(f'/home/{PUB_SSH_USERNAME}/publish.csv', './logs/publish.csv')
-sub_scp_client.get(f'/home/{SUB_SSH_USERNAME}/subscribe.csv', './logs/subscribe.csv')
+pub_scp_client.get(f'/home/{PUB_SSH_USERNAME}/publish.bin', './logs/publish.bin')
+sub_scp_client.get(f'/home/{SUB_SSH_USERNAME}/subscribe.bin', './logs/subscribe.bin')
 
 # read data from log files into memory
-with open('./logs/publish.csv') as publishFile:
-    publishData = [[int(x.split(',')[0]), int(x.split(',')[1])] for x in publishFile]
-with open('./logs/subscribe.csv') as subscribeFile:
-    subscribeData = [[int(x.split(',')[0]), int(x.split(',')[1])] for x in subscribeFile]
-
-assert [x[0] for x in publishData] == [x[0] for x in subscribeData] and len(publishData) == MEASUREMENTS
-
-# compute the most important metrics
-publish_intervals = [(after[1] - before[1]) * 1E-6 for before, after in zip(publishData, publishData[1:])]
-subscribe_intervals = [(after[1] - before[1]) * 1E-6 for before, after in zip(subscribeData, subscribeData[1:])]
-transmission_times = [(end[1] - start[1]) * 1E-6 for start, end in zip(publishData, subscribeData)]
-target_publish_times = [publishData[0][1] + x * CYCLE_TIME_NS for x in range(len(publishData))]
-publish_jitters = [(actual[1] - target) * 1E-6 for actual, target in zip(publishData, target_publish_times)]
-target_subscribe_times = [subscribeData[0][1] + x * CYCLE_TIME_NS for x in range(len(subscribeData))]
-subscribe_jitters = [(actual[1] - target) * 1E-6 for actual, target in zip(subscribeData, target_subscribe_times)]
+publishData = read_log('./logs/publish.bin')
+subscribeData = read_log('./logs/subscribe.bin')
+
+# skipped cycles and lost messages are reported instead of failing the whole evaluation, the metrics use the records of both logs
+if len(publishData) != MEASUREMENTS:
+    print(f'warning: the publisher logged {len(publishData)} of {MEASUREMENTS} measurements')
+publishData, subscribeData = match_records(publishData, subscribeData)
 
 # write metrics to evaluation file
 with open(EVALUATION_FILE_NAME, 'w') as file:
-    write_statistics(file,
-                     [('publish interval [ms]', publish_intervals),
-                      ('subscribe interval [ms]', subscribe_intervals),
-                      ('transmission time [ms]', transmission_times),
-                      ('publish jitter [ms]', publish_jitters),
-                      ('subscribe jitter [ms]', subscribe_jitters)])
+    write_statistics(file, compute_metrics(publishData, subscribeData, CYCLE_TIME_NS))
 
 # print evaluation file
 with open(EVALUATION_FILE_NAME) as file:
@@ -0,0 +1,27 @@
+from argparse import ArgumentParser
+from sys import stdout
+
+from evaluation import read_trace, write_stage_budget
+
+
+def main():
+    parser = ArgumentParser(description='break the latency of the traced publish and subscribe cycles of a PUBSUB_TRACE build down by stage')
+    parser.add_argument('--publish-trace', help='trace file of a publish thread, e.g. publish_trace.bin')
+    parser.add_argument('--subscribe-trace', help='trace file of the subscribe thread, e.g. subscribe_trace.bin, together with the publish '
+                                                  'trace both sides have to run on the same host')
+    parser.add_argument('--tail', type=float, default=99.9, help='percentile of the traced cycle time from which on cycles count as tail')
+    parser.add_argument('--output', help='csv file the budget is written to instead of stdout')
+    args = parser.parse_args()
+    if args.publish_trace is None and args.subscribe_trace is None:
+        parser.error('give at least one of --publish-trace and --subscribe-trace')
+    publish_trace = read_trace(args.publish_trace) if args.publish_trace is not None else None
+    subscribe_trace = read_trace(args.subscribe_trace) if args.subscribe_trace is not None else None
+    if args.output is None:
+        write_stage_budget(stdout, publish_trace, subscribe_trace, args.tail)
+    else:
+        with open(args.output, 'w') as file:
+            write_stage_budget(file, publish_trace, subscribe_trace, args.tail)
+
+
+if __name__ == '__main__':
+    main()
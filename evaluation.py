@@ -0,0 +1,170 @@
+from math import ceil
+from statistics import median, stdev, mean, quantiles
+from struct import Struct
+
+# layout of the versioned header of the binary log files, see LogFileHeader in opcua_pubsub.h
+LOG_FILE_MAGIC = b'OPCUALOG'
+LOG_FILE_VERSION = 1
+LOG_FILE_HEADER = Struct('<8sIIQQQ')
+# layout of the trace files of builds with PUBSUB_TRACE, see TraceFileHeader and TraceRecord in opcua_pubsub.h
+TRACE_FILE_MAGIC = b'OPCUATRC'
+TRACE_FILE_VERSION = 1
+TRACE_MAX_STAGES = 8
+STAGE_NAME_LENGTH = 16
+TRACE_FILE_HEADER = Struct(f'<8sIIQQ{TRACE_MAX_STAGES * STAGE_NAME_LENGTH}s')
+TRACE_RECORD = Struct(f'<{2 + TRACE_MAX_STAGES}Q')
+# the publisher stages after the frame left are not on the path of the message to the subscriber
+PUBLISH_SEND_STAGE = 'SendEnd'
+# the publisher logs the index of the cycle since its start epoch of every record in this column
+CYCLE_COLUMN = 8
+# the subscriber logs the path the first copy of every record arrived on in this column, 0 is the primary path
+PATH_COLUMN = 9
+
+
+# return the value at the given percentile (0 - 100) using the nearest rank method
+def percentile(lst, pct):
+    ordered = sorted(lst)
+    return ordered[max(0, ceil(round(pct * len(ordered) / 100, 6)) - 1)]
+
+
+# write computed metrics to evaluation file in csv style
+def write_statistics(output, datasets, sep=','):
+    output.write(sep.join(['name', 'min', 'max', 'range', 'median', 'iqr', 'mean', 'stdev', 'p99', 'p99.9']) + '\n')
+    for name, lst in datasets:
+        output.write(sep.join([f'{name}',
+                               f'{min(lst):.3f}',
+                               f'{max(lst):.3f}',
+                               f'{max(lst) - min(lst):.3f}',
+                               f'{median(lst):.3f}',
+                               f'{quantiles(lst)[2] - quantiles(lst)[0]:.3f}',
+                               f'{mean(lst):.3f}',
+                               f'{stdev(lst):.3f}',
+                               f'{percentile(lst, 99):.3f}',
+                               f'{percentile(lst, 99.9):.3f}']) + '\n')
+
+
+# read a binary log file written by the publisher or subscriber into memory, one list of unsigned 64 bit columns per record
+def read_log(file_name):
+    with open(file_name, 'rb') as log_file:
+        magic, version, record_size, _, records, dropped_records = LOG_FILE_HEADER.unpack(log_file.read(LOG_FILE_HEADER.size))
+        if magic != LOG_FILE_MAGIC or version != LOG_FILE_VERSION:
+            raise ValueError(f'{file_name} is no log file of version {LOG_FILE_VERSION}')
+        if dropped_records > 0:
+            print(f'warning: {file_name} misses {dropped_records} dropped records')
+        data = log_file.read()
+    # records is only set on a clean shutdown, otherwise all complete records up to the crash are used
+    count = records if records > 0 else len(data) // record_size
+    record = Struct(f'<{record_size // 8}Q')
+    return [list(record.unpack_from(data, index * record_size)) for index in range(count)]
+
+
+# compute the most important metrics from the publisher and subscriber logs
+def compute_metrics(publish_data, subscribe_data, cycle_time_ns):
+    publish_intervals = [(after[1] - before[1]) * 1E-6 for before, after in zip(publish_data, publish_data[1:])]
+    subscribe_intervals = [(after[1] - before[1]) * 1E-6 for before, after in zip(subscribe_data, subscribe_data[1:])]
+    transmission_times = [(end[1] - start[1]) * 1E-6 for start, end in zip(publish_data, subscribe_data)]
+    # a cycle the publisher skipped after an overrun leaves a gap in the cycle column instead of shifting all later targets
+    if len(publish_data[0]) > CYCLE_COLUMN:
+        cycles = [x[CYCLE_COLUMN] - publish_data[0][CYCLE_COLUMN] for x in publish_data]
+    else:
+        cycles = list(range(len(publish_data)))
+    target_publish_times = [publish_data[0][1] + x * cycle_time_ns for x in cycles]
+    publish_jitters = [(actual[1] - target) * 1E-6 for actual, target in zip(publish_data, target_publish_times)]
+    target_subscribe_times = [subscribe_data[0][1] + x * cycle_time_ns for x in cycles]
+    subscribe_jitters = [(actual[1] - target) * 1E-6 for actual, target in zip(subscribe_data, target_subscribe_times)]
+    return [('publish interval [ms]', publish_intervals),
+            ('subscribe interval [ms]', subscribe_intervals),
+            ('transmission time [ms]', transmission_times),
+            ('publish jitter [ms]', publish_jitters),
+            ('subscribe jitter [ms]', subscribe_jitters)]
+
+
+# match the records of both logs by their counter value, report the cycles the publisher skipped and the messages the subscriber lost
+# or received twice and return the records both logs have in the order they were published
+def match_records(publish_data, subscribe_data):
+    if len(publish_data[0]) > CYCLE_COLUMN:
+        skipped_cycles = publish_data[-1][CYCLE_COLUMN] - publish_data[0][CYCLE_COLUMN] + 1 - len(publish_data)
+        print(f'{skipped_cycles} cycles skipped by the publisher')
+    received = {}
+    for record in subscribe_data:
+        received.setdefault(record[0], record)
+    print(f'{len(publish_data) - sum(1 for x in publish_data if x[0] in received)} messages lost, '
+          f'{len(subscribe_data) - len(received)} received twice')
+    if len(subscribe_data[0]) > PATH_COLUMN and any(x[PATH_COLUMN] > 0 for x in subscribe_data):
+        print(f'{sum(1 for x in received.values() if x[PATH_COLUMN] == 0)} messages arrived first over the primary path, '
+              f'{sum(1 for x in received.values() if x[PATH_COLUMN] > 0)} over the redundant path')
+    matched_publish_data = [x for x in publish_data if x[0] in received]
+    return matched_publish_data, [received[x[0]] for x in matched_publish_data]
+
+
+
+# read a trace file written by the publisher or subscriber into memory, returns the stage names and one (cycle, value, stamps) tuple
+# per traced cycle, a stamp of 0 marks a stage the cycle did not pass
+def read_trace(file_name):
+    with open(file_name, 'rb') as trace_file:
+        magic, version, stages_size, records, overwritten_records, names = TRACE_FILE_HEADER.unpack(trace_file.read(TRACE_FILE_HEADER.size))
+        if magic != TRACE_FILE_MAGIC or version != TRACE_FILE_VERSION:
+            raise ValueError(f'{file_name} is no trace file of version {TRACE_FILE_VERSION}')
+        if overwritten_records > 0:
+            print(f'warning: {file_name} holds the last {records} cycles, {overwritten_records} older ones were overwritten')
+        data = trace_file.read(records * TRACE_RECORD.size)
+    stage_names = [names[i * STAGE_NAME_LENGTH:(i + 1) * STAGE_NAME_LENGTH].split(b'\0')[0].decode() for i in range(stages_size)]
+    return stage_names, [(x[0], x[1], list(x[2:2 + stages_size])) for x in TRACE_RECORD.iter_unpack(data)]
+
+
+# split every traced cycle into the durations between its consecutive stages in microseconds, a stage the cycle did not pass is merged
+# into the next one, with both traces the subscriber stages of a counter value follow the publisher stages up to the send, which needs
+# both sides on one host as the trace clock is not synchronized, returns the stage names in order, the durations of every cycle and
+# the time from the first to the last stage of every cycle
+def compute_stage_durations(publish_trace=None, subscribe_trace=None):
+    chains = []
+    if publish_trace is not None and subscribe_trace is not None:
+        publish_names = [f'publish {x}' for x in publish_trace[0]]
+        subscribe_names = [f'subscribe {x}' for x in subscribe_trace[0]]
+        sent = publish_trace[0].index(PUBLISH_SEND_STAGE) + 1
+        received = {value: stamps for _, value, stamps in subscribe_trace[1]}
+        chains = [list(zip(publish_names[:sent], stamps[:sent])) + list(zip(subscribe_names, received[value]))
+                  for _, value, stamps in publish_trace[1] if value in received]
+    else:
+        role, (names, records) = ('publish', publish_trace) if publish_trace is not None else ('subscribe', subscribe_trace)
+        chains = [list(zip([f'{role} {x}' for x in names], stamps)) for _, _, stamps in records]
+    stages, cycles, totals = [], [], []
+    for chain in chains:
+        stamps = [(name, stamp) for name, stamp in chain if stamp > 0]
+        if len(stamps) < 2:
+            continue
+        cycle = {}
+        for (before, start), (after, end) in zip(stamps, stamps[1:]):
+            stage = f'{before} -> {after}'
+            if stage not in stages:
+                stages.append(stage)
+            cycle[stage] = (end - start) * 1E-3
+        cycles.append(cycle)
+        totals.append((stamps[-1][1] - stamps[0][1]) * 1E-3)
+    return stages, cycles, totals
+
+
+# return the durations of every stage and the whole traced cycle as metrics in microseconds
+def compute_stage_metrics(publish_trace=None, subscribe_trace=None):
+    stages, cycles, totals = compute_stage_durations(publish_trace, subscribe_trace)
+    return [(f'{stage} [us]', [x[stage] for x in cycles if stage in x]) for stage in stages] + [('traced cycle [us]', totals)]
+
+
+# write the latency budget in csv style, the distribution of every stage and its mean share of the cycles at or above the tail percentile
+# of the whole traced cycle, which tells the stages the slowest cycles lost their time in
+def write_stage_budget(output, publish_trace=None, subscribe_trace=None, tail_pct=99.9, sep=','):
+    stages, cycles, totals = compute_stage_durations(publish_trace, subscribe_trace)
+    tail_limit = percentile(totals, tail_pct)
+    tail_cycles = [cycle for cycle, total in zip(cycles, totals) if total >= tail_limit]
+    tail_total = mean(totals[i] for i in range(len(totals)) if totals[i] >= tail_limit)
+    output.write(sep.join(['stage', 'cycles', 'median [us]', 'p99 [us]', 'p99.9 [us]', 'max [us]', f'mean >= p{tail_pct} [us]',
+                           f'share >= p{tail_pct} [%]']) + '\n')
+    for stage, lst in [(x, [cycle[x] for cycle in cycles if x in cycle]) for x in stages] + [('traced cycle', totals)]:
+        tail_mean = mean(cycle.get(stage, 0) for cycle in tail_cycles) if stage != 'traced cycle' else tail_total
+        output.write(sep.join([stage, str(len(lst)),
+                               f'{percentile(lst, 50):.3f}',
+                               f'{percentile(lst, 99):.3f}',
+                               f'{percentile(lst, 99.9):.3f}',
+                               f'{max(lst):.3f}',
+                               f'{tail_mean:.3f}',
+                               f'{tail_mean * 100 / tail_total:.1f}' if tail_total > 0 else 'nan']) + '\n')
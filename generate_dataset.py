@@ -0,0 +1,179 @@
+from argparse import ArgumentParser
+from json import load
+from os.path import join, basename
+from re import fullmatch
+
+# built-in types the generated codec can copy in their binary encoding, name: (UA_TYPES index, C type, size, built-in type id)
+FIELD_TYPES = {'Boolean': ('UA_TYPES_BOOLEAN', 'UA_Boolean', 1, 1),
+               'SByte': ('UA_TYPES_SBYTE', 'UA_SByte', 1, 2),
+               'Byte': ('UA_TYPES_BYTE', 'UA_Byte', 1, 3),
+               'Int16': ('UA_TYPES_INT16', 'UA_Int16', 2, 4),
+               'UInt16': ('UA_TYPES_UINT16', 'UA_UInt16', 2, 5),
+               'Int32': ('UA_TYPES_INT32', 'UA_Int32', 4, 6),
+               'UInt32': ('UA_TYPES_UINT32', 'UA_UInt32', 4, 7),
+               'Int64': ('UA_TYPES_INT64', 'UA_Int64', 8, 8),
+               'UInt64': ('UA_TYPES_UINT64', 'UA_UInt64', 8, 9),
+               'Float': ('UA_TYPES_FLOAT', 'UA_Float', 4, 10),
+               'Double': ('UA_TYPES_DOUBLE', 'UA_Double', 8, 11)}
+# the subscriber identifies the messages of its reader by these headers, the others must not add offsets the fast paths do not know
+REQUIRED_CONTENT_MASK = ['PUBLISHERID', 'GROUPHEADER', 'WRITERGROUPID', 'PAYLOADHEADER']
+OPTIONAL_CONTENT_MASK = ['GROUPVERSION', 'NETWORKMESSAGENUMBER', 'SEQUENCENUMBER']
+VARIANT_ARRAY_ENCODING_MASK = 0x80
+# keep in sync with FIELD_NAME_LENGTH in opcua_pubsub.h, the name includes the terminating zero there
+FIELD_NAME_LENGTH = 16
+MAX_ARRAY_LENGTH = 65535
+HEADER_FILE_NAME = 'opcua_dataset.h'
+SOURCE_FILE_NAME = 'opcua_dataset.c'
+
+
+# check the schema and return its fields with their C member names and offsets in the encoded field region
+def read_schema(schema_file_name):
+    with open(schema_file_name) as schema_file:
+        schema = load(schema_file)
+    for key in ['publisherId', 'writerGroupId', 'dataSetWriterId']:
+        if not isinstance(schema.get(key), int) or not 0 < schema[key] <= 0xFFFF:
+            raise ValueError(f'{key} has to be an integer between 1 and 65535')
+    content_mask = schema.get('networkMessageContentMask', [])
+    if any(x not in REQUIRED_CONTENT_MASK + OPTIONAL_CONTENT_MASK for x in content_mask) or \
+            any(x not in content_mask for x in REQUIRED_CONTENT_MASK):
+        raise ValueError(f'networkMessageContentMask has to contain {REQUIRED_CONTENT_MASK} and may contain {OPTIONAL_CONTENT_MASK}')
+    fields = []
+    encoded_offset = 0
+    for field in schema.get('fields', []):
+        name, type_name, array_length = field.get('name', ''), field.get('type'), field.get('arrayLength', 0)
+        if not fullmatch('[A-Za-z][A-Za-z0-9]*', name) or len(name) >= FIELD_NAME_LENGTH:
+            raise ValueError(f'field name "{name}" has to be alphanumeric and shorter than {FIELD_NAME_LENGTH} characters')
+        if type_name not in FIELD_TYPES:
+            raise ValueError(f'field {name} has the unsupported type {type_name}, use one of {list(FIELD_TYPES)}')
+        if not isinstance(array_length, int) or not 0 <= array_length <= MAX_ARRAY_LENGTH:
+            raise ValueError(f'arrayLength of field {name} has to be an integer between 0 and {MAX_ARRAY_LENGTH}')
+        member = name[0].lower() + name[1:]
+        if any(member == x['member'] for x in fields):
+            raise ValueError(f'field name {name} is used twice')
+        header_size = 5 if array_length > 0 else 1
+        fields.append({'name': name, 'type': type_name, 'arrayLength': array_length, 'member': member,
+                       'encodedOffset': encoded_offset, 'headerSize': header_size})
+        encoded_offset += header_size + max(array_length, 1) * FIELD_TYPES[type_name][2]
+    # the measurements use the first field as counter
+    if not fields or fields[0]['type'] != 'UInt64' or fields[0]['arrayLength'] > 0:
+        raise ValueError('the first field has to be the scalar UInt64 counter')
+    return schema, fields, encoded_offset
+
+
+# return the bytes of the encoding mask and the array length in front of the value of a field
+def variant_header(field):
+    encoding_mask = FIELD_TYPES[field['type']][3]
+    if field['arrayLength'] == 0:
+        return [encoding_mask]
+    return [encoding_mask | VARIANT_ARRAY_ENCODING_MASK] + list(field['arrayLength'].to_bytes(4, 'little'))
+
+
+# emit the defines, the value struct and the prototypes shared by publisher and subscriber
+def generate_header(schema, fields, encoded_size, schema_name):
+    content_mask = ' | '.join(f'UA_UADPNETWORKMESSAGECONTENTMASK_{x}' for x in schema['networkMessageContentMask'])
+    members = '\n'.join(f'    {FIELD_TYPES[x["type"]][1]} {x["member"]}' + (f'[{x["arrayLength"]}]' if x['arrayLength'] > 0 else '') + ';'
+                        for x in fields)
+    return f'''// generated by generate_dataset.py from {schema_name}, do not edit
+#pragma once
+
+#define PUBLISHER_ID {schema['publisherId']}
+#define WRITER_GROUP_ID {schema['writerGroupId']}
+#define DATA_SET_WRITER_ID {schema['dataSetWriterId']}
+#define NETWORK_MESSAGE_CONTENT_MASK ((UA_UadpNetworkMessageContentMask) ({content_mask}))
+#define DATASET_FIELDS_SIZE {len(fields)}
+#define DATASET_ENCODED_SIZE {encoded_size}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "the generated codec copies the field values in the byte order of the binary encoding"
+#endif
+
+typedef struct {{
+    const char *name;
+    UA_UInt16 typeIndex;
+    UA_UInt32 arrayLength;
+    size_t valueOffset;
+    size_t encodedValueOffset;
+}} DataSetFieldSchema;
+
+typedef struct {{
+{members}
+}} DataSetValues;
+
+extern const DataSetFieldSchema dataSetSchema[DATASET_FIELDS_SIZE];
+
+void
+encodeDataSetFields(const DataSetValues *values, UA_Byte *encoded);
+
+UA_Boolean
+decodeDataSetFields(const UA_Byte *encoded, DataSetValues *values);
+'''
+
+
+# emit the field table and the straight line encoder and decoder of the encoded field region
+def generate_source(fields, schema_name):
+    table = ',\n'.join(f'        {{"{x["name"]}", {FIELD_TYPES[x["type"]][0]}, {x["arrayLength"]}, offsetof(DataSetValues, {x["member"]}), '
+                       f'{x["encodedOffset"] + x["headerSize"]}}}' for x in fields)
+    encode, check, decode = [], [], []
+    for field in fields:
+        c_type = FIELD_TYPES[field['type']][1]
+        header = variant_header(field)
+        value_offset = field['encodedOffset'] + field['headerSize']
+        elements = max(field['arrayLength'], 1)
+        for index, byte in enumerate(header):
+            encode.append(f'    encoded[{field["encodedOffset"] + index}] = 0x{byte:02X};')
+            check.append(f'    mismatch |= encoded[{field["encodedOffset"] + index}] ^ 0x{byte:02X}U;')
+        if field['type'] == 'Boolean' and field['arrayLength'] > 0:
+            # a boolean is encoded as one byte with any value other than zero being true
+            encode.append(f'    for (size_t i = 0; i < {elements}; i++) {{\n'
+                          f'        encoded[{value_offset} + i] = (UA_Byte) values->{field["member"]}[i];\n    }}')
+            decode.append(f'    for (size_t i = 0; i < {elements}; i++) {{\n'
+                          f'        values->{field["member"]}[i] = encoded[{value_offset} + i] != 0;\n    }}')
+        elif field['type'] == 'Boolean':
+            encode.append(f'    encoded[{value_offset}] = (UA_Byte) values->{field["member"]};')
+            decode.append(f'    values->{field["member"]} = encoded[{value_offset}] != 0;')
+        elif field['arrayLength'] > 0:
+            encode.append(f'    memcpy(&encoded[{value_offset}], values->{field["member"]}, {elements} * sizeof({c_type}));')
+            decode.append(f'    memcpy(values->{field["member"]}, &encoded[{value_offset}], {elements} * sizeof({c_type}));')
+        else:
+            encode.append(f'    memcpy(&encoded[{value_offset}], &values->{field["member"]}, sizeof({c_type}));')
+            decode.append(f'    memcpy(&values->{field["member"]}, &encoded[{value_offset}], sizeof({c_type}));')
+    encode, check, decode = '\n'.join(encode), '\n'.join(check), '\n'.join(decode)
+    return f'''// generated by generate_dataset.py from {schema_name}, do not edit
+#include "opcua_pubsub.h"
+
+const DataSetFieldSchema dataSetSchema[DATASET_FIELDS_SIZE] = {{
+{table}
+}};
+
+void
+encodeDataSetFields(const DataSetValues *values, UA_Byte *encoded) {{
+    // write the variants of all fields to their fixed offsets, the encoding masks and array lengths are constants of the schema
+{encode}
+}}
+
+UA_Boolean
+decodeDataSetFields(const UA_Byte *encoded, DataSetValues *values) {{
+    // copy the values of all fields from their fixed offsets, returns false without branching on the way if an encoding mask
+    // or array length differs from the schema, the values are undefined in that case
+    unsigned int mismatch = 0;
+{check}
+{decode}
+    return mismatch == 0;
+}}
+'''
+
+
+def main():
+    parser = ArgumentParser(description='generate the data set codec and configuration constants of publisher and subscriber from a schema')
+    parser.add_argument('schema', help='json schema of the data set, e.g. src/dataset.json')
+    parser.add_argument('--output-dir', default='./src', help=f'directory {HEADER_FILE_NAME} and {SOURCE_FILE_NAME} are written to')
+    args = parser.parse_args()
+    schema, fields, encoded_size = read_schema(args.schema)
+    with open(join(args.output_dir, HEADER_FILE_NAME), 'w') as header_file:
+        header_file.write(generate_header(schema, fields, encoded_size, basename(args.schema)))
+    with open(join(args.output_dir, SOURCE_FILE_NAME), 'w') as source_file:
+        source_file.write(generate_source(fields, basename(args.schema)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,56 @@
+// generated by generate_dataset.py from dataset.json, do not edit
+#include "opcua_pubsub.h"
+
+const DataSetFieldSchema dataSetSchema[DATASET_FIELDS_SIZE] = {
+        {"Counter", UA_TYPES_UINT64, 0, offsetof(DataSetValues, counter), 1},
+        {"Temperature", UA_TYPES_DOUBLE, 0, offsetof(DataSetValues, temperature), 10},
+        {"Pressure", UA_TYPES_FLOAT, 0, offsetof(DataSetValues, pressure), 19},
+        {"Status", UA_TYPES_UINT32, 0, offsetof(DataSetValues, status), 24},
+        {"Valid", UA_TYPES_BOOLEAN, 0, offsetof(DataSetValues, valid), 29},
+        {"Samples", UA_TYPES_FLOAT, 16, offsetof(DataSetValues, samples), 35}
+};
+
+void
+encodeDataSetFields(const DataSetValues *values, UA_Byte *encoded) {
+    // write the variants of all fields to their fixed offsets, the encoding masks and array lengths are constants of the schema
+    encoded[0] = 0x09;
+    memcpy(&encoded[1], &values->counter, sizeof(UA_UInt64));
+    encoded[9] = 0x0B;
+    memcpy(&encoded[10], &values->temperature, sizeof(UA_Double));
+    encoded[18] = 0x0A;
+    memcpy(&encoded[19], &values->pressure, sizeof(UA_Float));
+    encoded[23] = 0x07;
+    memcpy(&encoded[24], &values->status, sizeof(UA_UInt32));
+    encoded[28] = 0x01;
+    encoded[29] = (UA_Byte) values->valid;
+    encoded[30] = 0x8A;
+    encoded[31] = 0x10;
+    encoded[32] = 0x00;
+    encoded[33] = 0x00;
+    encoded[34] = 0x00;
+    memcpy(&encoded[35], values->samples, 16 * sizeof(UA_Float));
+}
+
+UA_Boolean
+decodeDataSetFields(const UA_Byte *encoded, DataSetValues *values) {
+    // copy the values of all fields from their fixed offsets, returns false without branching on the way if an encoding mask
+    // or array length differs from the schema, the values are undefined in that case
+    unsigned int mismatch = 0;
+    mismatch |= encoded[0] ^ 0x09U;
+    mismatch |= encoded[9] ^ 0x0BU;
+    mismatch |= encoded[18] ^ 0x0AU;
+    mismatch |= encoded[23] ^ 0x07U;
+    mismatch |= encoded[28] ^ 0x01U;
+    mismatch |= encoded[30] ^ 0x8AU;
+    mismatch |= encoded[31] ^ 0x10U;
+    mismatch |= encoded[32] ^ 0x00U;
+    mismatch |= encoded[33] ^ 0x00U;
+    mismatch |= encoded[34] ^ 0x00U;
+    memcpy(&values->counter, &encoded[1], sizeof(UA_UInt64));
+    memcpy(&values->temperature, &encoded[10], sizeof(UA_Double));
+    memcpy(&values->pressure, &encoded[19], sizeof(UA_Float));
+    memcpy(&values->status, &encoded[24], sizeof(UA_UInt32));
+    values->valid = encoded[29] != 0;
+    memcpy(values->samples, &encoded[35], 16 * sizeof(UA_Float));
+    return mismatch == 0;
+}
@@ -0,0 +1,38 @@
+// generated by generate_dataset.py from dataset.json, do not edit
+#pragma once
+
+#define PUBLISHER_ID 1
+#define WRITER_GROUP_ID 1
+#define DATA_SET_WRITER_ID 1
+#define NETWORK_MESSAGE_CONTENT_MASK ((UA_UadpNetworkMessageContentMask) (UA_UADPNETWORKMESSAGECONTENTMASK_PUBLISHERID | UA_UADPNETWORKMESSAGECONTENTMASK_GROUPHEADER | UA_UADPNETWORKMESSAGECONTENTMASK_WRITERGROUPID | UA_UADPNETWORKMESSAGECONTENTMASK_PAYLOADHEADER))
+#define DATASET_FIELDS_SIZE 6
+#define DATASET_ENCODED_SIZE 99
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "the generated codec copies the field values in the byte order of the binary encoding"
+#endif
+
+typedef struct {
+    const char *name;
+    UA_UInt16 typeIndex;
+    UA_UInt32 arrayLength;
+    size_t valueOffset;
+    size_t encodedValueOffset;
+} DataSetFieldSchema;
+
+typedef struct {
+    UA_UInt64 counter;
+    UA_Double temperature;
+    UA_Float pressure;
+    UA_UInt32 status;
+    UA_Boolean valid;
+    UA_Float samples[16];
+} DataSetValues;
+
+extern const DataSetFieldSchema dataSetSchema[DATASET_FIELDS_SIZE];
+
+void
+encodeDataSetFields(const DataSetValues *values, UA_Byte *encoded);
+
+UA_Boolean
+decodeDataSetFields(const UA_Byte *encoded, DataSetValues *values);
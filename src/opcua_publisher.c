@@ -1,85 +1,299 @@
 #include "opcua_pubsub.h"
 
+typedef struct {
+    DataSetLayout *layout;
+    UA_DataValue **staticValueSources;
+    void **values;
+    DataSetValues *generatedValues;
+} PublishedFields;
+
+typedef enum {
+    CYCLE_JITTER_HISTOGRAM,
+    PUBLISH_INTERVAL_HISTOGRAM,
+    CYCLE_OVERRUN_HISTOGRAM,
+    WAKE_UP_LATENCY_HISTOGRAM,
+    SPIN_TIME_HISTOGRAM,
+    DEADLINE_ERROR_HISTOGRAM,
+    PUBLISH_HISTOGRAMS
+} PublishHistogram;
+
+typedef struct {
+    UA_UInt64 value;
+    UA_UInt64 timestamp;
+} EchoSlot;
+
+typedef struct {
+    UA_PubSubChannel *channel;
+    SourceKey key;
+    EchoSlot sent[ECHO_WINDOW];
+    UA_ByteString message;
+    Histogram *histogram;
+    LogRing receivedRecords;
+    UA_Boolean running;
+    UA_UInt64 unmatchedEchoes;
+    pthread_t echoThread;
+    pthread_t logWriterThread;
+} EchoReader;
+
+typedef struct {
+    PublishedFields fields;
+    ChannelSendContext sendContext;
+    XdpSocket xdp;
+    SecureChannel secure;
+    FastPublisher fastPublisher;
+    UA_WriterGroup *writerGroup;
+    int sockfd;
+    int cpu;
+    UA_Boolean ownsConnection;
+    UA_UInt64 period_ns;
+    UA_UInt64 phase_ns;
+    UA_UInt64 missedLaunchTimes;
+    SpinWaiter spinWaiter;
+    EchoReader *echo;
+    CooperativeServer *cooperative;
+    LogRecord sentWindow[TX_TIMESTAMP_WINDOW];
+    LogRecord batchRecords[MAX_BATCH_SIZE];
+    Histogram *histograms;
+    char histogramNames[PUBLISH_HISTOGRAMS][NODE_NAME_LENGTH];
+    char logFileName[NODE_NAME_LENGTH];
+    TraceBuffer trace;
+    char traceFileName[NODE_NAME_LENGTH];
+    LogRing sentRecords;
+    pthread_t publishThread;
+    pthread_t logWriterThread;
+} Publisher;
+
+typedef struct {
+    UA_UInt64 offset_ns;
+    UA_Byte groups[MAX_SCHEDULED_GROUPS];
+    UA_Byte groupsSize;
+} ScheduleEvent;
+
+typedef struct {
+    Publisher *publishers;
+    size_t publishersSize;
+    ScheduleEvent *events;
+    size_t eventsSize;
+    UA_UInt64 hyperperiod_ns;
+} Schedule;
+
 static void
-addPublishedDataSet(UA_Server *server, UA_NodeId *publishedDataSetIdent) {
-    // add a published data set to the server
-    UA_PublishedDataSetConfig publishedDataSetConfig;
-    memset(&publishedDataSetConfig, 0, sizeof(UA_PublishedDataSetConfig));
-    publishedDataSetConfig.publishedDataSetType = UA_PUBSUB_DATASET_PUBLISHEDITEMS;
-    publishedDataSetConfig.name = UA_STRING("PublishedDataSetConfig");
-    if (UA_Server_addPublishedDataSet(server, &publishedDataSetConfig, publishedDataSetIdent).addResult != UA_STATUSCODE_GOOD) {
-        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_addPublishedDataSet failed");
+createPublishedFields(PublishedFields *publishedFields, DataSetLayout *layout) {
+    // allocate the static value sources and the memory of all fields, arrays keep their length for the whole run, the fields
+    // of the generated layout live in one struct the generated encoder reads
+    publishedFields->layout = layout;
+    publishedFields->generatedValues = layout->generated ? (DataSetValues *) UA_calloc(1, sizeof(DataSetValues)) : NULL;
+    publishedFields->staticValueSources = (UA_DataValue **) UA_calloc(layout->fieldsSize, sizeof(UA_DataValue *));
+    publishedFields->values = (void **) UA_calloc(layout->fieldsSize, sizeof(void *));
+    if (!publishedFields->staticValueSources || !publishedFields->values || (layout->generated && !publishedFields->generatedValues)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_calloc failed");
         exit(EXIT_FAILURE);
     }
+    for (size_t i = 0; i < layout->fieldsSize; i++) {
+        const UA_DataType *type = &UA_TYPES[layout->fields[i].typeIndex];
+        UA_UInt32 elements = layout->fields[i].arrayLength > 0 ? layout->fields[i].arrayLength : 1;
+        publishedFields->staticValueSources[i] = UA_DataValue_new();
+        if (layout->generated) {
+            publishedFields->values[i] = (UA_Byte *) publishedFields->generatedValues + dataSetSchema[i].valueOffset;
+        } else {
+            publishedFields->values[i] = UA_calloc(elements, type->memSize);
+        }
+        if (!publishedFields->staticValueSources[i] || !publishedFields->values[i]) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_calloc failed");
+            exit(EXIT_FAILURE);
+        }
+        if (layout->fields[i].arrayLength > 0) {
+            UA_Variant_setArray(&publishedFields->staticValueSources[i]->value, publishedFields->values[i], elements, type);
+        } else {
+            UA_Variant_setScalar(&publishedFields->staticValueSources[i]->value, publishedFields->values[i], type);
+        }
+    }
+    *(UA_UInt64 *) publishedFields->values[0] = VARIABLE_START_VALUE;
 }
 
 static void
-addDataSetFields(UA_Server *server, UA_DataValue **staticValueSource, UA_NodeId publishedDataSetIdent, UA_UInt64 *publishValue) {
-    // create a basic configuration of a field in a PublishedDataSet and then add the published not to the data set
-    UA_NodeId dataSetFieldIdent;
-    *publishValue = VARIABLE_START_VALUE;
-    UA_Variant_setScalar(&(*staticValueSource)->value, publishValue, &UA_TYPES[UA_TYPES_UINT64]);
-    UA_DataSetFieldConfig dataSetFieldConfig;
-    memset(&dataSetFieldConfig, 0, sizeof(UA_DataSetFieldConfig));
-    dataSetFieldConfig.field.variable.rtValueSource.rtFieldSourceEnabled = UA_TRUE;
-    dataSetFieldConfig.field.variable.rtValueSource.staticValueSource = staticValueSource;
-    if (UA_Server_addDataSetField(server, publishedDataSetIdent, &dataSetFieldConfig, &dataSetFieldIdent).result != UA_STATUSCODE_GOOD) {
-        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_addDataSetField failed");
-        exit(EXIT_FAILURE);
+deletePublishedFields(PublishedFields *publishedFields) {
+    // free the memory of all fields, the variants do not own their data
+    for (size_t i = 0; i < publishedFields->layout->fieldsSize; i++) {
+        if (!publishedFields->layout->generated) {
+            UA_free(publishedFields->values[i]);
+        }
+        UA_free(publishedFields->staticValueSources[i]);
     }
+    UA_free(publishedFields->generatedValues);
+    UA_free(publishedFields->values);
+    UA_free(publishedFields->staticValueSources);
 }
 
 static void
-addWriterGroup(UA_Server *server, UA_UInt64 cycle_time_ns, UA_NodeId connectionIdent, UA_NodeId *writerGroupIdent) {
-    // add a writer group to the pubsub connection
-    UA_WriterGroupConfig writerGroupConfig;
-    memset(&writerGroupConfig, 0, sizeof(UA_WriterGroupConfig));
-    writerGroupConfig.name = UA_STRING("WriterGroupConfig");
-    writerGroupConfig.publishingInterval = cycle_time_ns / 1000000.0;
-    writerGroupConfig.enabled = UA_FALSE;
-    writerGroupConfig.writerGroupId = WRITER_GROUP_ID;
-    writerGroupConfig.rtLevel = UA_PUBSUB_RT_FIXED_SIZE;
-    writerGroupConfig.encodingMimeType = UA_PUBSUB_ENCODING_UADP;
-    writerGroupConfig.messageSettings.encoding = UA_EXTENSIONOBJECT_DECODED;
-    writerGroupConfig.messageSettings.content.decoded.type = &UA_TYPES[UA_TYPES_UADPWRITERGROUPMESSAGEDATATYPE];
-    UA_UadpWriterGroupMessageDataType *writerGroupMessage = UA_UadpWriterGroupMessageDataType_new();
-    if (!writerGroupMessage) {
-        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_UadpWriterGroupMessageDataType_new failed");
-        exit(EXIT_FAILURE);
+updateFieldValues(PublishedFields *publishedFields, UA_UInt64 counter) {
+    // derive the values of all fields after the counter from the counter, replace this with real sensor sources, the fields of a
+    // batch are filled sample by sample by the publish loop
+    size_t fieldsSize = publishedFields->layout->fieldsSize - (publishedFields->layout->batchSize > 0 ? BATCH_FIELDS : 0);
+    for (size_t i = 1; i < fieldsSize; i++) {
+        DataSetFieldLayout *field = &publishedFields->layout->fields[i];
+        void *value = publishedFields->values[i];
+        UA_UInt32 elements = field->arrayLength > 0 ? field->arrayLength : 1;
+        for (UA_UInt32 j = 0; j < elements; j++) {
+            setDerivedSample(field->typeIndex, value, j, counter + i + j);
+        }
     }
-    writerGroupMessage->networkMessageContentMask = (UA_UadpNetworkMessageContentMask) UA_UADPNETWORKMESSAGECONTENTMASK_PUBLISHERID |
-                                                    (UA_UadpNetworkMessageContentMask) UA_UADPNETWORKMESSAGECONTENTMASK_GROUPHEADER |
-                                                    (UA_UadpNetworkMessageContentMask) UA_UADPNETWORKMESSAGECONTENTMASK_WRITERGROUPID |
-                                                    (UA_UadpNetworkMessageContentMask) UA_UADPNETWORKMESSAGECONTENTMASK_PAYLOADHEADER;
-    writerGroupConfig.messageSettings.content.decoded.data = writerGroupMessage;
-    if (UA_Server_addWriterGroup(server, connectionIdent, &writerGroupConfig, writerGroupIdent) != UA_STATUSCODE_GOOD) {
-        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_addWriterGroup failed");
-        exit(EXIT_FAILURE);
+}
+
+static void
+addDataSetFields(UA_Server *server, PublishedFields *publishedFields, UA_NodeId publishedDataSetIdent) {
+    // add the published fields to the data set
+    for (size_t i = 0; i < publishedFields->layout->fieldsSize; i++) {
+        addStaticDataSetField(server, publishedDataSetIdent, publishedFields->layout->fields[i].name, &publishedFields->staticValueSources[i]);
     }
-    UA_UadpWriterGroupMessageDataType_delete(writerGroupMessage);
 }
 
 static void
-addDataSetWriter(UA_Server *server, UA_NodeId writerGroupIdent, UA_NodeId publishedDataSetIdent) {
-    // add a data set writer to the writer group and create a link to the published data set
-    UA_NodeId dataSetWriterIdent;
-    UA_DataSetWriterConfig dataSetWriterConfig;
-    memset(&dataSetWriterConfig, 0, sizeof(UA_DataSetWriterConfig));
-    dataSetWriterConfig.name = UA_STRING("DataSetWriterConfig");
-    dataSetWriterConfig.dataSetWriterId = DATA_SET_WRITER_ID;
-    dataSetWriterConfig.keyFrameCount = 1;
-    if (UA_Server_addDataSetWriter(server, writerGroupIdent, publishedDataSetIdent, &dataSetWriterConfig, &dataSetWriterIdent) != UA_STATUSCODE_GOOD) {
-        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_addDataSetWriter failed");
-        exit(EXIT_FAILURE);
+benchmarkPublish(UA_Server *server, UA_WriterGroup *writerGroup, FastPublisher *fastPublisher, UA_UInt64 publishes) {
+    // compare the cpu cycles, instructions and time per publish of the framework call and the fast path, every publish sends its frame
+    static const char *pathNames[] = {"framework publish", "fast publish"};
+    PerfCounters counters;
+    UA_Boolean countersAvailable = openPerfCounters(&counters);
+    if (!countersAvailable) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "hardware perf counters not available: %s, only the time is measured", strerror(errno));
     }
-    if (UA_Server_freezeWriterGroupConfiguration(server, writerGroupIdent) != UA_STATUSCODE_GOOD) {
-        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_freezeWriterGroupConfiguration failed");
-        exit(EXIT_FAILURE);
+    for (size_t path = 0; path < sizeof(pathNames) / sizeof(pathNames[0]); path++) {
+        UA_UInt64 cycles = 0, instructions = 0, startTimestamp = 0;
+        // the first pass only warms up the caches and branch predictors
+        for (int pass = 0; pass < 2; pass++) {
+            startTimestamp = getCurrentTimestamp();
+            if (countersAvailable) {
+                startPerfCounters(&counters);
+            }
+            for (UA_UInt64 i = 0; i < publishes; i++) {
+                if (path == 0) {
+                    UA_WriterGroup_publishCallback(server, writerGroup);
+                } else {
+                    fastPublish(fastPublisher);
+                }
+            }
+            if (countersAvailable) {
+                stopPerfCounters(&counters, &cycles, &instructions);
+            }
+        }
+        UA_UInt64 duration = getCurrentTimestamp() - startTimestamp;
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "%s: %.1f cycles, %.1f instructions in user space, %.1f ns per publish",
+                    pathNames[path], (UA_Double) cycles / (UA_Double) publishes, (UA_Double) instructions / (UA_Double) publishes,
+                    (UA_Double) duration / (UA_Double) publishes);
     }
-    if (UA_Server_setWriterGroupOperational(server, writerGroupIdent) != UA_STATUSCODE_GOOD) {
-        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_setWriterGroupOperational failed");
-        exit(EXIT_FAILURE);
+    if (countersAvailable) {
+        closePerfCounters(&counters);
+    }
+}
+
+static void
+recordSpinWakeUp(Histogram *histograms, SpinWaiter *waiter) {
+    // the wake up latency is measured from the early wake up, the deadline error is the time the spin overshot the event
+    if (waiter == NULL) {
+        return;
+    }
+    recordHistogramValue(&histograms[WAKE_UP_LATENCY_HISTOGRAM], waiter->wakeUpLatency_ns);
+    recordHistogramValue(&histograms[SPIN_TIME_HISTOGRAM], waiter->spinTime_ns);
+    recordHistogramValue(&histograms[DEADLINE_ERROR_HISTOGRAM], waiter->deadlineError_ns);
+}
+
+static void
+reportSpinWakeUp(Histogram *histograms, SpinWaiter *waiter) {
+    // log the offset the spin wake up settled on and how long the thread spun for it
+    Histogram *spinTime = &histograms[SPIN_TIME_HISTOGRAM];
+    if (waiter == NULL || spinTime->count == 0) {
+        return;
+    }
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "spin wake up: final offset %llu ns, mean spin time %llu ns, max deadline error %llu ns",
+                (unsigned long long) waiter->offset_ns, (unsigned long long) (spinTime->sum / spinTime->count),
+                (unsigned long long) histograms[DEADLINE_ERROR_HISTOGRAM].max);
+}
+
+static void
+recordEchoSend(EchoReader *echo, UA_UInt64 value, UA_UInt64 timestamp) {
+    // keep the send time of the value for the echo thread, the slot is reused ECHO_WINDOW values later and reads as value 0 while its
+    // timestamp is replaced, so the echo thread only takes a timestamp it saw the same value before and after
+    EchoSlot *slot = &echo->sent[value & (ECHO_WINDOW - 1)];
+    __atomic_store_n(&slot->value, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&slot->timestamp, timestamp, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->value, value, __ATOMIC_RELEASE);
+}
+
+static UA_Boolean
+findEchoSend(EchoReader *echo, UA_UInt64 value, UA_UInt64 *timestamp) {
+    // look up the send time of an echoed value, returns false if the value already left the window or was never sent
+    EchoSlot *slot = &echo->sent[value & (ECHO_WINDOW - 1)];
+    UA_UInt64 before = __atomic_load_n(&slot->value, __ATOMIC_ACQUIRE);
+    *timestamp = __atomic_load_n(&slot->timestamp, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return before == value && __atomic_load_n(&slot->value, __ATOMIC_RELAXED) == value;
+}
+
+static UA_Boolean
+decodeEcho(EchoReader *echo, UA_UInt64 *value) {
+    // decode an echo of the subscriber and return the counter it carries, anything else on the echo address is ignored
+    UA_NetworkMessage networkMessage;
+    size_t offset = 0;
+    UA_Boolean decoded = false;
+    memset(&networkMessage, 0, sizeof(UA_NetworkMessage));
+    if (UA_NetworkMessage_decodeBinary(&echo->message, &offset, &networkMessage) == UA_STATUSCODE_GOOD && networkMessage.groupHeaderEnabled &&
+        networkMessage.groupHeader.writerGroupId == echo->key.writerGroupId && networkMessage.payloadHeaderEnabled &&
+        networkMessage.payloadHeader.dataSetPayloadHeader.count == 1 &&
+        networkMessage.payloadHeader.dataSetPayloadHeader.dataSetWriterIds[0] == echo->key.dataSetWriterId) {
+        UA_DataSetMessage *dataSetMessage = &networkMessage.payload.dataSetPayload.dataSetMessages[0];
+        UA_DataValue *field = dataSetMessage->data.keyFrameData.dataSetFields;
+        if (dataSetMessage->header.dataSetMessageType == UA_DATASETMESSAGE_DATAKEYFRAME && dataSetMessage->data.keyFrameData.fieldCount == 1 &&
+            field->hasValue && field->value.type == &UA_TYPES[UA_TYPES_UINT64] && UA_Variant_isScalar(&field->value)) {
+            *value = *(UA_UInt64 *) field->value.data;
+            decoded = true;
+        }
+    }
+    UA_NetworkMessage_clear(&networkMessage);
+    return decoded;
+}
+
+static void *
+echoReceiveLoop(void *args) {
+    // receive the echoes of the subscriber and log the round trip of every value, the send and the arrival are both taken from the
+    // clock of this host, so the round trip holds without any clock synchronization between publisher and subscriber
+    ThreadArguments *arguments = (ThreadArguments *) args;
+    EchoReader *echo = arguments->variable;
+    LogRing *ring = arguments->ring;
+    UA_UInt64 measurements = arguments->measurements;
+    UA_UInt64 lastWarmupValue = VARIABLE_START_VALUE + arguments->options->warmupCycles;
+    if (arguments->options->lockMemory) {
+        prefaultStack();
+    }
+    UA_free(arguments);
+    UA_UInt64 writeIndex = 0;
+    while (__atomic_load_n(&echo->running, __ATOMIC_RELAXED) && (measurements == 0 || writeIndex < measurements)) {
+        UA_UInt64 value, sentTimestamp;
+        echo->message.length = RECEIVE_BUFFER_SIZE;
+        if (echo->channel->receive(echo->channel, &echo->message, NULL, RECEIVE_TIMEOUT_US) != UA_STATUSCODE_GOOD || echo->message.length == 0) {
+            continue;
+        }
+        UA_UInt64 arrivalTimestamp = getCurrentTimestamp();
+        if (!decodeEcho(echo, &value) || value <= lastWarmupValue) {
+            continue;
+        }
+        if (!findEchoSend(echo, value, &sentTimestamp)) {
+            echo->unmatchedEchoes++;
+            continue;
+        }
+        LogRecord echoRecord = {value, arrivalTimestamp, getCurrentTimestamp(), 0, 0, 0, sentTimestamp, 0, 0, 0};
+        pushLogRecord(ring, &echoRecord);
+        recordHistogramValue(echo->histogram, arrivalTimestamp - sentTimestamp);
+        writeIndex++;
     }
+    Histogram *roundTrip = echo->histogram;
+    if (roundTrip->count > 0) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "echo thread: %llu round trips, min %llu ns, mean %llu ns, max %llu ns, %llu echoes "
+                                                          "without a send in the window", (unsigned long long) roundTrip->count,
+                    (unsigned long long) roundTrip->min, (unsigned long long) (roundTrip->sum / roundTrip->count),
+                    (unsigned long long) roundTrip->max, (unsigned long long) echo->unmatchedEchoes);
+    }
+    return NULL;
 }
 
 static void *
@@ -89,67 +303,738 @@ customPublishLoop(void *args) {
     UA_Server *server = arguments->server;
     UA_WriterGroup *writerGroup = arguments->data;
     UA_UInt64 cycle_time_ns = arguments->cycle_time_ns;
-    UA_UInt64 *publishValue = arguments->variable;
-    UA_UInt64 *sentValues = arguments->values;
-    UA_UInt64 *sentTimestamps = arguments->timestamps;
+    Publisher *publisher = arguments->variable;
+    PublishedFields *publishedFields = &publisher->fields;
+    UA_UInt64 *publishValue = publishedFields->values[0];
+    LogRecord *sentWindow = publisher->sentWindow;
+    Histogram *histograms = publisher->histograms;
+    LogRing *ring = arguments->ring;
     UA_UInt64 measurements = arguments->measurements;
     UA_Boolean *running = arguments->running;
+    UA_UInt64 txtimeOffset_ns = arguments->options->txtimeOffset_ns;
+    UA_Boolean useErrorQueue = txtimeOffset_ns > 0 || arguments->options->txTimestamps;
+    UA_UInt64 warmupCycles = arguments->options->warmupCycles;
+    UA_UInt64 publishBenchmarkCycles = arguments->options->publishBenchmarkCycles;
+    FastPublisher *fastPublisher = arguments->options->fastPublish ? &publisher->fastPublisher : NULL;
+    SpinWaiter *spinWaiter = arguments->options->spinWakeup ? &publisher->spinWaiter : NULL;
+    OverrunPolicy overrunPolicy = arguments->options->overrunPolicy;
+    EchoReader *echo = publisher->echo;
+    CooperativeServer *cooperative = publisher->cooperative;
+    SecureChannel *secure = arguments->options->securityMode != SECURITY_MODE_NONE && publisher->ownsConnection ? &publisher->secure : NULL;
+    // the thread wakes up its phase after the cycle boundary, or the txtime offset before that if the frame is scheduled
+    UA_UInt64 wakeUpOffset_ns = (txtimeOffset_ns + cycle_time_ns - publisher->phase_ns) % cycle_time_ns;
+    int sockfd = arguments->sockfd;
+    if (arguments->options->lockMemory) {
+        prefaultStack();
+    }
     UA_free(arguments);
+    if (publishBenchmarkCycles > 0) {
+        // the benchmark replaces the measurement and runs on the rt core
+        benchmarkPublish(server, writerGroup, &publisher->fastPublisher, publishBenchmarkCycles);
+        *running = false;
+        return NULL;
+    }
+    UA_UInt64 sentFrames = 0;
     UA_UInt64 writeIndex = 0;
+    UA_UInt64 previousTimestamp = 0;
+    UA_UInt64 measurementMinorFaults = 0, measurementMajorFaults = 0;
+    CycleAccount account;
+    initCycleAccount(&account, overrunPolicy, wakeUpOffset_ns, cycle_time_ns);
     while (*running) {
+        TRACE_BEGIN(&publisher->trace);
         *publishValue = *publishValue + 1;
-        sentValues[writeIndex] = *publishValue;
-        waitUntilNextEvent(0, cycle_time_ns);
-        sentTimestamps[writeIndex] = getCurrentTimestamp();
+        updateFieldValues(publishedFields, *publishValue);
+        if (useErrorQueue) {
+            // collect the tx timestamps and launch time errors of the previous frames in the slack time before the next cycle
+            publisher->missedLaunchTimes += drainErrorQueue(sockfd, sentWindow, sentFrames);
+        }
+        if (sentFrames == warmupCycles) {
+            // the warm up cycles went through all code paths of the publisher, from now on records are logged
+            getThreadPageFaults(&measurementMinorFaults, &measurementMajorFaults);
+        }
+        // the oldest record leaves the window of records that can still receive their tx timestamp
+        LogRecord *sentRecord = &sentWindow[sentFrames % TX_TIMESTAMP_WINDOW];
+        if (sentFrames >= warmupCycles + TX_TIMESTAMP_WINDOW) {
+            pushLogRecord(ring, sentRecord);
+        }
+        memset(sentRecord, 0, sizeof(LogRecord));
+        sentRecord->value = *publishValue;
+        sentRecord->cycle = account.cycle;
+        UA_UInt64 deadline = getCycleDeadline(&account);
+        TRACE_STAGE_AT(PUBLISH_TRACE_DEADLINE, deadline);
+        UA_UInt64 wakeUpTime = waitUntilTimestamp(spinWaiter, deadline);
+        sentRecord->timestamp = getCurrentTimestamp();
+        TRACE_STAGE(PUBLISH_TRACE_WAKE_UP);
+        if (txtimeOffset_ns > 0) {
+            // the frame is prepared now and leaves the qdisc exactly at the cycle boundary
+            publisher->sendContext.launchTime = wakeUpTime + txtimeOffset_ns;
+            sentRecord->scheduledTimestamp = publisher->sendContext.launchTime;
+        }
+        if (echo != NULL) {
+            // the send time is kept before the frame leaves, an echo may arrive before the publish returns
+            recordEchoSend(echo, *publishValue, txtimeOffset_ns > 0 ? sentRecord->scheduledTimestamp : sentRecord->timestamp);
+        }
+        TRACE_STAGE(PUBLISH_TRACE_PREPARED);
+        if (fastPublisher != NULL) {
+            fastPublish(fastPublisher);
+        } else {
+            UA_WriterGroup_publishCallback(server, writerGroup);
+        }
+        sentRecord->processedTimestamp = getCurrentTimestamp();
+        TRACE_STAGE(PUBLISH_TRACE_PUBLISHED);
+        UA_UInt64 overrun_ns = finishCycle(&account, sentRecord->processedTimestamp);
+        sentFrames++;
+        if (secure != NULL) {
+            // the keystreams of the next frames are ready before their cycles start
+            precomputeKeystreams(secure);
+        }
+        if (cooperative != NULL) {
+            // the server works in the slack until the wake up of the next cycle, also during the warm up
+            runCooperativeServer(cooperative, getCycleDeadline(&account) - (spinWaiter != NULL ? spinWaiter->offset_ns : 0));
+        }
+        if (sentFrames <= warmupCycles) {
+            continue;
+        }
+        TRACE_END(sentRecord->cycle, sentRecord->value);
+        // the wake up latency is the cycle jitter, an overrun is the time the publish took beyond the next cycle boundary
+        recordHistogramValue(&histograms[CYCLE_JITTER_HISTOGRAM], sentRecord->timestamp > wakeUpTime ? sentRecord->timestamp - wakeUpTime : 0);
+        recordSpinWakeUp(histograms, spinWaiter);
+        if (writeIndex > 0) {
+            recordHistogramValue(&histograms[PUBLISH_INTERVAL_HISTOGRAM], sentRecord->timestamp - previousTimestamp);
+        }
+        if (overrun_ns > 0) {
+            recordHistogramValue(&histograms[CYCLE_OVERRUN_HISTOGRAM], overrun_ns);
+        }
+        previousTimestamp = sentRecord->timestamp;
         writeIndex++;
-        UA_WriterGroup_publishCallback(server, writerGroup);
         if (writeIndex == measurements) {
-            *running = false;
+            // the other publish threads finish their own measurements
+            break;
         }
     }
+    if (useErrorQueue) {
+        // give the last frame one cycle to leave the host before its tx timestamp is collected
+        waitUntilNextEvent(NULL, 0, cycle_time_ns);
+        publisher->missedLaunchTimes += drainErrorQueue(sockfd, sentWindow, sentFrames);
+    }
+    for (UA_UInt64 i = sentFrames - (writeIndex < TX_TIMESTAMP_WINDOW ? writeIndex : TX_TIMESTAMP_WINDOW); i < sentFrames; i++) {
+        pushLogRecord(ring, &sentWindow[i % TX_TIMESTAMP_WINDOW]);
+    }
+    reportThreadPageFaults("publish thread", measurementMinorFaults, measurementMajorFaults);
+    reportCycleAccount(&account, "publish thread");
+    reportSpinWakeUp(histograms, spinWaiter);
     return NULL;
 }
 
-static int
-run(UA_String *transportProfile, UA_NetworkAddressUrlDataType *networkAddressUrl, int port, UA_UInt64 cycle_time_ns, UA_UInt64 measurements) {
-    // start the server and publish the field
-    signal(SIGINT, signalHandler);
-    signal(SIGTERM, signalHandler);
-    UA_Server *server = createServer(port);
-    UA_NodeId connectionIdent, publishedDataSetIdent, writerGroupIdent;
-    pthread_t publishThread, serverThread;
-    UA_UInt64 *sentValues, *sentTimestamps;
-    UA_DataValue *staticValueSource = UA_DataValue_new();
-    UA_UInt64 *publishValue = UA_UInt64_new();
-    addPubSubConnection(server, transportProfile, networkAddressUrl, &connectionIdent);
-    setupSocket(server->pubSubManager.connections.tqh_first->channel->sockfd);
+static void *
+batchPublishLoop(void *args) {
+    // this is the function responsible for publishing batches, every cycle takes one timestamped sample into the batch fields and
+    // every batch size cycles all samples of the batch leave in one network message
+    ThreadArguments *arguments = (ThreadArguments *) args;
+    UA_Server *server = arguments->server;
+    UA_WriterGroup *writerGroup = arguments->data;
+    UA_UInt64 cycle_time_ns = arguments->cycle_time_ns;
+    Publisher *publisher = arguments->variable;
+    PublishedFields *publishedFields = &publisher->fields;
+    size_t fieldsSize = publishedFields->layout->fieldsSize;
+    UA_UInt64 *publishValue = publishedFields->values[0];
+    UA_UInt64 *sampleValues = publishedFields->values[fieldsSize - BATCH_FIELDS];
+    UA_UInt64 *sampleTimes = publishedFields->values[fieldsSize - BATCH_FIELDS + 1];
+    UA_UInt32 batchSize = publishedFields->layout->batchSize;
+    LogRecord *batchRecords = publisher->batchRecords;
+    Histogram *histograms = publisher->histograms;
+    LogRing *ring = arguments->ring;
+    UA_UInt64 measurements = arguments->measurements;
+    UA_Boolean *running = arguments->running;
+    UA_UInt64 lastWarmupValue = VARIABLE_START_VALUE + arguments->options->warmupCycles;
+    FastPublisher *fastPublisher = arguments->options->fastPublish ? &publisher->fastPublisher : NULL;
+    SpinWaiter *spinWaiter = arguments->options->spinWakeup ? &publisher->spinWaiter : NULL;
+    OverrunPolicy overrunPolicy = arguments->options->overrunPolicy;
+    UA_UInt64 wakeUpOffset_ns = (cycle_time_ns - publisher->phase_ns) % cycle_time_ns;
+    if (arguments->options->lockMemory) {
+        prefaultStack();
+    }
+    UA_free(arguments);
+    UA_UInt64 sample = VARIABLE_START_VALUE;
+    UA_UInt32 batchIndex = 0;
+    UA_UInt64 writeIndex = 0;
+    UA_UInt64 sentBatches = 0;
+    UA_UInt64 previousTimestamp = 0;
+    UA_UInt64 measurementMinorFaults = 0, measurementMajorFaults = 0;
+    CycleAccount account;
+    initCycleAccount(&account, overrunPolicy, wakeUpOffset_ns, cycle_time_ns);
+    while (*running) {
+        UA_UInt64 sampleCycle = account.cycle;
+        UA_UInt64 wakeUpTime = waitUntilTimestamp(spinWaiter, getCycleDeadline(&account));
+        UA_UInt64 sampleTimestamp = getCurrentTimestamp();
+        // the counter is the data source of the batch, replace this with a real sensor source
+        sample++;
+        sampleValues[batchIndex] = sample;
+        sampleTimes[batchIndex] = sampleTimestamp;
+        memset(&batchRecords[batchIndex], 0, sizeof(LogRecord));
+        batchRecords[batchIndex].value = sample;
+        batchRecords[batchIndex].timestamp = sampleTimestamp;
+        batchRecords[batchIndex].sampleTimestamp = sampleTimestamp;
+        batchRecords[batchIndex].cycle = sampleCycle;
+        if (sample == lastWarmupValue + 1) {
+            // the warm up samples went through all code paths of the publisher, from now on records are logged
+            getThreadPageFaults(&measurementMinorFaults, &measurementMajorFaults);
+        }
+        if (sample > lastWarmupValue) {
+            recordHistogramValue(&histograms[CYCLE_JITTER_HISTOGRAM], sampleTimestamp > wakeUpTime ? sampleTimestamp - wakeUpTime : 0);
+            recordSpinWakeUp(histograms, spinWaiter);
+        }
+        if (++batchIndex < batchSize) {
+            finishCycle(&account, getCurrentTimestamp());
+            continue;
+        }
+        batchIndex = 0;
+        *publishValue = sample;
+        updateFieldValues(publishedFields, *publishValue);
+        if (fastPublisher != NULL) {
+            fastPublish(fastPublisher);
+        } else {
+            UA_WriterGroup_publishCallback(server, writerGroup);
+        }
+        UA_UInt64 sentTimestamp = getCurrentTimestamp();
+        UA_UInt64 overrun_ns = finishCycle(&account, sentTimestamp);
+        // every sample of the batch waited for the send of the last one
+        for (UA_UInt32 i = 0; i < batchSize && (measurements == 0 || writeIndex < measurements); i++) {
+            if (batchRecords[i].value <= lastWarmupValue) {
+                continue;
+            }
+            batchRecords[i].processedTimestamp = sentTimestamp;
+            pushLogRecord(ring, &batchRecords[i]);
+            writeIndex++;
+        }
+        if (sample <= lastWarmupValue) {
+            continue;
+        }
+        if (sentBatches > 0) {
+            recordHistogramValue(&histograms[PUBLISH_INTERVAL_HISTOGRAM], sentTimestamp - previousTimestamp);
+        }
+        if (overrun_ns > 0) {
+            recordHistogramValue(&histograms[CYCLE_OVERRUN_HISTOGRAM], overrun_ns);
+        }
+        previousTimestamp = sentTimestamp;
+        sentBatches++;
+        if (measurements > 0 && writeIndex == measurements) {
+            break;
+        }
+    }
+    reportThreadPageFaults("publish thread", measurementMinorFaults, measurementMajorFaults);
+    reportCycleAccount(&account, "publish thread");
+    reportSpinWakeUp(histograms, spinWaiter);
+    return NULL;
+}
+
+static void
+createSchedule(Schedule *schedule, Publisher *publishers, size_t publishersSize) {
+    // build the table of all publish events of one hyperperiod, the least common multiple of the periods, every event lists the groups
+    // due at its offset with the shortest period first so that a slow group never delays a faster one
+    size_t order[MAX_SCHEDULED_GROUPS];
+    UA_UInt64 eventsSize = 0;
+    schedule->publishers = publishers;
+    schedule->publishersSize = publishersSize;
+    schedule->hyperperiod_ns = 1;
+    for (size_t i = 0; i < publishersSize; i++) {
+        UA_UInt64 a = schedule->hyperperiod_ns, b = publishers[i].period_ns;
+        while (b != 0) {
+            UA_UInt64 remainder = a % b;
+            a = b;
+            b = remainder;
+        }
+        if (schedule->hyperperiod_ns / a > UINT64_MAX / publishers[i].period_ns) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the hyperperiod of the writer groups overflows");
+            exit(EXIT_FAILURE);
+        }
+        schedule->hyperperiod_ns = schedule->hyperperiod_ns / a * publishers[i].period_ns;
+    }
+    for (size_t i = 0; i < publishersSize; i++) {
+        eventsSize += schedule->hyperperiod_ns / publishers[i].period_ns;
+        size_t j = i;
+        for (; j > 0 && publishers[order[j - 1]].period_ns > publishers[i].period_ns; j--) {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+    }
+    if (eventsSize > MAX_SCHEDULE_EVENTS) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the hyperperiod of %llu ns has %llu publishes, at most %d fit into the schedule table",
+                    (unsigned long long) schedule->hyperperiod_ns, (unsigned long long) eventsSize, MAX_SCHEDULE_EVENTS);
+        exit(EXIT_FAILURE);
+    }
+    schedule->events = (ScheduleEvent *) UA_calloc(eventsSize, sizeof(ScheduleEvent));
+    if (!schedule->events) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_calloc failed");
+        exit(EXIT_FAILURE);
+    }
+    // merge the release times of all groups in ascending order, groups released at the same offset share one event
+    UA_UInt64 nextRelease[MAX_SCHEDULED_GROUPS];
+    for (size_t i = 0; i < publishersSize; i++) {
+        nextRelease[i] = publishers[i].phase_ns;
+    }
+    schedule->eventsSize = 0;
+    while (true) {
+        UA_UInt64 offset = UINT64_MAX;
+        for (size_t i = 0; i < publishersSize; i++) {
+            offset = nextRelease[i] < offset ? nextRelease[i] : offset;
+        }
+        if (offset >= schedule->hyperperiod_ns) {
+            break;
+        }
+        ScheduleEvent *event = &schedule->events[schedule->eventsSize++];
+        event->offset_ns = offset;
+        for (size_t i = 0; i < publishersSize; i++) {
+            if (nextRelease[order[i]] == offset) {
+                event->groups[event->groupsSize++] = (UA_Byte) order[i];
+                nextRelease[order[i]] += publishers[order[i]].period_ns;
+            }
+        }
+    }
+}
+
+static void
+checkSchedule(UA_Server *server, Schedule *schedule, UA_Boolean useFastPublish) {
+    // publish every group a few times to measure its worst publish duration and check that all groups of an event are published before
+    // the next event, the frames carry the start value the subscriber discards like those of the warm up cycles
+    UA_UInt64 worstDuration_ns[MAX_SCHEDULED_GROUPS];
+    for (size_t i = 0; i < schedule->publishersSize; i++) {
+        Publisher *publisher = &schedule->publishers[i];
+        FastPublisher *fastPublisher = useFastPublish ? &publisher->fastPublisher : NULL;
+        worstDuration_ns[i] = 0;
+        // the first publish only warms up the caches
+        for (UA_UInt64 j = 0; j <= SCHEDULE_CALIBRATION_PUBLISHES; j++) {
+            UA_UInt64 startTimestamp = getCurrentTimestamp();
+            if (fastPublisher != NULL) {
+                fastPublish(fastPublisher);
+            } else {
+                UA_WriterGroup_publishCallback(server, publisher->writerGroup);
+            }
+            UA_UInt64 duration = getCurrentTimestamp() - startTimestamp;
+            if (j > 0 && duration > worstDuration_ns[i]) {
+                worstDuration_ns[i] = duration;
+            }
+        }
+    }
+    UA_Double worstLoad = 0;
+    for (size_t i = 0; i < schedule->eventsSize; i++) {
+        ScheduleEvent *event = &schedule->events[i];
+        UA_UInt64 nextOffset = i + 1 < schedule->eventsSize ? schedule->events[i + 1].offset_ns : schedule->hyperperiod_ns + schedule->events[0].offset_ns;
+        UA_UInt64 budget = nextOffset - event->offset_ns;
+        UA_UInt64 needed = 0;
+        for (size_t j = 0; j < event->groupsSize; j++) {
+            needed += worstDuration_ns[event->groups[j]];
+        }
+        if (needed > budget) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the schedule table does not fit: the %zu groups of the event at %llu ns need "
+                                                              "%llu ns but the next event follows after %llu ns", (size_t) event->groupsSize,
+                        (unsigned long long) event->offset_ns, (unsigned long long) needed, (unsigned long long) budget);
+            exit(EXIT_FAILURE);
+        }
+        worstLoad = (UA_Double) needed / (UA_Double) budget > worstLoad ? (UA_Double) needed / (UA_Double) budget : worstLoad;
+    }
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "schedule table: %zu events in a hyperperiod of %llu ns, the fullest slot is %.1f %% busy",
+                schedule->eventsSize, (unsigned long long) schedule->hyperperiod_ns, worstLoad * 100.0);
+}
+
+static void *
+schedulePublishLoop(void *args) {
+    // this is the function responsible for publishing several writer groups at their own rates, it sleeps to each event of the schedule
+    // table and publishes the groups due at it, each group logs its own records and stops logging after its measurements
+    ThreadArguments *arguments = (ThreadArguments *) args;
+    UA_Server *server = arguments->server;
+    Schedule *schedule = arguments->variable;
+    UA_UInt64 measurements = arguments->measurements;
+    UA_Boolean *running = arguments->running;
+    UA_UInt64 lastWarmupValue = VARIABLE_START_VALUE + arguments->options->warmupCycles;
+    UA_Boolean skipLateEvents = arguments->options->overrunPolicy == OVERRUN_POLICY_SKIP;
+    FastPublisher *fastPublishers[MAX_SCHEDULED_GROUPS];
+    for (size_t i = 0; i < schedule->publishersSize; i++) {
+        fastPublishers[i] = arguments->options->fastPublish ? &schedule->publishers[i].fastPublisher : NULL;
+    }
+    SpinWaiter *spinWaiter = NULL;
+    if (arguments->options->spinWakeup) {
+        // the thread may wake up at most half of the shortest gap between two events early
+        UA_UInt64 shortestGap_ns = schedule->hyperperiod_ns;
+        for (size_t i = 0; i + 1 < schedule->eventsSize; i++) {
+            UA_UInt64 gap = schedule->events[i + 1].offset_ns - schedule->events[i].offset_ns;
+            shortestGap_ns = gap < shortestGap_ns ? gap : shortestGap_ns;
+        }
+        spinWaiter = &schedule->publishers[0].spinWaiter;
+        initSpinWaiter(spinWaiter, shortestGap_ns / 2);
+    }
+    if (arguments->options->lockMemory) {
+        prefaultStack();
+    }
+    UA_free(arguments);
+    checkSchedule(server, schedule, fastPublishers[0] != NULL);
+    UA_UInt64 writeIndex[MAX_SCHEDULED_GROUPS] = {0};
+    UA_UInt64 previousTimestamp[MAX_SCHEDULED_GROUPS] = {0};
+    UA_UInt64 loggedRecords = 0, completedGroups = 0, lateEvents = 0, skippedEvents = 0;
+    UA_UInt64 measurementMinorFaults = 0, measurementMajorFaults = 0;
+    // the hyperperiods are aligned to multiples of their length, so every group is released at its phase after a multiple of its period
+    UA_UInt64 scheduleStart = (getCurrentTimestamp() / schedule->hyperperiod_ns + 1) * schedule->hyperperiod_ns;
+    UA_UInt64 hyperperiodStart = scheduleStart;
+    for (; *running && (measurements == 0 || completedGroups < schedule->publishersSize); hyperperiodStart += schedule->hyperperiod_ns) {
+        for (size_t i = 0; i < schedule->eventsSize && *running; i++) {
+            ScheduleEvent *event = &schedule->events[i];
+            UA_UInt64 eventTime = hyperperiodStart + event->offset_ns;
+            UA_UInt64 nextEventTime = i + 1 < schedule->eventsSize ? hyperperiodStart + schedule->events[i + 1].offset_ns
+                                                                   : hyperperiodStart + schedule->hyperperiod_ns + schedule->events[0].offset_ns;
+            if (skipLateEvents && getCurrentTimestamp() > nextEventTime) {
+                // the next event is due already, publishing this one now would only delay it further
+                skippedEvents++;
+                continue;
+            }
+            waitUntilTimestamp(spinWaiter, eventTime);
+            for (size_t j = 0; j < event->groupsSize; j++) {
+                size_t group = event->groups[j];
+                Publisher *publisher = &schedule->publishers[group];
+                UA_UInt64 *publishValue = publisher->fields.values[0];
+                LogRecord sentRecord;
+                *publishValue = *publishValue + 1;
+                updateFieldValues(&publisher->fields, *publishValue);
+                memset(&sentRecord, 0, sizeof(LogRecord));
+                sentRecord.value = *publishValue;
+                sentRecord.cycle = (eventTime - scheduleStart) / publisher->period_ns;
+                sentRecord.timestamp = getCurrentTimestamp();
+                if (fastPublishers[group] != NULL) {
+                    fastPublish(fastPublishers[group]);
+                } else {
+                    UA_WriterGroup_publishCallback(server, publisher->writerGroup);
+                }
+                sentRecord.processedTimestamp = getCurrentTimestamp();
+                if (*publishValue <= lastWarmupValue || (measurements > 0 && writeIndex[group] == measurements)) {
+                    continue;
+                }
+                if (loggedRecords++ == 0) {
+                    getThreadPageFaults(&measurementMinorFaults, &measurementMajorFaults);
+                }
+                pushLogRecord(&publisher->sentRecords, &sentRecord);
+                // the jitter is the delay of the publish behind the event, an overrun reaches into the next period of the group
+                recordHistogramValue(&publisher->histograms[CYCLE_JITTER_HISTOGRAM], sentRecord.timestamp - eventTime);
+                recordSpinWakeUp(publisher->histograms, spinWaiter);
+                if (writeIndex[group] > 0) {
+                    recordHistogramValue(&publisher->histograms[PUBLISH_INTERVAL_HISTOGRAM], sentRecord.timestamp - previousTimestamp[group]);
+                }
+                if (sentRecord.processedTimestamp > eventTime + publisher->period_ns) {
+                    recordHistogramValue(&publisher->histograms[CYCLE_OVERRUN_HISTOGRAM], sentRecord.processedTimestamp - eventTime - publisher->period_ns);
+                }
+                previousTimestamp[group] = sentRecord.timestamp;
+                if (++writeIndex[group] == measurements) {
+                    completedGroups++;
+                }
+            }
+            if (getCurrentTimestamp() > nextEventTime) {
+                lateEvents++;
+            }
+        }
+    }
+    reportThreadPageFaults("publish thread", measurementMinorFaults, measurementMajorFaults);
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "%llu events finished after the next event was due, %llu events skipped",
+                (unsigned long long) lateEvents, (unsigned long long) skippedEvents);
+    reportSpinWakeUp(schedule->publishers[0].histograms, spinWaiter);
+    for (size_t i = 0; i < schedule->publishersSize; i++) {
+        Histogram *jitter = &schedule->publishers[i].histograms[CYCLE_JITTER_HISTOGRAM];
+        if (jitter->count > 0) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "writer group %zu with a period of %llu ns: %llu publishes, jitter min %llu ns, "
+                                                              "mean %llu ns, max %llu ns", i, (unsigned long long) schedule->publishers[i].period_ns,
+                        (unsigned long long) jitter->count, (unsigned long long) jitter->min, (unsigned long long) (jitter->sum / jitter->count),
+                        (unsigned long long) jitter->max);
+        }
+    }
+    return NULL;
+}
+
+static UA_PubSubChannel *
+addPublishConnection(UA_Server *server, Publisher *publisher, UA_String *transportProfile, UA_NetworkAddressUrlDataType *networkAddressUrl,
+                     PubSubOptions *options, UA_NodeId *connectionIdent) {
+    // add a connection with its own socket for the publisher, the send hooks of the connection live in the publisher
+    addPubSubConnection(server, transportProfile, networkAddressUrl, options->sources[0].publisherId, connectionIdent);
+    UA_PubSubChannel *channel = UA_PubSubConnection_findConnectionbyId(server, *connectionIdent)->channel;
+    publisher->sockfd = channel->sockfd;
+    publisher->ownsConnection = true;
+    setupSocket(publisher->sockfd, networkAddressUrl, options);
+    if (options->txtimeOffset_ns > 0) {
+        hookChannelSend(channel, &publisher->sendContext, networkAddressUrl);
+    }
+    if (options->xdp) {
+        createXdpSocket(&publisher->xdp, channel, networkAddressUrl);
+    }
+    if (options->redundant) {
+        // a second connection with its own socket takes a copy of every frame of the first one, its frames are not timestamped
+        UA_NodeId redundantConnectionIdent;
+        PubSubOptions redundantOptions = *options;
+        redundantOptions.txTimestamps = false;
+        addPubSubConnection(server, &options->redundantTransportProfile, &options->redundantAddress, options->sources[0].publisherId,
+                            &redundantConnectionIdent);
+        UA_PubSubChannel *redundantChannel = UA_PubSubConnection_findConnectionbyId(server, redundantConnectionIdent)->channel;
+        setupSocket(redundantChannel->sockfd, &options->redundantAddress, &redundantOptions);
+        hookRedundantChannel(channel, redundantChannel);
+    }
+    if (options->securityMode != SECURITY_MODE_NONE) {
+        // the hooks above send the secured frame, so both paths carry the same nonce and signature
+        createSecureChannel(&publisher->secure, options->securityMode, options->securityKeys);
+        hookSecureChannel(channel, &publisher->secure);
+    }
+    if (TRACE_ENABLED) {
+        // the trace hook times the send inside the publish callback, around the hooks above
+        hookTraceChannel(channel);
+    }
+    return channel;
+}
+
+static void
+addPublishGroup(UA_Server *server, Publisher *publisher, size_t index, size_t groupsSize, UA_NodeId connectionIdent, UA_PubSubChannel *channel,
+                UA_NetworkAddressUrlDataType *networkAddressUrl, DataSetLayout *layout, PubSubOptions *options) {
+    // give the publisher its own published data set, writer group and histograms, the writer groups of all publishers share the publisher
+    // id and use consecutive writer group ids
+    static const char *histogramNames[PUBLISH_HISTOGRAMS] = {"CycleJitter", "PublishInterval", "CycleOverrun", "WakeUpLatency",
+                                                                      "SpinTime", "DeadlineError"};
+    SourceKey *source = &options->sources[0];
+    UA_NodeId publishedDataSetIdent, writerGroupIdent;
+    createPublishedFields(&publisher->fields, layout);
     addPublishedDataSet(server, &publishedDataSetIdent);
-    addDataSetFields(server, &staticValueSource, publishedDataSetIdent, publishValue);
-    addWriterGroup(server, cycle_time_ns, connectionIdent, &writerGroupIdent);
-    addDataSetWriter(server, writerGroupIdent, publishedDataSetIdent);
+    addDataSetFields(server, &publisher->fields, publishedDataSetIdent);
+    addWriterGroup(server, publisher->period_ns, (UA_UInt16) (source->writerGroupId + index), connectionIdent, &writerGroupIdent);
+    addDataSetWriter(server, source->dataSetWriterId, writerGroupIdent, publishedDataSetIdent);
+    publisher->writerGroup = UA_WriterGroup_findWGbyId(server, writerGroupIdent);
+    if (options->fastPublish || options->publishBenchmarkCycles > 0) {
+        createFastPublisher(&publisher->fastPublisher, publisher->writerGroup, channel, networkAddressUrl, options, publisher->fields.generatedValues);
+    }
+    // a single publisher keeps the names of the statistics and the log file it had before there were several
+    for (size_t i = 0; i < PUBLISH_HISTOGRAMS; i++) {
+        if (groupsSize > 1) {
+            snprintf(publisher->histogramNames[i], NODE_NAME_LENGTH, "%s%zu", histogramNames[i], index);
+        } else {
+            snprintf(publisher->histogramNames[i], NODE_NAME_LENGTH, "%s", histogramNames[i]);
+        }
+        initHistogram(&publisher->histograms[i], publisher->histogramNames[i]);
+    }
+    if (options->spinWakeup) {
+        // an early wake up of more than half a period would already sleep through the previous cycle
+        initSpinWaiter(&publisher->spinWaiter, publisher->period_ns / 2);
+    }
+    if (index > 0) {
+        snprintf(publisher->logFileName, NODE_NAME_LENGTH, PUBLISH_THREAD_LOG_FILE_NAME, index);
+        snprintf(publisher->traceFileName, NODE_NAME_LENGTH, PUBLISH_THREAD_TRACE_FILE_NAME, (unsigned int) index);
+    } else {
+        snprintf(publisher->logFileName, NODE_NAME_LENGTH, "%s", PUBLISH_LOG_FILE_NAME);
+        snprintf(publisher->traceFileName, NODE_NAME_LENGTH, "%s", PUBLISH_TRACE_FILE_NAME);
+    }
+}
+
+static void
+startEchoReader(UA_Server *server, EchoReader *echo, Histogram *histogram, UA_UInt64 cycle_time_ns, UA_UInt64 measurements, PubSubOptions *options) {
+    // add a connection to the echo address and start the thread that receives the echoes on it, the decoder of the echoes is not on
+    // the publish path and may allocate, so the thread runs below the rt priority like the log writer it shares the core with
+    UA_NodeId connectionIdent;
+    PubSubOptions echoOptions = *options;
+    memset(echo, 0, sizeof(EchoReader));
+    echo->key = options->sources[0];
+    echo->histogram = histogram;
+    echo->running = true;
+    initHistogram(echo->histogram, "RoundTripTime");
+    echo->message.data = (UA_Byte *) UA_calloc(RECEIVE_BUFFER_SIZE, 1);
+    if (!echo->message.data) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_calloc failed");
+        exit(EXIT_FAILURE);
+    }
+    addPubSubConnection(server, &options->echoTransportProfile, &options->echoAddress, options->sources[0].publisherId, &connectionIdent);
+    echo->channel = UA_PubSubConnection_findConnectionbyId(server, connectionIdent)->channel;
+    // the echo thread polls its channel with a timeout and sends nothing
+    echoOptions.blockingReceive = false;
+    echoOptions.txtimeOffset_ns = 0;
+    echoOptions.txTimestamps = false;
+    setupSocket(echo->channel->sockfd, &options->echoAddress, &echoOptions);
+    createLogRing(&echo->receivedRecords);
+    startLogWriterThread(&echo->receivedRecords, ECHO_LOG_FILE_NAME, cycle_time_ns, &echo->logWriterThread, CPU_TWO);
+    startPubSubThread(server, echoReceiveLoop, cycle_time_ns, echo, NULL, &echo->echoThread, &echo->receivedRecords, measurements, &echo->running,
+                      options, echo->channel->sockfd, NON_RT_THREAD_PRIORITY, CPU_TWO);
+}
+
+static void
+stopEchoReader(EchoReader *echo, UA_UInt64 cycle_time_ns) {
+    // give the echoes of the last values a few cycles to arrive, then stop the echo thread and drain its log
+    waitUntilTimestamp(NULL, getCurrentTimestamp() + ECHO_DRAIN_CYCLES * cycle_time_ns);
+    __atomic_store_n(&echo->running, false, __ATOMIC_RELAXED);
+    waitForThreadTermination(echo->echoThread, false);
+    stopLogWriterThread(&echo->receivedRecords, echo->logWriterThread);
+    deleteLogRing(&echo->receivedRecords);
+    UA_free(echo->message.data);
+}
+
+static int
+run(UA_String *transportProfile, UA_NetworkAddressUrlDataType *networkAddressUrl, int port, UA_UInt64 cycle_time_ns, UA_UInt64 measurements,
+    PubSubOptions *options) {
+    // start the server and publish the fields, either from one thread per publish cpu that owns a connection and a writer group spread
+    // evenly over the cycle, or from a single thread that publishes the scheduled writer groups of one connection at their own rates
+    static const char *traceStageNames[PUBLISH_TRACE_STAGES] = {"Deadline", "WakeUp", "Prepared", "SendStart", "SendEnd", "Published"};
     UA_Boolean running = true;
-    startServerThread(server, &running, &serverThread, CPU_TWO);
-    startPubSubThread(server, customPublishLoop, cycle_time_ns, publishValue, UA_WriterGroup_findWGbyId(server, writerGroupIdent),
-                      &publishThread, &sentValues, &sentTimestamps, measurements, &running, CPU_ONE);
-    waitForThreadTermination(publishThread, false);
-    UA_StatusCode serverReturnValue = waitForThreadTermination(serverThread, true);
-    writeLogFile(PUBLISH_LOG_FILE_NAME, sentValues, sentTimestamps, measurements);
-    UA_free(publishValue);
-    UA_free(staticValueSource);
+    UA_Boolean scheduled = options->writerGroupsSize > 0;
+    size_t groupsSize = scheduled ? options->writerGroupsSize : options->publishCpusSize > 0 ? options->publishCpusSize : 1;
+    size_t threadsSize = scheduled ? 1 : groupsSize;
+    // the trace points are in the publish loop of single frames
+    UA_Boolean traced = TRACE_ENABLED && !scheduled && options->batchSize <= 1 && options->publishBenchmarkCycles == 0;
+    if (options->sourcesSize > 1) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the publisher publishes exactly one source");
+        exit(EXIT_FAILURE);
+    }
+    if (options->snapshotReaders > 0) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the snapshot readers check the received samples of the subscriber");
+        exit(EXIT_FAILURE);
+    }
+    if (options->redundant && threadsSize > 1) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the redundant path duplicates the connection of a single publish thread");
+        exit(EXIT_FAILURE);
+    }
+    if (options->cooperativeServer && (groupsSize > 1 || options->batchSize > 1 || options->publishBenchmarkCycles > 0 || options->echo)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the cooperative server shares the core of a single publish thread without batches "
+                                                          "and echo thread");
+        exit(EXIT_FAILURE);
+    }
+    if (options->echo && options->securityMode != SECURITY_MODE_NONE) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the echoes are not secured");
+        exit(EXIT_FAILURE);
+    }
+    if (options->echo && (groupsSize > 1 || options->batchSize > 1 || options->publishBenchmarkCycles > 0)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the echo mode measures the round trip of a single publish thread without batches");
+        exit(EXIT_FAILURE);
+    }
+    if (options->sources[0].writerGroupId + groupsSize - 1 > UINT16_MAX) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the writer group ids of the publishers exceed %u", UINT16_MAX);
+        exit(EXIT_FAILURE);
+    }
+    setupSignalHandler(&running);
+    if (options->lockMemory) {
+        lockMemory();
+    }
+    UA_Server *server = createServer(port);
+    UA_NodeId connectionIdent;
+    UA_PubSubChannel *channel = NULL;
+    pthread_t serverThread;
+    DataSetLayout layout;
+    Statistics statistics;
+    Schedule schedule;
+    EchoReader echo;
+    CooperativeServer cooperative;
+    Publisher *publishers = (Publisher *) UA_calloc(groupsSize, sizeof(Publisher));
+    // the round trip histogram of the echo reader and the work histogram of the cooperative server follow the histograms of the publishers
+    size_t histogramsSize = groupsSize * PUBLISH_HISTOGRAMS + (options->echo ? 1 : 0) + (options->cooperativeServer ? 1 : 0);
+    Histogram *histograms = (Histogram *) UA_calloc(histogramsSize, sizeof(Histogram));
+    if (!publishers || !histograms) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_calloc failed");
+        exit(EXIT_FAILURE);
+    }
+    createDataSetLayout(&layout, options);
+    for (size_t i = 0; i < groupsSize; i++) {
+        Publisher *publisher = &publishers[i];
+        publisher->histograms = &histograms[i * PUBLISH_HISTOGRAMS];
+        publisher->cpu = options->publishCpusSize > 0 ? options->publishCpus[scheduled ? 0 : i] : CPU_ONE;
+        publisher->period_ns = scheduled ? options->writerGroups[i].period_ns : cycle_time_ns;
+        publisher->phase_ns = scheduled ? options->writerGroups[i].phase_ns : cycle_time_ns * i / groupsSize;
+        if (!scheduled || i == 0) {
+            channel = addPublishConnection(server, publisher, transportProfile, networkAddressUrl, options, &connectionIdent);
+        } else {
+            publisher->sockfd = publishers[0].sockfd;
+        }
+        addPublishGroup(server, publisher, i, groupsSize, connectionIdent, channel, networkAddressUrl, &layout, options);
+    }
+    if (scheduled) {
+        createSchedule(&schedule, publishers, groupsSize);
+    }
+    if (options->echo) {
+        startEchoReader(server, &echo, &histograms[groupsSize * PUBLISH_HISTOGRAMS], cycle_time_ns, measurements, options);
+        publishers[0].echo = &echo;
+    }
+    statistics.histograms = histograms;
+    statistics.histogramsSize = histogramsSize;
+    addStatistics(server, &statistics);
+    // without a server thread the log writers share the core of the publish thread as well
+    int serviceCpu = options->cooperativeServer ? publishers[0].cpu : CPU_TWO;
+    for (size_t i = 0; i < groupsSize; i++) {
+        if (traced) {
+            createTraceBuffer(&publishers[i].trace, "publish", traceStageNames, PUBLISH_TRACE_STAGES, options);
+        }
+        createLogRing(&publishers[i].sentRecords);
+        startLogWriterThread(&publishers[i].sentRecords, publishers[i].logFileName, publishers[i].period_ns, &publishers[i].logWriterThread, serviceCpu);
+    }
+    if (options->cooperativeServer) {
+        startCooperativeServer(&cooperative, server, options->cooperativeMargin_ns, &histograms[histogramsSize - 1]);
+        publishers[0].cooperative = &cooperative;
+    } else {
+        startServerThread(server, &running, &serverThread, CPU_TWO);
+    }
+    if (scheduled) {
+        // the schedule thread logs into the rings of all publishers
+        startPubSubThread(server, schedulePublishLoop, schedule.hyperperiod_ns, &schedule, NULL, &publishers[0].publishThread, NULL, measurements,
+                          &running, options, publishers[0].sockfd, RT_THREAD_PRIORITY, publishers[0].cpu);
+    }
+    for (size_t i = 0; i < groupsSize && !scheduled; i++) {
+        startPubSubThread(server, options->batchSize > 1 ? batchPublishLoop : customPublishLoop, cycle_time_ns, &publishers[i],
+                          publishers[i].writerGroup, &publishers[i].publishThread, &publishers[i].sentRecords, measurements, &running, options,
+                          publishers[i].sockfd, RT_THREAD_PRIORITY, publishers[i].cpu);
+    }
+    for (size_t i = 0; i < threadsSize; i++) {
+        waitForThreadTermination(publishers[i].publishThread, false);
+    }
+    if (options->echo) {
+        stopEchoReader(&echo, cycle_time_ns);
+    }
+    running = false;
+    for (size_t i = 0; i < groupsSize; i++) {
+        stopLogWriterThread(&publishers[i].sentRecords, publishers[i].logWriterThread);
+    }
+    UA_StatusCode serverReturnValue = options->cooperativeServer ? stopCooperativeServer(&cooperative) : waitForThreadTermination(serverThread, true);
+    for (size_t i = 0; i < threadsSize && options->txtimeOffset_ns > 0; i++) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "publish thread %zu: %llu frames missed their launch time",
+                    i, (unsigned long long) publishers[i].missedLaunchTimes);
+    }
+    for (size_t i = 0; i < groupsSize; i++) {
+        deleteLogRing(&publishers[i].sentRecords);
+        if (traced) {
+            writeTraceFile(&publishers[i].trace, publishers[i].traceFileName);
+            deleteTraceBuffer(&publishers[i].trace);
+        }
+    }
     UA_Server_delete(server);
+    for (size_t i = 0; i < groupsSize; i++) {
+        if (options->xdp && publishers[i].ownsConnection) {
+            deleteXdpSocket(&publishers[i].xdp);
+        }
+        if (options->securityMode != SECURITY_MODE_NONE && publishers[i].ownsConnection) {
+            char channelName[NODE_NAME_LENGTH];
+            snprintf(channelName, NODE_NAME_LENGTH, "publish thread %u", (unsigned int) i);
+            deleteSecureChannel(&publishers[i].secure, channelName);
+        }
+        deleteFastPublisher(&publishers[i].fastPublisher);
+        deletePublishedFields(&publishers[i].fields);
+    }
+    if (scheduled) {
+        UA_free(schedule.events);
+    }
+    UA_free(histograms);
+    UA_free(publishers);
+    deleteDataSetLayout(&layout);
     return serverReturnValue == UA_STATUSCODE_GOOD ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 int main(int argc, char **argv) {
     // parse and pass command line parameters
-    if (argc == 6) {
-        UA_String transportProfile;
-        UA_NetworkAddressUrlDataType networkAddressUrl;
-        int port;
-        UA_UInt64 cycle_time_ns;
-        UA_UInt64 measurements;
-        fillArguments(argv, &transportProfile, &networkAddressUrl, &port, &cycle_time_ns, &measurements);
-        return run(&transportProfile, &networkAddressUrl, port, cycle_time_ns, measurements);
+    UA_String transportProfile;
+    UA_NetworkAddressUrlDataType networkAddressUrl;
+    int port;
+    UA_UInt64 cycle_time_ns;
+    UA_UInt64 measurements;
+    PubSubOptions options;
+    if (fillArguments(argc, argv, &transportProfile, &networkAddressUrl, &port, &cycle_time_ns, &measurements, &options)) {
+        if (options.codecCheckIterations > 0) {
+            return checkGeneratedCodec(options.codecCheckIterations) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        if (options.securityCheck) {
+            return checkSecurity() ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        return run(&transportProfile, &networkAddressUrl, port, cycle_time_ns, measurements, &options);
     } else {
         usage(argv[0]);
         return EXIT_SUCCESS;
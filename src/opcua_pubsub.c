@@ -3,54 +3,345 @@
 void
 usage(char *name) {
     // prints the usage string
-    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "usage: %s <pubsub_interface> <pubsub_url> <opc_ua_server_port> <cycle_time_ns>", name);
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "usage: %s [--scalar-fields <n>] [--array-fields <n> --array-length <n>] "
+                                                      "[--blocking-receive] [--busy-poll <us>] [--txtime-offset <ns>] [--tx-timestamps] "
+                                                      "[--lock-memory] [--warmup-cycles <n>] [--xdp] [--fast-publish] [--benchmark-publish <n>] "
+                                                      "[--fast-subscribe] [--benchmark-decode <n>] [--generated-layout] "
+                                                      "[--check-codec <n>] [--batch-size <n>] [--source <publisher_id>:<writer_group_id>:<data_set_writer_id>]... "
+                                                      "[--publish-cpus <cpu>[,<cpu>]...] [--writer-group <period_ns>[:<phase_ns>]]... [--spin-wakeup] "
+                                                      "[--overrun-policy <skip|catch-up>] [--snapshot-readers <n>] [--echo <opc.udp://ip:port/ or opc.eth://mac[:vid[.pcp]]>] "
+                                                      "[--redundant-path <pubsub_interface>,<opc.udp://ip:port/ or opc.eth://mac[:vid[.pcp]]>] [--trace-marker] [--cooperative <margin_ns>] "
+                                                      "[--security <sign|sign-and-encrypt>,<key_file>] [--check-security] "
+                                                      "<pubsub_interface> <opc.udp://ip:port/ or opc.eth://mac[:vid[.pcp]]> <opc_ua_server_port> <cycle_time_ns> <measurements, 0 runs until SIGINT>", name);
+}
+
+void *
+allocateCacheLineAligned(size_t size) {
+    // allocate memory starting at a cache line, it is released with free
+    void *memory;
+    if (posix_memalign(&memory, CACHE_LINE_SIZE, size)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "posix_memalign failed");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+void
+createLogRing(LogRing *ring) {
+    // allocate the cache line aligned records of an empty ring
+    memset(ring, 0, sizeof(LogRing));
+    ring->records = (LogRecord *) allocateCacheLineAligned(LOG_RING_SIZE * sizeof(LogRecord));
+    memset(ring->records, 0, LOG_RING_SIZE * sizeof(LogRecord));
 }
 
 void
-writeLogFile(char *fileName, UA_UInt64 *values, UA_UInt64 *timestamps, UA_UInt64 measurements) {
-    // writes the acquired data into the log file
-    FILE *logFile = fopen(fileName, "w");
+deleteLogRing(LogRing *ring) {
+    // free the records of the ring
+    free(ring->records);
+    ring->records = NULL;
+}
+
+UA_Boolean
+pushLogRecord(LogRing *ring, const LogRecord *record) {
+    // append a record without ever blocking the single producing rt thread, a record that does not fit is dropped and counted
+    UA_UInt64 head = ring->head;
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == LOG_RING_SIZE) {
+        __atomic_store_n(&ring->droppedRecords, ring->droppedRecords + 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    ring->records[head & (LOG_RING_SIZE - 1)] = *record;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static void
+writeLogFileHeader(FILE *logFile, UA_UInt64 cycle_time_ns, UA_UInt64 records, UA_UInt64 droppedRecords) {
+    // write the versioned header at the start of the log file, the counters stay 0 if the process does not shut down cleanly
+    LogFileHeader header;
+    memset(&header, 0, sizeof(LogFileHeader));
+    memcpy(header.magic, LOG_FILE_MAGIC, sizeof(header.magic));
+    header.version = LOG_FILE_VERSION;
+    header.recordSize = sizeof(LogRecord);
+    header.cycle_time_ns = cycle_time_ns;
+    header.records = records;
+    header.droppedRecords = droppedRecords;
+    if (fseek(logFile, 0, SEEK_SET) || fwrite(&header, sizeof(LogFileHeader), 1, logFile) != 1) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "writing the log file header failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void *
+logWriterLoop(void *args) {
+    // drain the ring into the binary log file until the ring is closed and empty, flushed records survive a crash of the process
+    ThreadArguments *arguments = (ThreadArguments *) args;
+    LogRing *ring = arguments->ring;
+    char *fileName = arguments->data;
+    UA_UInt64 cycle_time_ns = arguments->cycle_time_ns;
+    UA_free(arguments);
+    FILE *logFile = fopen(fileName, "wb");
     if (logFile == NULL) {
         UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "fopen failed: %s", strerror(errno));
         exit(EXIT_FAILURE);
     }
-    for (UA_UInt64 i = 0; i < measurements; i++) {
-        fprintf(logFile, "%llu,%llu\n",
-                (unsigned long long) values[i],
-                (unsigned long long) timestamps[i]);
+    writeLogFileHeader(logFile, cycle_time_ns, 0, 0);
+    struct timespec period = {0, LOG_WRITER_PERIOD_NS};
+    UA_UInt64 tail = ring->tail;
+    while (true) {
+        UA_Boolean closed = __atomic_load_n(&ring->closed, __ATOMIC_ACQUIRE);
+        UA_UInt64 head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        while (tail != head) {
+            UA_UInt64 index = tail & (LOG_RING_SIZE - 1);
+            size_t count = (size_t) (head - tail < LOG_RING_SIZE - index ? head - tail : LOG_RING_SIZE - index);
+            if (fwrite(&ring->records[index], sizeof(LogRecord), count, logFile) != count) {
+                UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "fwrite failed: %s", strerror(errno));
+                exit(EXIT_FAILURE);
+            }
+            tail += count;
+            __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+        }
+        if (fflush(logFile)) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "fflush failed: %s", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        if (closed) {
+            break;
+        }
+        nanosleep(&period, NULL);
     }
+    UA_UInt64 droppedRecords = __atomic_load_n(&ring->droppedRecords, __ATOMIC_RELAXED);
+    writeLogFileHeader(logFile, cycle_time_ns, tail, droppedRecords);
     fclose(logFile);
-    UA_free(values);
-    UA_free(timestamps);
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "%llu records written to %s, %llu records dropped",
+                (unsigned long long) tail, fileName, (unsigned long long) droppedRecords);
+    return NULL;
+}
+
+void
+startLogWriterThread(LogRing *ring, char *fileName, UA_UInt64 cycle_time_ns, pthread_t *thread, int cpu) {
+    // start the thread that streams the records of the ring into the log file
+    ThreadArguments *args = (ThreadArguments *) UA_malloc(sizeof(ThreadArguments));
+    if (args == NULL) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_malloc failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    args->ring = ring;
+    args->data = fileName;
+    args->cycle_time_ns = cycle_time_ns;
+    startThread(thread, logWriterLoop, args, NON_RT_THREAD_PRIORITY, cpu);
+}
+
+void
+stopLogWriterThread(LogRing *ring, pthread_t thread) {
+    // close the ring after its producer terminated and wait until the writer drained it
+    __atomic_store_n(&ring->closed, true, __ATOMIC_RELEASE);
+    waitForThreadTermination(thread, false);
+}
+
+UA_UInt64
+timespecToTimestamp(const struct timespec *timespecTimestamp) {
+    // converts a timespec into ns since the epoch of its clock
+    return (UA_UInt64) timespecTimestamp->tv_sec * NS_IN_ONE_SECOND + (UA_UInt64) timespecTimestamp->tv_nsec;
 }
 
 UA_UInt64
 getCurrentTimestamp(void) {
     // returns the current timestamp in ns since the epoch
     struct timespec timespecTimestamp;
-    UA_UInt64 integerTimestamp = 0;
     if (clock_gettime(CLOCK, &timespecTimestamp)) {
         UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "clock_gettime failed: %s", strerror(errno));
         exit(EXIT_FAILURE);
     }
-    integerTimestamp += (UA_UInt64) timespecTimestamp.tv_sec * NS_IN_ONE_SECOND;
-    integerTimestamp += (UA_UInt64) timespecTimestamp.tv_nsec;
-    return integerTimestamp;
+    return timespecToTimestamp(&timespecTimestamp);
 }
 
 void
-waitUntilNextEvent(UA_UInt64 ns_offset, UA_UInt64 cycle_time_ns) {
-    // wait until the next cyclic event
+sleepUntilTimestamp(UA_UInt64 timestamp) {
+    // sleep until the given absolute timestamp, returns at once if it passed already
     struct timespec wakeUpTime;
+    wakeUpTime.tv_sec = timestamp / NS_IN_ONE_SECOND;
+    wakeUpTime.tv_nsec = timestamp % NS_IN_ONE_SECOND;
+    int error = clock_nanosleep(CLOCK, TIMER_ABSTIME, &wakeUpTime, NULL);
+    if (error && error != EINTR) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "clock_nanosleep failed");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void
+initSpinWaiter(SpinWaiter *waiter, UA_UInt64 maxOffset_ns) {
+    // start with the initial offset, it follows the observed wake up latencies once the first window is complete
+    memset(waiter, 0, sizeof(SpinWaiter));
+    initHistogram(&waiter->window, "SpinWakeUpWindow");
+    waiter->maxOffset_ns = maxOffset_ns;
+    waiter->offset_ns = SPIN_WAKEUP_INITIAL_OFFSET_NS < maxOffset_ns ? SPIN_WAKEUP_INITIAL_OFFSET_NS : maxOffset_ns;
+}
+
+UA_UInt64
+waitUntilTimestamp(SpinWaiter *waiter, UA_UInt64 timestamp) {
+    // sleep until the timestamp, with a spin waiter sleep until its offset before the timestamp and spin on the clock for the rest, the
+    // wake up latency, spin time and deadline error of the last wait are kept in the waiter, returns the targeted timestamp
+    if (waiter == NULL) {
+        sleepUntilTimestamp(timestamp);
+        return timestamp;
+    }
+    if (waiter->window.count >= SPIN_WAKEUP_WINDOW) {
+        // adapt the offset in the idle time before the sleep, a wake up later than the offset leaves no time to spin
+        UA_UInt64 offset = getHistogramPercentile(&waiter->window, SPIN_WAKEUP_PERCENTILE) + SPIN_WAKEUP_MARGIN_NS;
+        waiter->offset_ns = offset < waiter->maxOffset_ns ? offset : waiter->maxOffset_ns;
+        initHistogram(&waiter->window, waiter->window.name);
+    }
+    UA_UInt64 wakeUpTime = timestamp > waiter->offset_ns ? timestamp - waiter->offset_ns : 0;
+    sleepUntilTimestamp(wakeUpTime);
+    UA_UInt64 wokenTimestamp = getCurrentTimestamp();
+    UA_UInt64 currentTimestamp = wokenTimestamp;
+    while (currentTimestamp < timestamp) {
+        currentTimestamp = getCurrentTimestamp();
+    }
+    waiter->wakeUpLatency_ns = wokenTimestamp > wakeUpTime ? wokenTimestamp - wakeUpTime : 0;
+    waiter->spinTime_ns = currentTimestamp - wokenTimestamp;
+    waiter->deadlineError_ns = currentTimestamp - timestamp;
+    recordHistogramValue(&waiter->window, waiter->wakeUpLatency_ns);
+    return timestamp;
+}
+
+UA_UInt64
+getNextEventTimestamp(UA_UInt64 ns_offset, UA_UInt64 cycle_time_ns) {
+    // returns the timestamp of the next cyclic event, the events are ns_offset before the multiples of the cycle time
     UA_UInt64 currentTimestamp = getCurrentTimestamp();
     UA_UInt64 remainder = currentTimestamp % cycle_time_ns;
-    currentTimestamp += cycle_time_ns - ((remainder + ns_offset) % cycle_time_ns);
-    wakeUpTime.tv_sec = currentTimestamp / NS_IN_ONE_SECOND;
-    wakeUpTime.tv_nsec = currentTimestamp % NS_IN_ONE_SECOND;
-    if (clock_nanosleep(CLOCK, TIMER_ABSTIME, &wakeUpTime, NULL)) {
-        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "clock_nanosleep failed");
+    return currentTimestamp + cycle_time_ns - ((remainder + ns_offset) % cycle_time_ns);
+}
+
+UA_UInt64
+waitUntilNextEvent(SpinWaiter *waiter, UA_UInt64 ns_offset, UA_UInt64 cycle_time_ns) {
+    // wait until the next cyclic event and return the targeted wake up time
+    return waitUntilTimestamp(waiter, getNextEventTimestamp(ns_offset, cycle_time_ns));
+}
+
+void
+initCycleAccount(CycleAccount *account, OverrunPolicy policy, UA_UInt64 ns_offset, UA_UInt64 cycle_time_ns) {
+    // fix the start epoch at the next cyclic event, the deadline of every later cycle follows from its index and never from the time
+    // the previous cycle ended
+    memset(account, 0, sizeof(CycleAccount));
+    account->policy = policy;
+    account->cycle_time_ns = cycle_time_ns;
+    account->startEpoch_ns = getNextEventTimestamp(ns_offset, cycle_time_ns);
+}
+
+UA_UInt64
+getCycleDeadline(CycleAccount *account) {
+    // returns the timestamp the current cycle starts at
+    return account->startEpoch_ns + account->cycle * account->cycle_time_ns;
+}
+
+UA_UInt64
+finishCycle(CycleAccount *account, UA_UInt64 finishedTimestamp) {
+    // close the current cycle and advance to the next one, a cycle that finished after the start of the next one overran, returns by how
+    // much, the skip policy drops the cycles whose start already passed, the catch up policy runs them back to back at once
+    UA_UInt64 nextDeadline = getCycleDeadline(account) + account->cycle_time_ns;
+    account->cycle++;
+    if (finishedTimestamp <= nextDeadline) {
+        return 0;
+    }
+    UA_UInt64 overrun_ns = finishedTimestamp - nextDeadline;
+    UA_UInt64 passedCycles = overrun_ns / account->cycle_time_ns + 1;
+    account->overruns++;
+    account->maxOverrun_ns = overrun_ns > account->maxOverrun_ns ? overrun_ns : account->maxOverrun_ns;
+    if (account->policy == OVERRUN_POLICY_SKIP) {
+        account->missedCycles += passedCycles;
+        account->cycle += passedCycles;
+    } else {
+        account->lateCycles += passedCycles;
+    }
+    return overrun_ns;
+}
+
+void
+reportCycleAccount(CycleAccount *account, const char *threadName) {
+    // log the overruns of the thread and what the policy made of them
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "%s: %llu cycles, %llu overruns of up to %llu ns, %llu cycles skipped, %llu cycles started late",
+                threadName, (unsigned long long) account->cycle, (unsigned long long) account->overruns, (unsigned long long) account->maxOverrun_ns,
+                (unsigned long long) account->missedCycles, (unsigned long long) account->lateCycles);
+}
+
+UA_Int64
+getTaiOffset(void) {
+    // returns the offset of CLOCK_TAI to the used clock rounded to full seconds, the launch time of SO_TXTIME is always in CLOCK_TAI
+    struct timespec taiTimestamp;
+    if (clock_gettime(CLOCK_TAI, &taiTimestamp)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "clock_gettime failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    UA_Int64 offset = (UA_Int64) timespecToTimestamp(&taiTimestamp) - (UA_Int64) getCurrentTimestamp();
+    return (offset + (UA_Int64) NS_IN_ONE_SECOND / 2) / (UA_Int64) NS_IN_ONE_SECOND * (UA_Int64) NS_IN_ONE_SECOND;
+}
+
+void
+lockMemory(void) {
+    // lock all current and future pages of the process and keep freed heap memory mapped, then prefault a heap reserve
+    if (mlockall(MCL_CURRENT | MCL_FUTURE)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "mlockall failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    if (!mallopt(M_TRIM_THRESHOLD, -1) || !mallopt(M_MMAP_MAX, 0)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "mallopt failed");
+        exit(EXIT_FAILURE);
+    }
+    char *heapReserve = (char *) malloc(HEAP_PREFAULT_SIZE);
+    if (heapReserve == NULL) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "malloc failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < HEAP_PREFAULT_SIZE; i += pageSize) {
+        ((volatile char *) heapReserve)[i] = 0;
+    }
+    free(heapReserve);
+}
+
+void
+prefaultStack(void) {
+    // touch the top of the stack of the calling thread so that its pages are mapped before the first cycle
+    volatile char stack[STACK_PREFAULT_SIZE];
+    size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < STACK_PREFAULT_SIZE; i += pageSize) {
+        stack[i] = 0;
+    }
+    (void) stack[0];
+}
+
+void
+getThreadPageFaults(UA_UInt64 *minorFaults, UA_UInt64 *majorFaults) {
+    // returns the page faults of the calling thread so far
+    struct rusage usage;
+    if (getrusage(RUSAGE_THREAD, &usage)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "getrusage failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    *minorFaults = (UA_UInt64) usage.ru_minflt;
+    *majorFaults = (UA_UInt64) usage.ru_majflt;
+}
+
+UA_UInt64
+getThreadCpuTime(void) {
+    // returns the cpu time the calling thread used so far in ns
+    struct timespec cpuTime;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuTime)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "clock_gettime failed: %s", strerror(errno));
         exit(EXIT_FAILURE);
     }
+    return (UA_UInt64) cpuTime.tv_sec * NS_IN_ONE_SECOND + (UA_UInt64) cpuTime.tv_nsec;
+}
+
+void
+reportThreadPageFaults(const char *threadName, UA_UInt64 measurementMinorFaults, UA_UInt64 measurementMajorFaults) {
+    // log the page faults of the calling thread in total and since the given counts taken at the start of the measurement
+    UA_UInt64 minorFaults, majorFaults;
+    getThreadPageFaults(&minorFaults, &majorFaults);
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "%s page faults: %llu minor, %llu major, during the measurement %llu minor, %llu major",
+                threadName, (unsigned long long) minorFaults, (unsigned long long) majorFaults,
+                (unsigned long long) (minorFaults - measurementMinorFaults), (unsigned long long) (majorFaults - measurementMajorFaults));
 }
 
 void
@@ -114,28 +405,945 @@ waitForThreadTermination(pthread_t thread, UA_Boolean useReturnValue) {
 
 }
 
+static UA_Boolean
+enableHardwareTxTimestamps(int sockfd, UA_String *networkInterface) {
+    // switch on tx timestamping in the nic of the interface and keep its rx filter, returns false if the nic or driver lacks support
+    struct ifreq interfaceRequest;
+    struct hwtstamp_config hardwareConfig;
+    if (networkInterface->length >= IFNAMSIZ) {
+        return false;
+    }
+    memset(&interfaceRequest, 0, sizeof(struct ifreq));
+    memset(&hardwareConfig, 0, sizeof(struct hwtstamp_config));
+    memcpy(interfaceRequest.ifr_name, networkInterface->data, networkInterface->length);
+    interfaceRequest.ifr_data = (char *) &hardwareConfig;
+    if (ioctl(sockfd, SIOCGHWTSTAMP, &interfaceRequest)) {
+        hardwareConfig.rx_filter = HWTSTAMP_FILTER_NONE;
+    }
+    hardwareConfig.flags = 0;
+    hardwareConfig.tx_type = HWTSTAMP_TX_ON;
+    return ioctl(sockfd, SIOCSHWTSTAMP, &interfaceRequest) == 0;
+}
+
+UA_Boolean
+isEthernetUrl(const UA_String *url) {
+    // returns true if the url selects the raw ethernet transport
+    size_t prefixLength = strlen(ETHERNET_URL_PREFIX);
+    return url->length >= prefixLength && memcmp(url->data, ETHERNET_URL_PREFIX, prefixLength) == 0;
+}
+
 void
-setupSocket(int sockfd) {
+setupSocket(int sockfd, UA_NetworkAddressUrlDataType *networkAddressUrl, PubSubOptions *options) {
     // setup the used socket for the pubsub communication with the right options
     int socketPriority = SOCKET_PRIORITY;
+    if (isEthernetUrl(&networkAddressUrl->url)) {
+        // a raw ethernet socket has no ip header, the priority of its frames is the pcp of the vlan tag given in the url
+        UA_String target;
+        UA_UInt16 vid = 0;
+        UA_Byte pcp = 0;
+        if (UA_parseEndpointUrlEthernet(&networkAddressUrl->url, &target, &vid, &pcp) != UA_STATUSCODE_GOOD) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_parseEndpointUrlEthernet failed");
+            exit(EXIT_FAILURE);
+        }
+        socketPriority = vid > 0 ? pcp : SOCKET_PRIORITY;
+    } else {
+        int typeOfService = TYPE_OF_SERVICE;
+        if (setsockopt(sockfd, IPPROTO_IP, IP_TOS, &typeOfService, sizeof(int))) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "setsockopt failed: %s", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    }
     if (setsockopt(sockfd, SOL_SOCKET, SO_PRIORITY, &socketPriority, sizeof(int))) {
         UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "setsockopt failed: %s", strerror(errno));
         exit(EXIT_FAILURE);
     }
-    int typeOfService = TYPE_OF_SERVICE;
-    if (setsockopt(sockfd, IPPROTO_IP, IP_TOS, &typeOfService, sizeof(int))) {
+    if (options->blockingReceive) {
+        int enable = 1;
+        if (setsockopt(sockfd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(int))) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "setsockopt failed: %s", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (options->txtimeOffset_ns > 0) {
+        struct sock_txtime txtimeConfig = {CLOCK_TAI, SOF_TXTIME_REPORT_ERRORS};
+        if (setsockopt(sockfd, SOL_SOCKET, SO_TXTIME, &txtimeConfig, sizeof(struct sock_txtime))) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "setsockopt failed: %s", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (options->txTimestamps) {
+        // every frame gets a software timestamp when it is passed to the driver, tagged with its send index and without the payload
+        int timestampingFlags = SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+        if (enableHardwareTxTimestamps(sockfd, &networkAddressUrl->networkInterface)) {
+            timestampingFlags |= SOF_TIMESTAMPING_TX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+        } else {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "hardware tx timestamps not available on %.*s, using software tx timestamps",
+                        (int) networkAddressUrl->networkInterface.length, (char *) networkAddressUrl->networkInterface.data);
+        }
+        if (setsockopt(sockfd, SOL_SOCKET, SO_TIMESTAMPING, &timestampingFlags, sizeof(int))) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "setsockopt failed: %s", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (options->busyPoll_us > 0) {
+        int busyPoll = (int) options->busyPoll_us;
+        if (setsockopt(sockfd, SOL_SOCKET, SO_BUSY_POLL, &busyPoll, sizeof(int))) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "setsockopt failed: %s", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+static UA_Boolean
+peekReceiveTimestamp(int sockfd, UA_UInt64 *arrivalTimestamp) {
+    // read the kernel receive timestamp of the next message without removing the message from the socket
+    union {
+        char buffer[CMSG_SPACE(sizeof(struct timespec))];
+        struct cmsghdr align;
+    } control;
+    UA_Byte data;
+    struct iovec iov = {&data, sizeof(data)};
+    struct msghdr message;
+    memset(&message, 0, sizeof(struct msghdr));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+    if (recvmsg(sockfd, &message, MSG_PEEK | MSG_DONTWAIT) < 0) {
+        return false;
+    }
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message); cmsg != NULL; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            struct timespec kernelTimestamp;
+            memcpy(&kernelTimestamp, CMSG_DATA(cmsg), sizeof(struct timespec));
+            *arrivalTimestamp = timespecToTimestamp(&kernelTimestamp);
+            return true;
+        }
+    }
+    *arrivalTimestamp = getCurrentTimestamp();
+    return true;
+}
+
+static void
+storeTxTimestamps(LogRecord *window, UA_UInt64 sentFrames, UA_UInt32 sendIndex, struct scm_timestamping *timestamps) {
+    // store the tx timestamps in the record of the frame if it is still in the window of the last TX_TIMESTAMP_WINDOW frames,
+    // the 32 bit send index of the kernel is extended with the number of sent frames
+    UA_UInt64 frame = (sentFrames & ~(UA_UInt64) UINT32_MAX) | sendIndex;
+    if (frame >= sentFrames) {
+        if (frame <= UINT32_MAX) {
+            return;
+        }
+        frame -= (UA_UInt64) UINT32_MAX + 1;
+    }
+    if (sentFrames - frame > TX_TIMESTAMP_WINDOW) {
+        return;
+    }
+    LogRecord *record = &window[frame % TX_TIMESTAMP_WINDOW];
+    if (timestamps->ts[0].tv_sec != 0 || timestamps->ts[0].tv_nsec != 0) {
+        record->txTimestamp = timespecToTimestamp(&timestamps->ts[0]);
+    }
+    if (timestamps->ts[2].tv_sec != 0 || timestamps->ts[2].tv_nsec != 0) {
+        record->hardwareTxTimestamp = timespecToTimestamp(&timestamps->ts[2]);
+    }
+}
+
+UA_UInt64
+drainErrorQueue(int sockfd, LogRecord *window, UA_UInt64 sentFrames) {
+    // read all pending messages from the error queue of the socket, store the tx timestamps in the window of the last sent records
+    // and return how many frames missed their launch time
+    UA_UInt64 missedLaunchTimes = 0;
+    union {
+        char buffer[CMSG_SPACE(sizeof(struct scm_timestamping)) +
+                    CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_storage))];
+        struct cmsghdr align;
+    } control;
+    UA_Byte data[ERROR_QUEUE_PAYLOAD_SIZE];
+    struct iovec iov = {data, sizeof(data)};
+    struct msghdr message;
+    while (true) {
+        memset(&message, 0, sizeof(struct msghdr));
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control.buffer;
+        message.msg_controllen = sizeof(control.buffer);
+        if (recvmsg(sockfd, &message, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            return missedLaunchTimes;
+        }
+        struct scm_timestamping timestamps;
+        UA_Boolean hasTimestamps = false;
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message); cmsg != NULL; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+                memcpy(&timestamps, CMSG_DATA(cmsg), sizeof(struct scm_timestamping));
+                hasTimestamps = true;
+            } else if ((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+                       (cmsg->cmsg_level == SOL_PACKET && cmsg->cmsg_type == PACKET_TX_TIMESTAMP)) {
+                struct sock_extended_err error;
+                memcpy(&error, CMSG_DATA(cmsg), sizeof(struct sock_extended_err));
+                if (error.ee_origin == SO_EE_ORIGIN_TXTIME) {
+                    missedLaunchTimes++;
+                } else if (error.ee_origin == SO_EE_ORIGIN_TIMESTAMPING && error.ee_info == SCM_TSTAMP_SND && hasTimestamps && window != NULL) {
+                    storeTxTimestamps(window, sentFrames, error.ee_data, &timestamps);
+                }
+            }
+        }
+    }
+}
+
+UA_Boolean
+waitForMessage(int sockfd, UA_UInt64 deadline, UA_UInt64 *arrivalTimestamp) {
+    // block until a message is ready or the deadline passed, returns the kernel receive timestamp of the message
+    return waitForFirstMessage(&sockfd, 1, deadline, arrivalTimestamp) == 0;
+}
+
+int
+waitForFirstMessage(const int *sockfds, size_t sockfdsSize, UA_UInt64 deadline, UA_UInt64 *arrivalTimestamp) {
+    // block until a message is ready on any of the sockets or the deadline passed, returns the index of the socket whose message the
+    // kernel received first together with its receive timestamp, or -1
+    struct pollfd pollDescriptors[REDUNDANT_PATHS];
+    UA_UInt64 currentTimestamp = getCurrentTimestamp();
+    UA_UInt64 remaining = deadline > currentTimestamp ? deadline - currentTimestamp : 0;
+    struct timespec timeout = {(time_t) (remaining / NS_IN_ONE_SECOND), (long) (remaining % NS_IN_ONE_SECOND)};
+    int first = -1;
+    for (size_t i = 0; i < sockfdsSize; i++) {
+        pollDescriptors[i].fd = sockfds[i];
+        pollDescriptors[i].events = POLLIN;
+        pollDescriptors[i].revents = 0;
+    }
+    int ready = ppoll(pollDescriptors, (nfds_t) sockfdsSize, &timeout, NULL);
+    if (ready < 0 && errno != EINTR) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "ppoll failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < sockfdsSize && ready > 0; i++) {
+        UA_UInt64 timestamp;
+        if ((pollDescriptors[i].revents & POLLIN) && peekReceiveTimestamp(sockfds[i], &timestamp) && (first < 0 || timestamp < *arrivalTimestamp)) {
+            first = (int) i;
+            *arrivalTimestamp = timestamp;
+        }
+    }
+    return first;
+}
+
+static ChannelHook channelHooks[MAX_HOOKED_CHANNELS];
+
+static ChannelHook *
+findChannelHook(UA_PubSubChannel *channel) {
+    // returns the hook registered for the channel
+    for (size_t i = 0; i < MAX_HOOKED_CHANNELS; i++) {
+        if (channelHooks[i].channel == channel) {
+            return &channelHooks[i];
+        }
+    }
+    return NULL;
+}
+
+static UA_StatusCode
+hookedChannelSend(UA_PubSubChannel *channel, UA_ExtensionObject *transportSettings, const UA_ByteString *buf) {
+    // replaces the send function of the transport layer and attaches the launch time of the frame if there is one
+    ChannelHook *hook = findChannelHook(channel);
+    ChannelSendContext *context = hook->context;
+    if (context->launchTime == 0) {
+        return hook->send(channel, transportSettings, buf);
+    }
+    union {
+        char buffer[CMSG_SPACE(sizeof(UA_UInt64))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct iovec iov = {buf->data, buf->length};
+    struct msghdr message;
+    memset(&message, 0, sizeof(struct msghdr));
+    message.msg_name = &context->destination;
+    message.msg_namelen = context->destinationLength;
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_TXTIME;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(UA_UInt64));
+    UA_UInt64 taiLaunchTime = (UA_UInt64) ((UA_Int64) context->launchTime + context->taiOffset);
+    memcpy(CMSG_DATA(cmsg), &taiLaunchTime, sizeof(UA_UInt64));
+    if (sendmsg(context->sockfd, &message, 0) < 0) {
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static socklen_t
+parseUdpDestination(UA_NetworkAddressUrlDataType *networkAddressUrl, struct sockaddr_storage *destination) {
+    // parse the multicast group and port of an opc.udp url into a socket address and return its length
+    UA_String hostname, path;
+    UA_UInt16 port;
+    char host[INET_ADDRSTRLEN];
+    struct sockaddr_in *address = (struct sockaddr_in *) destination;
+    memset(destination, 0, sizeof(struct sockaddr_storage));
+    if (UA_parseEndpointUrl(&networkAddressUrl->url, &hostname, &port, &path) != UA_STATUSCODE_GOOD || hostname.length >= INET_ADDRSTRLEN) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_parseEndpointUrl failed");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(host, hostname.data, hostname.length);
+    host[hostname.length] = '\0';
+    if (inet_pton(AF_INET, host, &address->sin_addr) != 1) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "inet_pton failed: %s", host);
+        exit(EXIT_FAILURE);
+    }
+    address->sin_family = AF_INET;
+    address->sin_port = htons(port);
+    return sizeof(struct sockaddr_in);
+}
+
+static UA_StatusCode
+redundantChannelSend(UA_PubSubChannel *channel, UA_ExtensionObject *transportSettings, const UA_ByteString *buf) {
+    // replaces the send function of the transport layer and sends every frame unchanged over the primary and the redundant path, so both
+    // copies carry the same sequence numbers and counter, the frame counts as sent if one of the paths took it
+    ChannelHook *hook = findChannelHook(channel);
+    UA_StatusCode primary = hook->send(channel, transportSettings, buf);
+    UA_StatusCode redundant = hook->redundantChannel->send(hook->redundantChannel, transportSettings, buf);
+    return primary == UA_STATUSCODE_GOOD ? primary : redundant;
+}
+
+void
+hookRedundantChannel(UA_PubSubChannel *channel, UA_PubSubChannel *redundantChannel) {
+    // route all frames of the channel through redundantChannelSend
+    ChannelHook *hook = findChannelHook(NULL);
+    if (hook == NULL) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "hookRedundantChannel failed: too many hooked channels");
+        exit(EXIT_FAILURE);
+    }
+    hook->channel = channel;
+    hook->send = channel->send;
+    hook->redundantChannel = redundantChannel;
+    channel->send = redundantChannelSend;
+}
+
+void
+hookChannelSend(UA_PubSubChannel *channel, ChannelSendContext *context, UA_NetworkAddressUrlDataType *networkAddressUrl) {
+    // route all frames of the channel through hookedChannelSend, the destination is parsed from the url of the connection
+    ChannelHook *hook = findChannelHook(NULL);
+    if (hook == NULL) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "hookChannelSend failed: too many hooked channels");
+        exit(EXIT_FAILURE);
+    }
+    context->destinationLength = parseUdpDestination(networkAddressUrl, &context->destination);
+    context->sockfd = channel->sockfd;
+    context->taiOffset = getTaiOffset();
+    context->launchTime = 0;
+    hook->channel = channel;
+    hook->send = channel->send;
+    hook->context = context;
+    channel->send = hookedChannelSend;
+}
+
+static ChannelHook tracedChannels[MAX_PUBLISH_THREADS];
+
+static ChannelHook *
+findTracedChannel(UA_PubSubChannel *channel) {
+    // returns the trace hook registered for the channel, it wraps whatever other hook the channel has
+    for (size_t i = 0; i < MAX_PUBLISH_THREADS; i++) {
+        if (tracedChannels[i].channel == channel) {
+            return &tracedChannels[i];
+        }
+    }
+    return NULL;
+}
+
+static UA_StatusCode
+tracedChannelSend(UA_PubSubChannel *channel, UA_ExtensionObject *transportSettings, const UA_ByteString *buf) {
+    // timestamps the send of the encoded frame, the time before it went into the encoder of the writer group
+    ChannelHook *hook = findTracedChannel(channel);
+    TRACE_STAGE(PUBLISH_TRACE_SEND_START);
+    UA_StatusCode result = hook->send(channel, transportSettings, buf);
+    TRACE_STAGE(PUBLISH_TRACE_SEND_END);
+    return result;
+}
+
+static UA_StatusCode
+tracedChannelReceive(UA_PubSubChannel *channel, UA_ByteString *message, UA_ExtensionObject *transportSettings, UA_UInt32 timeout) {
+    // timestamps the return of a receive that got a message, the time after it goes into the decoder
+    ChannelHook *hook = findTracedChannel(channel);
+    UA_StatusCode result = hook->receive(channel, message, transportSettings, timeout);
+    if (result == UA_STATUSCODE_GOOD && message->length > 0) {
+        TRACE_STAGE(SUBSCRIBE_TRACE_RECEIVED);
+    }
+    return result;
+}
+
+void
+hookTraceChannel(UA_PubSubChannel *channel) {
+    // route all frames of the channel through tracedChannelSend and tracedChannelReceive, has to come after all other hooks of the channel
+    ChannelHook *hook = findTracedChannel(NULL);
+    if (hook == NULL) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "hookTraceChannel failed: too many traced channels");
+        exit(EXIT_FAILURE);
+    }
+    hook->channel = channel;
+    hook->send = channel->send;
+    hook->receive = channel->receive;
+    channel->send = tracedChannelSend;
+    channel->receive = tracedChannelReceive;
+}
+
+static ChannelHook securedChannels[MAX_PUBLISH_THREADS];
+
+static ChannelHook *
+findSecuredChannel(UA_PubSubChannel *channel) {
+    // returns the security hook registered for the channel
+    for (size_t i = 0; i < MAX_PUBLISH_THREADS; i++) {
+        if (securedChannels[i].channel == channel) {
+            return &securedChannels[i];
+        }
+    }
+    return NULL;
+}
+
+static UA_StatusCode
+securedChannelSend(UA_PubSubChannel *channel, UA_ExtensionObject *transportSettings, const UA_ByteString *buf) {
+    // hands the secured copy of the frame to the send function below, a frame that cannot be secured is not sent at all
+    ChannelHook *hook = findSecuredChannel(channel);
+    UA_ByteString secured;
+    if (!secureMessage(hook->secure, buf, &secured)) {
+        hook->secure->rejectedMessages++;
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    return hook->send(channel, transportSettings, &secured);
+}
+
+static UA_StatusCode
+securedChannelReceive(UA_PubSubChannel *channel, UA_ByteString *message, UA_ExtensionObject *transportSettings, UA_UInt32 timeout) {
+    // hands only verified frames without their security to the decoder, any other frame looks like an empty receive
+    ChannelHook *hook = findSecuredChannel(channel);
+    UA_StatusCode result = hook->receive(channel, message, transportSettings, timeout);
+    if (result == UA_STATUSCODE_GOOD && message->length > 0 && !verifyMessage(hook->secure, channel, message)) {
+        message->length = 0;
+    }
+    return result;
+}
+
+void
+hookSecureChannel(UA_PubSubChannel *channel, SecureChannel *secure) {
+    // route all frames of the channel through securedChannelSend and securedChannelReceive, has to come after the hooks of launch time,
+    // xdp and redundant path, so they get the secured frame, and before the trace hook, several channels may share one secure channel
+    ChannelHook *hook = findSecuredChannel(NULL);
+    if (hook == NULL) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "hookSecureChannel failed: too many secured channels");
+        exit(EXIT_FAILURE);
+    }
+    hook->channel = channel;
+    hook->send = channel->send;
+    hook->receive = channel->receive;
+    hook->secure = secure;
+    channel->send = securedChannelSend;
+    channel->receive = securedChannelReceive;
+}
+
+static void
+mapXdpRing(int fd, XdpRing *ring, struct xdp_ring_offset *offset, size_t descriptorSize, off_t pageOffset) {
+    // map a ring of the xdp socket into user space and resolve its producer, consumer and descriptors
+    ring->mapLength = offset->desc + XDP_RING_SIZE * descriptorSize;
+    ring->map = mmap(NULL, ring->mapLength, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, pageOffset);
+    if (ring->map == MAP_FAILED) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "mmap failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    ring->producer = (UA_UInt32 *) ((UA_Byte *) ring->map + offset->producer);
+    ring->consumer = (UA_UInt32 *) ((UA_Byte *) ring->map + offset->consumer);
+    ring->descriptors = (UA_Byte *) ring->map + offset->desc;
+}
+
+static int
+callBpf(int command, union bpf_attr *attributes) {
+    // there is no glibc wrapper for the bpf syscall
+    return (int) syscall(__NR_bpf, command, attributes, sizeof(union bpf_attr));
+}
+
+static void
+loadXdpProgram(XdpSocket *xdp) {
+    // load an xdp program that redirects all uadp frames, with or without vlan tag, into the xdp socket of their rx queue
+    // and passes everything else to the network stack, then attach it in driver mode or generic mode if the driver lacks support
+    struct bpf_insn program[] = {
+            {BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_1, 0, 0},
+            {BPF_LDX | BPF_MEM | BPF_W, BPF_REG_3, BPF_REG_1, 4, 0},
+            {BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0},
+            {BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, ETHER_HDR_LEN + VLAN_TAG_LENGTH},
+            {BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, 11, 0},
+            {BPF_LDX | BPF_MEM | BPF_H, BPF_REG_4, BPF_REG_2, 12, 0},
+            {BPF_JMP | BPF_JEQ | BPF_K, BPF_REG_4, 0, 3, htons(UADP_ETHERTYPE)},
+            {BPF_JMP | BPF_JNE | BPF_K, BPF_REG_4, 0, 8, htons(ETHERTYPE_VLAN)},
+            {BPF_LDX | BPF_MEM | BPF_H, BPF_REG_4, BPF_REG_2, 16, 0},
+            {BPF_JMP | BPF_JNE | BPF_K, BPF_REG_4, 0, 6, htons(UADP_ETHERTYPE)},
+            {BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_1, 16, 0},
+            {BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, xdp->mapFd},
+            {0, 0, 0, 0, 0},
+            {BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS},
+            {BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map},
+            {BPF_JMP | BPF_EXIT, 0, 0, 0, 0},
+            {BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, XDP_PASS},
+            {BPF_JMP | BPF_EXIT, 0, 0, 0, 0}
+    };
+    static char license[] = "GPL";
+    union bpf_attr attributes;
+    memset(&attributes, 0, sizeof(union bpf_attr));
+    attributes.prog_type = BPF_PROG_TYPE_XDP;
+    attributes.insn_cnt = sizeof(program) / sizeof(program[0]);
+    attributes.insns = (UA_UInt64) (uintptr_t) program;
+    attributes.license = (UA_UInt64) (uintptr_t) license;
+    xdp->programFd = callBpf(BPF_PROG_LOAD, &attributes);
+    if (xdp->programFd < 0) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "BPF_PROG_LOAD failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    memset(&attributes, 0, sizeof(union bpf_attr));
+    attributes.link_create.prog_fd = (UA_UInt32) xdp->programFd;
+    attributes.link_create.target_ifindex = xdp->ifindex;
+    attributes.link_create.attach_type = BPF_XDP;
+    attributes.link_create.flags = XDP_FLAGS_DRV_MODE;
+    xdp->linkFd = callBpf(BPF_LINK_CREATE, &attributes);
+    if (xdp->linkFd < 0) {
+        attributes.link_create.flags = XDP_FLAGS_SKB_MODE;
+        xdp->linkFd = callBpf(BPF_LINK_CREATE, &attributes);
+        if (xdp->linkFd < 0) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "BPF_LINK_CREATE failed: %s", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "xdp program attached in generic mode");
+    }
+}
+
+static void
+buildXdpHeader(XdpSocket *xdp, int sockfd, UA_NetworkAddressUrlDataType *networkAddressUrl, char *interfaceName) {
+    // prebuild the ethernet header of all sent frames from the url and the mac address of the interface, like the ethernet transport layer
+    UA_String target;
+    UA_UInt16 vid = 0;
+    UA_Byte pcp = 0;
+    char destination[3 * ETHER_ADDR_LEN];
+    struct ifreq interfaceRequest;
+    if (UA_parseEndpointUrlEthernet(&networkAddressUrl->url, &target, &vid, &pcp) != UA_STATUSCODE_GOOD || target.length >= sizeof(destination)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_parseEndpointUrlEthernet failed");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(destination, target.data, target.length);
+    destination[target.length] = '\0';
+    UA_Byte *header = xdp->header;
+    if (sscanf(destination, "%2hhx-%2hhx-%2hhx-%2hhx-%2hhx-%2hhx", &header[0], &header[1], &header[2], &header[3], &header[4], &header[5]) != ETHER_ADDR_LEN) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "malformed mac address: %s", destination);
+        exit(EXIT_FAILURE);
+    }
+    memset(&interfaceRequest, 0, sizeof(struct ifreq));
+    memcpy(interfaceRequest.ifr_name, interfaceName, strlen(interfaceName));
+    if (ioctl(sockfd, SIOCGIFHWADDR, &interfaceRequest)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "ioctl failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    memcpy(&header[ETHER_ADDR_LEN], interfaceRequest.ifr_hwaddr.sa_data, ETHER_ADDR_LEN);
+    xdp->headerLength = 2 * ETHER_ADDR_LEN;
+    if (vid > 0) {
+        UA_UInt16 tag[2] = {htons(ETHERTYPE_VLAN), htons((UA_UInt16) ((pcp << 13) | vid))};
+        memcpy(&header[xdp->headerLength], tag, VLAN_TAG_LENGTH);
+        xdp->headerLength += VLAN_TAG_LENGTH;
+    }
+    UA_UInt16 etherType = htons(UADP_ETHERTYPE);
+    memcpy(&header[xdp->headerLength], &etherType, sizeof(UA_UInt16));
+    xdp->headerLength += sizeof(UA_UInt16);
+}
+
+static UA_StatusCode
+xdpChannelSend(UA_PubSubChannel *channel, UA_ExtensionObject *transportSettings, const UA_ByteString *buf) {
+    // replaces the send function of the ethernet transport layer, the frame is written into the next tx frame of the umem
+    XdpSocket *xdp = findChannelHook(channel)->xdp;
+    UA_UInt32 completed = __atomic_load_n(xdp->completion.producer, __ATOMIC_ACQUIRE) - *xdp->completion.consumer;
+    __atomic_store_n(xdp->completion.consumer, *xdp->completion.consumer + completed, __ATOMIC_RELEASE);
+    xdp->txOutstanding -= completed;
+    if (xdp->txOutstanding == XDP_RING_SIZE || xdp->headerLength + buf->length > XDP_FRAME_SIZE) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    // the tx frames follow the rx frames in the umem and are used round robin, a frame is reused after its completion only
+    UA_UInt64 address = (UA_UInt64) (XDP_RING_SIZE + xdp->txFrame % XDP_RING_SIZE) * XDP_FRAME_SIZE;
+    memcpy(xdp->umem + address, xdp->header, xdp->headerLength);
+    memcpy(xdp->umem + address + xdp->headerLength, buf->data, buf->length);
+    UA_UInt32 producer = *xdp->tx.producer;
+    struct xdp_desc *descriptor = &((struct xdp_desc *) xdp->tx.descriptors)[producer & (XDP_RING_SIZE - 1)];
+    descriptor->addr = address;
+    descriptor->len = (UA_UInt32) (xdp->headerLength + buf->length);
+    descriptor->options = 0;
+    __atomic_store_n(xdp->tx.producer, producer + 1, __ATOMIC_RELEASE);
+    xdp->txFrame++;
+    xdp->txOutstanding++;
+    if (sendto(xdp->fd, NULL, 0, MSG_DONTWAIT, NULL, 0) < 0 && errno != EAGAIN && errno != EBUSY && errno != ENOBUFS) {
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+xdpChannelReceive(UA_PubSubChannel *channel, UA_ByteString *message, UA_ExtensionObject *transportSettings, UA_UInt32 timeout) {
+    // replaces the receive function of the ethernet transport layer, takes one frame from the rx ring without a syscall
+    // and hands its frame back to the fill ring, an empty message is returned if no frame is ready
+    XdpSocket *xdp = findChannelHook(channel)->xdp;
+    UA_UInt32 consumer = *xdp->rx.consumer;
+    if (__atomic_load_n(xdp->rx.producer, __ATOMIC_ACQUIRE) == consumer) {
+        message->length = 0;
+        return UA_STATUSCODE_GOOD;
+    }
+    struct xdp_desc *descriptor = &((struct xdp_desc *) xdp->rx.descriptors)[consumer & (XDP_RING_SIZE - 1)];
+    UA_Byte *frame = xdp->umem + descriptor->addr;
+    UA_UInt16 etherType;
+    memcpy(&etherType, &frame[2 * ETHER_ADDR_LEN], sizeof(UA_UInt16));
+    size_t headerLength = etherType == htons(ETHERTYPE_VLAN) ? ETHER_HDR_LEN + VLAN_TAG_LENGTH : ETHER_HDR_LEN;
+    size_t length = descriptor->len > headerLength ? descriptor->len - headerLength : 0;
+    UA_StatusCode statusCode = UA_STATUSCODE_GOOD;
+    if (length > message->length) {
+        length = 0;
+        statusCode = UA_STATUSCODE_BADINTERNALERROR;
+    }
+    memcpy(message->data, frame + headerLength, length);
+    message->length = length;
+    UA_UInt32 producer = *xdp->fill.producer;
+    ((UA_UInt64 *) xdp->fill.descriptors)[producer & (XDP_RING_SIZE - 1)] = descriptor->addr & ~((UA_UInt64) XDP_FRAME_SIZE - 1);
+    __atomic_store_n(xdp->fill.producer, producer + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(xdp->rx.consumer, consumer + 1, __ATOMIC_RELEASE);
+    return statusCode;
+}
+
+void
+createXdpSocket(XdpSocket *xdp, UA_PubSubChannel *channel, UA_NetworkAddressUrlDataType *networkAddressUrl) {
+    // register the umem and the rings of an xdp socket on the interface of the ethernet channel and route all its frames through them,
+    // zero copy is used if the driver supports it, otherwise the kernel copies the frames
+    ChannelHook *hook = findChannelHook(NULL);
+    char interfaceName[IF_NAMESIZE];
+    if (hook == NULL) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "createXdpSocket failed: too many hooked channels");
+        exit(EXIT_FAILURE);
+    }
+    if (networkAddressUrl->networkInterface.length >= IF_NAMESIZE) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "interface name too long");
+        exit(EXIT_FAILURE);
+    }
+    memset(xdp, 0, sizeof(XdpSocket));
+    memcpy(interfaceName, networkAddressUrl->networkInterface.data, networkAddressUrl->networkInterface.length);
+    interfaceName[networkAddressUrl->networkInterface.length] = '\0';
+    xdp->ifindex = if_nametoindex(interfaceName);
+    if (xdp->ifindex == 0) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "if_nametoindex failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    buildXdpHeader(xdp, channel->sockfd, networkAddressUrl, interfaceName);
+    xdp->fd = socket(AF_XDP, SOCK_RAW, 0);
+    if (xdp->fd < 0) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "socket failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    size_t umemSize = 2 * XDP_RING_SIZE * XDP_FRAME_SIZE;
+    if (posix_memalign((void **) &xdp->umem, (size_t) sysconf(_SC_PAGESIZE), umemSize)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "posix_memalign failed");
+        exit(EXIT_FAILURE);
+    }
+    memset(xdp->umem, 0, umemSize);
+    struct xdp_umem_reg umemRegistration;
+    memset(&umemRegistration, 0, sizeof(struct xdp_umem_reg));
+    umemRegistration.addr = (UA_UInt64) (uintptr_t) xdp->umem;
+    umemRegistration.len = umemSize;
+    umemRegistration.chunk_size = XDP_FRAME_SIZE;
+    int ringSize = XDP_RING_SIZE;
+    if (setsockopt(xdp->fd, SOL_XDP, XDP_UMEM_REG, &umemRegistration, sizeof(struct xdp_umem_reg)) ||
+        setsockopt(xdp->fd, SOL_XDP, XDP_UMEM_FILL_RING, &ringSize, sizeof(int)) ||
+        setsockopt(xdp->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &ringSize, sizeof(int)) ||
+        setsockopt(xdp->fd, SOL_XDP, XDP_RX_RING, &ringSize, sizeof(int)) ||
+        setsockopt(xdp->fd, SOL_XDP, XDP_TX_RING, &ringSize, sizeof(int))) {
         UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "setsockopt failed: %s", strerror(errno));
         exit(EXIT_FAILURE);
     }
+    struct xdp_mmap_offsets offsets;
+    socklen_t offsetsLength = sizeof(struct xdp_mmap_offsets);
+    if (getsockopt(xdp->fd, SOL_XDP, XDP_MMAP_OFFSETS, &offsets, &offsetsLength)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "getsockopt failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    mapXdpRing(xdp->fd, &xdp->fill, &offsets.fr, sizeof(UA_UInt64), XDP_UMEM_PGOFF_FILL_RING);
+    mapXdpRing(xdp->fd, &xdp->completion, &offsets.cr, sizeof(UA_UInt64), XDP_UMEM_PGOFF_COMPLETION_RING);
+    mapXdpRing(xdp->fd, &xdp->rx, &offsets.rx, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING);
+    mapXdpRing(xdp->fd, &xdp->tx, &offsets.tx, sizeof(struct xdp_desc), XDP_PGOFF_TX_RING);
+    // the first half of the umem is handed to the kernel for receiving
+    for (UA_UInt32 i = 0; i < XDP_RING_SIZE; i++) {
+        ((UA_UInt64 *) xdp->fill.descriptors)[i] = (UA_UInt64) i * XDP_FRAME_SIZE;
+    }
+    __atomic_store_n(xdp->fill.producer, XDP_RING_SIZE, __ATOMIC_RELEASE);
+    struct sockaddr_xdp address;
+    memset(&address, 0, sizeof(struct sockaddr_xdp));
+    address.sxdp_family = AF_XDP;
+    address.sxdp_ifindex = xdp->ifindex;
+    address.sxdp_queue_id = XDP_QUEUE_ID;
+    address.sxdp_flags = XDP_ZEROCOPY;
+    if (bind(xdp->fd, (struct sockaddr *) &address, sizeof(struct sockaddr_xdp))) {
+        address.sxdp_flags = XDP_COPY;
+        if (bind(xdp->fd, (struct sockaddr *) &address, sizeof(struct sockaddr_xdp))) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "bind failed: %s", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "zero copy not supported by %s, the xdp socket copies the frames", interfaceName);
+    }
+    union bpf_attr attributes;
+    memset(&attributes, 0, sizeof(union bpf_attr));
+    attributes.map_type = BPF_MAP_TYPE_XSKMAP;
+    attributes.key_size = sizeof(UA_UInt32);
+    attributes.value_size = sizeof(int);
+    attributes.max_entries = XDP_MAX_QUEUES;
+    xdp->mapFd = callBpf(BPF_MAP_CREATE, &attributes);
+    if (xdp->mapFd < 0) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "BPF_MAP_CREATE failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    loadXdpProgram(xdp);
+    UA_UInt32 queue = XDP_QUEUE_ID;
+    memset(&attributes, 0, sizeof(union bpf_attr));
+    attributes.map_fd = (UA_UInt32) xdp->mapFd;
+    attributes.key = (UA_UInt64) (uintptr_t) &queue;
+    attributes.value = (UA_UInt64) (uintptr_t) &xdp->fd;
+    if (callBpf(BPF_MAP_UPDATE_ELEM, &attributes)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "BPF_MAP_UPDATE_ELEM failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    hook->channel = channel;
+    hook->send = channel->send;
+    hook->receive = channel->receive;
+    hook->xdp = xdp;
+    channel->send = xdpChannelSend;
+    channel->receive = xdpChannelReceive;
 }
 
+void
+deleteXdpSocket(XdpSocket *xdp) {
+    // detach the xdp program by closing its link and release the socket, its rings and the umem
+    close(xdp->linkFd);
+    close(xdp->programFd);
+    close(xdp->mapFd);
+    close(xdp->fd);
+    XdpRing *rings[] = {&xdp->fill, &xdp->completion, &xdp->rx, &xdp->tx};
+    for (size_t i = 0; i < sizeof(rings) / sizeof(rings[0]); i++) {
+        munmap(rings[i]->map, rings[i]->mapLength);
+    }
+    free(xdp->umem);
+}
+
+UA_Boolean
+hasXdpFrame(XdpSocket *xdp) {
+    // returns true if the rx ring of the xdp socket holds a frame, only reads the shared ring memory
+    return __atomic_load_n(xdp->rx.producer, __ATOMIC_ACQUIRE) != *xdp->rx.consumer;
+}
+
+size_t
+getFixedVariantHeaderSize(const UA_Byte *encoded, const UA_DataType *type, size_t arrayLength) {
+    // returns the size of the encoding mask and array length in front of the value of a binary encoded variant, or 0 if the value
+    // is not encoded like it is stored in memory, a variant starts with its encoding mask, an array additionally with its Int32 length
+    UA_Byte encodingMask = (UA_Byte) type->typeId.identifier.numeric;
+    size_t headerSize = 1;
+    if (arrayLength > 0) {
+        UA_Int32 encodedLength = (UA_Int32) arrayLength;
+        encodingMask |= VARIANT_ARRAY_ENCODING_MASK;
+        headerSize += sizeof(UA_Int32);
+        if (memcmp(&encoded[1], &encodedLength, sizeof(UA_Int32)) != 0) {
+            return 0;
+        }
+    }
+    return type->overlayable && encoded[0] == encodingMask ? headerSize : 0;
+}
+
+static void
+addBufferPatch(FastPublisher *fastPublisher, UA_Byte *target, const void *source, size_t length, UA_UInt16 *sequenceNumber) {
+    // append a patch to the list applied to the buffered message in every cycle
+    BufferPatch *patches = (BufferPatch *) UA_realloc(fastPublisher->patches, (fastPublisher->patchesSize + 1) * sizeof(BufferPatch));
+    if (patches == NULL) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_realloc failed");
+        exit(EXIT_FAILURE);
+    }
+    patches[fastPublisher->patchesSize].target = target;
+    patches[fastPublisher->patchesSize].source = source;
+    patches[fastPublisher->patchesSize].length = length;
+    patches[fastPublisher->patchesSize].sequenceNumber = sequenceNumber;
+    fastPublisher->patches = patches;
+    fastPublisher->patchesSize++;
+}
+
+void
+createFastPublisher(FastPublisher *fastPublisher, UA_WriterGroup *writerGroup, UA_PubSubChannel *channel,
+                    UA_NetworkAddressUrlDataType *networkAddressUrl, PubSubOptions *options, const DataSetValues *generatedValues) {
+    // capture the network message the frozen writer group encoded once and the byte ranges of all sequence numbers and field values in it,
+    // the values of the fixed size fields are stored with their binary encoding in memory, so a cycle only copies them into place, with
+    // the generated layout the generated encoder writes all fields at once into the field region at the end of the message
+    UA_NetworkMessageOffsetBuffer *bufferedMessage = &writerGroup->bufferedMessage;
+    memset(fastPublisher, 0, sizeof(FastPublisher));
+    fastPublisher->channel = channel;
+    fastPublisher->transportSettings = &writerGroup->config.transportSettings;
+    fastPublisher->message = &bufferedMessage->buffer;
+    if (!UA_TYPES[UA_TYPES_UINT16].overlayable) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "fast publish needs a host with the byte order of the binary encoding");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < bufferedMessage->offsetsSize; i++) {
+        UA_NetworkMessageOffset *offset = &bufferedMessage->offsets[i];
+        UA_Byte *target = &bufferedMessage->buffer.data[offset->offset];
+        UA_Variant *value = &offset->offsetData.value.value->value;
+        switch (offset->contentType) {
+            case UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_SEQUENCENUMBER:
+            case UA_PUBSUB_OFFSETTYPE_NETWORKMESSAGE_SEQUENCENUMBER:
+                addBufferPatch(fastPublisher, target, NULL, sizeof(UA_UInt16), (UA_UInt16 *) value->data);
+                break;
+            case UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT: {
+                if (generatedValues != NULL) {
+                    fastPublisher->fieldRegion = fastPublisher->fieldRegion != NULL ? fastPublisher->fieldRegion : target;
+                    break;
+                }
+                size_t arrayLength = UA_Variant_isScalar(value) ? 0 : value->arrayLength;
+                size_t headerSize = getFixedVariantHeaderSize(target, value->type, arrayLength);
+                if (headerSize == 0) {
+                    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "fast publish does not support the encoding of field %zu", i);
+                    exit(EXIT_FAILURE);
+                }
+                addBufferPatch(fastPublisher, target + headerSize, value->data, (arrayLength > 0 ? arrayLength : 1) * value->type->memSize, NULL);
+                break;
+            }
+            default:
+                UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "fast publish does not support offset type %d", (int) offset->contentType);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (generatedValues != NULL) {
+        // the framework encoded the initial values, the generated encoder has to produce exactly the same bytes at the same place
+        UA_Byte *encoded = (UA_Byte *) UA_malloc(DATASET_ENCODED_SIZE);
+        if (encoded == NULL) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_malloc failed");
+            exit(EXIT_FAILURE);
+        }
+        encodeDataSetFields(generatedValues, encoded);
+        if (fastPublisher->fieldRegion == NULL || fastPublisher->fieldRegion + DATASET_ENCODED_SIZE != &bufferedMessage->buffer.data[bufferedMessage->buffer.length] ||
+            memcmp(fastPublisher->fieldRegion, encoded, DATASET_ENCODED_SIZE) != 0) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the generated encoder does not match the buffered message, regenerate the codec");
+            exit(EXIT_FAILURE);
+        }
+        UA_free(encoded);
+        fastPublisher->generatedValues = generatedValues;
+    }
+    if (!isEthernetUrl(&networkAddressUrl->url) && options->txtimeOffset_ns == 0 && !options->redundant && options->securityMode == SECURITY_MODE_NONE) {
+        // without launch time, redundant path and security the udp frame leaves with a plain sendto, otherwise the send function of the
+        // channel attaches the launch time, sends the copy or secures the frame
+        fastPublisher->sockfd = channel->sockfd;
+        fastPublisher->destinationLength = parseUdpDestination(networkAddressUrl, &fastPublisher->destination);
+    }
+}
+
+void
+deleteFastPublisher(FastPublisher *fastPublisher) {
+    // free the patch list, the buffered message belongs to the writer group
+    UA_free(fastPublisher->patches);
+    fastPublisher->patches = NULL;
+    fastPublisher->patchesSize = 0;
+}
+
+UA_StatusCode
+fastPublish(FastPublisher *fastPublisher) {
+    // patch the current sequence numbers and field values into the buffered message and send it, replaces UA_WriterGroup_publishCallback
+    for (size_t i = 0; i < fastPublisher->patchesSize; i++) {
+        BufferPatch *patch = &fastPublisher->patches[i];
+        if (patch->sequenceNumber != NULL) {
+            memcpy(patch->target, patch->sequenceNumber, sizeof(UA_UInt16));
+            (*patch->sequenceNumber)++;
+        } else {
+            memcpy(patch->target, patch->source, patch->length);
+        }
+    }
+    if (fastPublisher->generatedValues != NULL) {
+        encodeDataSetFields(fastPublisher->generatedValues, fastPublisher->fieldRegion);
+    }
+    if (fastPublisher->destinationLength == 0) {
+        return fastPublisher->channel->send(fastPublisher->channel, fastPublisher->transportSettings, fastPublisher->message);
+    }
+    TRACE_STAGE(PUBLISH_TRACE_SEND_START);
+    ssize_t sent = sendto(fastPublisher->sockfd, fastPublisher->message->data, fastPublisher->message->length, 0,
+                          (struct sockaddr *) &fastPublisher->destination, fastPublisher->destinationLength);
+    TRACE_STAGE(PUBLISH_TRACE_SEND_END);
+    return sent < 0 ? UA_STATUSCODE_BADCONNECTIONCLOSED : UA_STATUSCODE_GOOD;
+}
+
+static int
+openPerfCounter(UA_UInt64 config, int groupFd) {
+    // open a disabled hardware counter of the calling thread in user space
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(struct perf_event_attr));
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.size = sizeof(struct perf_event_attr);
+    attributes.config = config;
+    attributes.disabled = groupFd < 0;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    attributes.read_format = PERF_FORMAT_GROUP;
+    return (int) syscall(__NR_perf_event_open, &attributes, 0, -1, groupFd, 0);
+}
+
+UA_Boolean
+openPerfCounters(PerfCounters *counters) {
+    // open the cycles and instructions counters as one group, returns false if the cpu or the kernel does not provide them
+    counters->cyclesFd = openPerfCounter(PERF_COUNT_HW_CPU_CYCLES, -1);
+    if (counters->cyclesFd < 0) {
+        return false;
+    }
+    counters->instructionsFd = openPerfCounter(PERF_COUNT_HW_INSTRUCTIONS, counters->cyclesFd);
+    if (counters->instructionsFd < 0) {
+        close(counters->cyclesFd);
+        return false;
+    }
+    return true;
+}
+
+void
+startPerfCounters(PerfCounters *counters) {
+    // reset and enable both counters at once
+    if (ioctl(counters->cyclesFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP) || ioctl(counters->cyclesFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "ioctl failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+}
+
+void
+stopPerfCounters(PerfCounters *counters, UA_UInt64 *cycles, UA_UInt64 *instructions) {
+    // disable both counters and return the counts since they were started
+    UA_UInt64 values[3];
+    if (ioctl(counters->cyclesFd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP) || read(counters->cyclesFd, values, sizeof(values)) != sizeof(values)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "reading the perf counters failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    *cycles = values[1];
+    *instructions = values[2];
+}
+
+void
+closePerfCounters(PerfCounters *counters) {
+    // close the counter group
+    close(counters->instructionsFd);
+    close(counters->cyclesFd);
+}
+
+static UA_Boolean *signalRunning = NULL;
+
 void
 signalHandler(int sig) {
-    // display info message and exit the process
+    // display info message and stop the run so that the logs are completed, a second signal exits the process
     UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "signalHandler triggered: %s", strsignal(sig));
+    if (signalRunning != NULL && *signalRunning) {
+        *signalRunning = false;
+        return;
+    }
     exit(EXIT_FAILURE);
 }
 
+void
+setupSignalHandler(UA_Boolean *running) {
+    // register the signal handler for the given run
+    signalRunning = running;
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
+}
+
 UA_StatusCode
 UA_PubSubManager_addRepeatedCallback(UA_Server *server, UA_ServerCallback callback, void *data, UA_Double interval_ms, UA_UInt64 *callbackId) {
     // this callback is called from framework, not used since own pubsub callback was implemented
@@ -182,14 +1390,96 @@ startServerThread(UA_Server *server, UA_Boolean *running, pthread_t *serverThrea
 }
 
 void
-addPubSubConnection(UA_Server *server, UA_String *transportProfile, UA_NetworkAddressUrlDataType *networkAddressUrl, UA_NodeId *connectionIdent) {
+startCooperativeServer(CooperativeServer *cooperative, UA_Server *server, UA_UInt64 margin_ns, Histogram *work) {
+    // start the server without a thread of its own, a few iterations before the rt thread runs give the first estimate of an iteration,
+    // it stands in for the older window so a slow first iteration ages out like any other outlier
+    memset(cooperative, 0, sizeof(CooperativeServer));
+    cooperative->server = server;
+    cooperative->margin_ns = margin_ns;
+    cooperative->work = work;
+    initHistogram(work, "ServerWork");
+    if (UA_Server_run_startup(server) != UA_STATUSCODE_GOOD) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_run_startup failed");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < COOPERATIVE_CALIBRATION_ITERATIONS; i++) {
+        UA_UInt64 startTimestamp = getCurrentTimestamp();
+        UA_Server_run_iterate(server, false);
+        UA_UInt64 duration = getCurrentTimestamp() - startTimestamp;
+        if (duration > cooperative->windowIterations_ns[1]) {
+            cooperative->windowIterations_ns[1] = duration;
+        }
+    }
+}
+
+UA_UInt64
+runCooperativeServer(CooperativeServer *cooperative, UA_UInt64 deadline) {
+    // iterate the server without waiting as long as the longest recent iteration still ends the margin before the deadline, returns the
+    // time spent in the server, an iteration that ends after the margin started nonetheless counts as late
+    UA_UInt64 estimate = cooperative->windowIterations_ns[0] > cooperative->windowIterations_ns[1] ? cooperative->windowIterations_ns[0]
+                                                                                                     : cooperative->windowIterations_ns[1];
+    UA_UInt64 budgetEnd = deadline > cooperative->margin_ns ? deadline - cooperative->margin_ns : 0;
+    UA_UInt64 startTimestamp = getCurrentTimestamp();
+    UA_UInt64 currentTimestamp = startTimestamp;
+    while (currentTimestamp + estimate <= budgetEnd) {
+        UA_Server_run_iterate(cooperative->server, false);
+        UA_UInt64 endTimestamp = getCurrentTimestamp();
+        UA_UInt64 duration = endTimestamp - currentTimestamp;
+        if (duration > cooperative->windowIterations_ns[0]) {
+            cooperative->windowIterations_ns[0] = duration;
+        }
+        if (duration > estimate) {
+            estimate = duration;
+        }
+        if (endTimestamp > budgetEnd) {
+            cooperative->lateIterations++;
+            if (endTimestamp - budgetEnd > cooperative->maxLate_ns) {
+                cooperative->maxLate_ns = endTimestamp - budgetEnd;
+            }
+        }
+        cooperative->iterations++;
+        currentTimestamp = endTimestamp;
+    }
+    UA_UInt64 work_ns = currentTimestamp - startTimestamp;
+    if (work_ns == 0) {
+        cooperative->idleCycles++;
+    }
+    recordHistogramValue(cooperative->work, work_ns);
+    cooperative->cycles++;
+    if (++cooperative->windowCycles == COOPERATIVE_WINDOW_CYCLES) {
+        // an outlier is forgotten after two windows, also when it kept the server from iterating at all
+        cooperative->windowIterations_ns[1] = cooperative->windowIterations_ns[0];
+        cooperative->windowIterations_ns[0] = 0;
+        cooperative->windowCycles = 0;
+    }
+    return work_ns;
+}
+
+UA_StatusCode
+stopCooperativeServer(CooperativeServer *cooperative) {
+    // log the server work done in the slack of the rt thread and shut the server down after the rt thread ended
+    Histogram *work = cooperative->work;
+    if (cooperative->cycles > 0) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "cooperative server: %llu iterations in %llu cycles, work per cycle mean %llu ns, "
+                                                          "max %llu ns, %llu cycles without slack for an iteration, %llu iterations ran up "
+                                                          "to %llu ns into the margin", (unsigned long long) cooperative->iterations,
+                    (unsigned long long) cooperative->cycles, (unsigned long long) (work->sum / work->count), (unsigned long long) work->max,
+                    (unsigned long long) cooperative->idleCycles, (unsigned long long) cooperative->lateIterations,
+                    (unsigned long long) cooperative->maxLate_ns);
+    }
+    return UA_Server_run_shutdown(cooperative->server);
+}
+
+void
+addPubSubConnection(UA_Server *server, UA_String *transportProfile, UA_NetworkAddressUrlDataType *networkAddressUrl, UA_UInt16 publisherId,
+                    UA_NodeId *connectionIdent) {
     // creates the pubsub connection with the specified transport layer
     UA_PubSubConnectionConfig connectionConfig;
     memset(&connectionConfig, 0, sizeof(UA_PubSubConnectionConfig));
     connectionConfig.name = UA_STRING("ConnectionConfig");
     connectionConfig.transportProfileUri = *transportProfile;
     connectionConfig.enabled = UA_TRUE;
-    connectionConfig.publisherId.numeric = PUBLISHER_ID;
+    connectionConfig.publisherId.numeric = publisherId;
     UA_Variant_setScalar(&connectionConfig.address, networkAddressUrl, &UA_TYPES[UA_TYPES_NETWORKADDRESSURLDATATYPE]);
     if (UA_Server_addPubSubConnection(server, &connectionConfig, connectionIdent) != UA_STATUSCODE_GOOD) {
         UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_addPubSubConnection failed");
@@ -202,19 +1492,88 @@ addPubSubConnection(UA_Server *server, UA_String *transportProfile, UA_NetworkAd
 }
 
 void
-startPubSubThread(UA_Server *server, void *(*routine)(void *), UA_UInt64 cycle_time_ns, void *variable, void *group, pthread_t *thread,
-                  UA_UInt64 **values, UA_UInt64 **timestamps, UA_UInt64 measurements, UA_Boolean *running, int cpu) {
-    // build arguments for pubsub thread and start it
-    *values = (UA_UInt64 *) UA_malloc(sizeof(UA_UInt64) * measurements);
-    if (*values == NULL) {
-        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_malloc failed: %s", strerror(errno));
+addPublishedDataSet(UA_Server *server, UA_NodeId *publishedDataSetIdent) {
+    // add a published data set to the server
+    UA_PublishedDataSetConfig publishedDataSetConfig;
+    memset(&publishedDataSetConfig, 0, sizeof(UA_PublishedDataSetConfig));
+    publishedDataSetConfig.publishedDataSetType = UA_PUBSUB_DATASET_PUBLISHEDITEMS;
+    publishedDataSetConfig.name = UA_STRING("PublishedDataSetConfig");
+    if (UA_Server_addPublishedDataSet(server, &publishedDataSetConfig, publishedDataSetIdent).addResult != UA_STATUSCODE_GOOD) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_addPublishedDataSet failed");
         exit(EXIT_FAILURE);
     }
-    *timestamps = (UA_UInt64 *) UA_malloc(sizeof(UA_UInt64) * measurements);
-    if (*timestamps == NULL) {
-        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_malloc failed: %s", strerror(errno));
+}
+
+void
+addStaticDataSetField(UA_Server *server, UA_NodeId publishedDataSetIdent, char *name, UA_DataValue **staticValueSource) {
+    // create a basic configuration for a field whose value the rt level reads straight from the static value source and add it to the
+    // published data set
+    UA_NodeId dataSetFieldIdent;
+    UA_DataSetFieldConfig dataSetFieldConfig;
+    memset(&dataSetFieldConfig, 0, sizeof(UA_DataSetFieldConfig));
+    dataSetFieldConfig.field.variable.fieldNameAlias = UA_STRING(name);
+    dataSetFieldConfig.field.variable.rtValueSource.rtFieldSourceEnabled = UA_TRUE;
+    dataSetFieldConfig.field.variable.rtValueSource.staticValueSource = staticValueSource;
+    if (UA_Server_addDataSetField(server, publishedDataSetIdent, &dataSetFieldConfig, &dataSetFieldIdent).result != UA_STATUSCODE_GOOD) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_addDataSetField failed");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void
+addWriterGroup(UA_Server *server, UA_UInt64 cycle_time_ns, UA_UInt16 writerGroupId, UA_NodeId connectionIdent, UA_NodeId *writerGroupIdent) {
+    // add a writer group to the pubsub connection
+    UA_WriterGroupConfig writerGroupConfig;
+    memset(&writerGroupConfig, 0, sizeof(UA_WriterGroupConfig));
+    writerGroupConfig.name = UA_STRING("WriterGroupConfig");
+    writerGroupConfig.publishingInterval = cycle_time_ns / 1000000.0;
+    writerGroupConfig.enabled = UA_FALSE;
+    writerGroupConfig.writerGroupId = writerGroupId;
+    writerGroupConfig.rtLevel = UA_PUBSUB_RT_FIXED_SIZE;
+    writerGroupConfig.encodingMimeType = UA_PUBSUB_ENCODING_UADP;
+    writerGroupConfig.messageSettings.encoding = UA_EXTENSIONOBJECT_DECODED;
+    writerGroupConfig.messageSettings.content.decoded.type = &UA_TYPES[UA_TYPES_UADPWRITERGROUPMESSAGEDATATYPE];
+    UA_UadpWriterGroupMessageDataType *writerGroupMessage = UA_UadpWriterGroupMessageDataType_new();
+    if (!writerGroupMessage) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_UadpWriterGroupMessageDataType_new failed");
+        exit(EXIT_FAILURE);
+    }
+    writerGroupMessage->networkMessageContentMask = NETWORK_MESSAGE_CONTENT_MASK;
+    writerGroupConfig.messageSettings.content.decoded.data = writerGroupMessage;
+    if (UA_Server_addWriterGroup(server, connectionIdent, &writerGroupConfig, writerGroupIdent) != UA_STATUSCODE_GOOD) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_addWriterGroup failed");
+        exit(EXIT_FAILURE);
+    }
+    UA_UadpWriterGroupMessageDataType_delete(writerGroupMessage);
+}
+
+void
+addDataSetWriter(UA_Server *server, UA_UInt16 dataSetWriterId, UA_NodeId writerGroupIdent, UA_NodeId publishedDataSetIdent) {
+    // add a data set writer to the writer group and create a link to the published data set
+    UA_NodeId dataSetWriterIdent;
+    UA_DataSetWriterConfig dataSetWriterConfig;
+    memset(&dataSetWriterConfig, 0, sizeof(UA_DataSetWriterConfig));
+    dataSetWriterConfig.name = UA_STRING("DataSetWriterConfig");
+    dataSetWriterConfig.dataSetWriterId = dataSetWriterId;
+    dataSetWriterConfig.keyFrameCount = 1;
+    if (UA_Server_addDataSetWriter(server, writerGroupIdent, publishedDataSetIdent, &dataSetWriterConfig, &dataSetWriterIdent) != UA_STATUSCODE_GOOD) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_addDataSetWriter failed");
+        exit(EXIT_FAILURE);
+    }
+    if (UA_Server_freezeWriterGroupConfiguration(server, writerGroupIdent) != UA_STATUSCODE_GOOD) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_freezeWriterGroupConfiguration failed");
+        exit(EXIT_FAILURE);
+    }
+    if (UA_Server_setWriterGroupOperational(server, writerGroupIdent) != UA_STATUSCODE_GOOD) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_setWriterGroupOperational failed");
         exit(EXIT_FAILURE);
     }
+}
+
+void
+startPubSubThread(UA_Server *server, void *(*routine)(void *), UA_UInt64 cycle_time_ns, void *variable, void *group, pthread_t *thread,
+                  LogRing *ring, UA_UInt64 measurements, UA_Boolean *running, PubSubOptions *options, int sockfd, int priority, int cpu) {
+    // build arguments for pubsub thread and start it
     ThreadArguments *args = (ThreadArguments *) UA_malloc(sizeof(ThreadArguments));
     if (args == NULL) {
         UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_malloc failed: %s", strerror(errno));
@@ -224,26 +1583,864 @@ startPubSubThread(UA_Server *server, void *(*routine)(void *), UA_UInt64 cycle_t
     args->data = group;
     args->cycle_time_ns = cycle_time_ns;
     args->variable = variable;
-    args->values = *values;
-    args->timestamps = *timestamps;
+    args->ring = ring;
     args->measurements = measurements;
     args->running = running;
-    startThread(thread, routine, args, RT_THREAD_PRIORITY, cpu);
+    args->options = options;
+    args->sockfd = sockfd;
+    startThread(thread, routine, args, priority, cpu);
 }
 
-void
-fillArguments(char **argv, UA_String *transportProfile, UA_NetworkAddressUrlDataType *networkAddressUrl,
-              int *port, UA_UInt64 *cycle_time_ns, UA_UInt64 *measurements) {
-    // fill the argument pointers with the parameters from the command line
-    *transportProfile = UA_STRING(TRANSPORT_PROFILE);
+static UA_Boolean
+parseUnsigned(const char *string, UA_UInt64 *value) {
+    // parse an unsigned decimal number and return false if the string contains anything else
+    char *end;
+    errno = 0;
+    unsigned long long temp = strtoull(string, &end, 10);
+    if (errno || end == string || *end != '\0') {
+        return false;
+    }
+    *value = temp;
+    return true;
+}
+
+static UA_Boolean
+parseSource(const char *string, SourceKey *source) {
+    // parse a source given as publisher id, writer group id and data set writer id separated by colons
+    unsigned int publisherId, writerGroupId, dataSetWriterId;
+    char end;
+    if (sscanf(string, "%u:%u:%u%c", &publisherId, &writerGroupId, &dataSetWriterId, &end) != 3 ||
+        publisherId > UINT16_MAX || writerGroupId > UINT16_MAX || dataSetWriterId > UINT16_MAX) {
+        return false;
+    }
+    source->publisherId = (UA_UInt16) publisherId;
+    source->writerGroupId = (UA_UInt16) writerGroupId;
+    source->dataSetWriterId = (UA_UInt16) dataSetWriterId;
+    return true;
+}
+
+static UA_Boolean
+parsePublishCpus(char *string, PubSubOptions *options) {
+    // parse the comma separated cpus of the publish threads, one thread is started per cpu
+    options->publishCpusSize = 0;
+    for (char *token = strtok(string, ","); token != NULL; token = strtok(NULL, ",")) {
+        UA_UInt64 cpu;
+        if (options->publishCpusSize == MAX_PUBLISH_THREADS || !parseUnsigned(token, &cpu) || cpu >= CPU_SETSIZE) {
+            return false;
+        }
+        options->publishCpus[options->publishCpusSize++] = (int) cpu;
+    }
+    return options->publishCpusSize > 0;
+}
+
+static UA_Boolean
+parseScheduledGroup(char *string, ScheduledGroup *group) {
+    // parse the period of a writer group and its optional phase within the period, both in ns
+    char *phase = strchr(string, ':');
+    group->phase_ns = 0;
+    if (phase != NULL) {
+        *phase = '\0';
+        if (!parseUnsigned(phase + 1, &group->phase_ns)) {
+            return false;
+        }
+    }
+    return parseUnsigned(string, &group->period_ns) && group->period_ns > 0 && group->phase_ns < group->period_ns;
+}
+
+static UA_Boolean
+parseSecurity(char *string, PubSubOptions *options) {
+    // parse the security mode and the file of the preconfigured keys separated by a comma, the file holds exactly the raw keys
+    char *separator = strchr(string, ',');
+    if (separator == NULL) {
+        return false;
+    }
+    *separator = '\0';
+    if (strcmp(string, "sign") == 0) {
+        options->securityMode = SECURITY_MODE_SIGN;
+    } else if (strcmp(string, "sign-and-encrypt") == 0) {
+        options->securityMode = SECURITY_MODE_SIGN_AND_ENCRYPT;
+    } else {
+        return false;
+    }
+    FILE *keyFile = fopen(separator + 1, "rb");
+    if (keyFile == NULL) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "fopen failed: %s", strerror(errno));
+        return false;
+    }
+    UA_Byte surplus;
+    UA_Boolean complete = fread(options->securityKeys, 1, SECURITY_KEYS_LENGTH, keyFile) == SECURITY_KEYS_LENGTH && fread(&surplus, 1, 1, keyFile) == 0;
+    fclose(keyFile);
+    if (!complete) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the key file has to hold the %d bytes of signing key, encrypting key and key nonce",
+                    SECURITY_KEYS_LENGTH);
+    }
+    return complete;
+}
+
+static void
+rejectOptions(const char *reason) {
+    // well-formed options that cannot work together are an error of the run, not a request for the usage
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "%s", reason);
+    exit(EXIT_FAILURE);
+}
+
+UA_Boolean
+fillArguments(int argc, char **argv, UA_String *transportProfile, UA_NetworkAddressUrlDataType *networkAddressUrl,
+              int *port, UA_UInt64 *cycle_time_ns, UA_UInt64 *measurements, PubSubOptions *options) {
+    // fill the argument pointers with the options and parameters from the command line, returns false if they are malformed and exits
+    // if well-formed options conflict
+    static const struct option longOptions[] = {
+            {"scalar-fields",     required_argument, NULL, 's'},
+            {"array-fields",      required_argument, NULL, 'a'},
+            {"array-length",      required_argument, NULL, 'l'},
+            {"blocking-receive",  no_argument,       NULL, 'b'},
+            {"busy-poll",         required_argument, NULL, 'p'},
+            {"txtime-offset",     required_argument, NULL, 't'},
+            {"tx-timestamps",     no_argument,       NULL, 'x'},
+            {"lock-memory",       no_argument,       NULL, 'm'},
+            {"warmup-cycles",     required_argument, NULL, 'w'},
+            {"xdp",               no_argument,       NULL, 'X'},
+            {"fast-publish",      no_argument,       NULL, 'f'},
+            {"benchmark-publish", required_argument, NULL, 'B'},
+            {"fast-subscribe",    no_argument,       NULL, 'F'},
+            {"benchmark-decode",  required_argument, NULL, 'D'},
+            {"generated-layout",  no_argument,       NULL, 'g'},
+            {"check-codec",       required_argument, NULL, 'C'},
+            {"batch-size",        required_argument, NULL, 'k'},
+            {"source",            required_argument, NULL, 'S'},
+            {"publish-cpus",      required_argument, NULL, 'P'},
+            {"writer-group",      required_argument, NULL, 'W'},
+            {"spin-wakeup",       no_argument,       NULL, 'o'},
+            {"overrun-policy",    required_argument, NULL, 'O'},
+            {"snapshot-readers",  required_argument, NULL, 'R'},
+            {"echo",              required_argument, NULL, 'E'},
+            {"redundant-path",    required_argument, NULL, 'r'},
+            {"trace-marker",      no_argument,       NULL, 'T'},
+            {"cooperative",       required_argument, NULL, 'c'},
+            {"security",          required_argument, NULL, 'y'},
+            {"check-security",    no_argument,       NULL, 'Y'},
+            {NULL, 0,                                NULL, 0}
+    };
+    memset(options, 0, sizeof(PubSubOptions));
+    int option;
+    UA_UInt64 value;
+    while ((option = getopt_long(argc, argv, "", longOptions, NULL)) != -1) {
+        switch (option) {
+            case 's':
+                if (!parseUnsigned(optarg, &value) || value > UINT16_MAX) {
+                    return false;
+                }
+                options->scalarFields = (UA_UInt32) value;
+                break;
+            case 'a':
+                if (!parseUnsigned(optarg, &value) || value > UINT16_MAX) {
+                    return false;
+                }
+                options->arrayFields = (UA_UInt32) value;
+                break;
+            case 'l':
+                if (!parseUnsigned(optarg, &value) || value > UINT16_MAX) {
+                    return false;
+                }
+                options->arrayLength = (UA_UInt32) value;
+                break;
+            case 'b':
+                options->blockingReceive = true;
+                break;
+            case 'p':
+                if (!parseUnsigned(optarg, &value) || value > INT32_MAX) {
+                    return false;
+                }
+                options->busyPoll_us = (UA_UInt32) value;
+                break;
+            case 't':
+                if (!parseUnsigned(optarg, &value)) {
+                    return false;
+                }
+                options->txtimeOffset_ns = value;
+                break;
+            case 'x':
+                options->txTimestamps = true;
+                break;
+            case 'm':
+                options->lockMemory = true;
+                break;
+            case 'w':
+                if (!parseUnsigned(optarg, &value)) {
+                    return false;
+                }
+                options->warmupCycles = value;
+                break;
+            case 'X':
+                options->xdp = true;
+                break;
+            case 'f':
+                options->fastPublish = true;
+                break;
+            case 'B':
+                if (!parseUnsigned(optarg, &value) || value == 0) {
+                    return false;
+                }
+                options->publishBenchmarkCycles = value;
+                break;
+            case 'F':
+                options->fastSubscribe = true;
+                break;
+            case 'D':
+                if (!parseUnsigned(optarg, &value) || value == 0) {
+                    return false;
+                }
+                options->decodeBenchmarkMessages = value;
+                break;
+            case 'g':
+                options->generatedLayout = true;
+                break;
+            case 'C':
+                if (!parseUnsigned(optarg, &value) || value == 0) {
+                    return false;
+                }
+                options->codecCheckIterations = value;
+                break;
+            case 'k':
+                if (!parseUnsigned(optarg, &value) || value == 0 || value > MAX_BATCH_SIZE) {
+                    return false;
+                }
+                options->batchSize = (UA_UInt32) value;
+                break;
+            case 'S':
+                if (options->sourcesSize == MAX_SOURCES || !parseSource(optarg, &options->sources[options->sourcesSize])) {
+                    return false;
+                }
+                for (size_t i = 0; i < options->sourcesSize; i++) {
+                    if (memcmp(&options->sources[i], &options->sources[options->sourcesSize], sizeof(SourceKey)) == 0) {
+                        return false;
+                    }
+                }
+                options->sourcesSize++;
+                break;
+            case 'P':
+                if (!parsePublishCpus(optarg, options)) {
+                    return false;
+                }
+                break;
+            case 'W':
+                if (options->writerGroupsSize == MAX_SCHEDULED_GROUPS || !parseScheduledGroup(optarg, &options->writerGroups[options->writerGroupsSize])) {
+                    return false;
+                }
+                options->writerGroupsSize++;
+                break;
+            case 'o':
+                options->spinWakeup = true;
+                break;
+            case 'O':
+                if (strcmp(optarg, "skip") == 0) {
+                    options->overrunPolicy = OVERRUN_POLICY_SKIP;
+                } else if (strcmp(optarg, "catch-up") == 0) {
+                    options->overrunPolicy = OVERRUN_POLICY_CATCH_UP;
+                } else {
+                    return false;
+                }
+                break;
+            case 'R':
+                if (!parseUnsigned(optarg, &value) || value == 0 || value > MAX_SNAPSHOT_READERS) {
+                    return false;
+                }
+                options->snapshotReaders = (size_t) value;
+                break;
+            case 'E':
+                options->echo = true;
+                options->echoAddress.url = UA_STRING(optarg);
+                break;
+            case 'r': {
+                char *separator = strchr(optarg, ',');
+                if (separator == NULL || separator == optarg) {
+                    return false;
+                }
+                options->redundant = true;
+                options->redundantAddress.networkInterface.data = (UA_Byte *) optarg;
+                options->redundantAddress.networkInterface.length = (size_t) (separator - optarg);
+                options->redundantAddress.url = UA_STRING(separator + 1);
+                break;
+            }
+            case 'T':
+                // the trace marker gets the cycles of the trace buffers, which only exist with the trace points compiled in
+                if (!TRACE_ENABLED) {
+                    return false;
+                }
+                options->traceMarker = true;
+                break;
+            case 'c':
+                if (!parseUnsigned(optarg, &value)) {
+                    return false;
+                }
+                options->cooperativeServer = true;
+                options->cooperativeMargin_ns = value;
+                break;
+            case 'y':
+                if (!parseSecurity(optarg, options)) {
+                    return false;
+                }
+                break;
+            case 'Y':
+                options->securityCheck = true;
+                break;
+            default:
+                return false;
+        }
+    }
+    if (options->sourcesSize == 0) {
+        // without sources the identifiers of the generated header are used
+        options->sources[0].publisherId = PUBLISHER_ID;
+        options->sources[0].writerGroupId = WRITER_GROUP_ID;
+        options->sources[0].dataSetWriterId = DATA_SET_WRITER_ID;
+        options->sourcesSize = 1;
+    }
+    if ((options->codecCheckIterations > 0 || options->securityCheck) && argc == optind) {
+        // the codec and security checks run without any network, server or measurement
+        return true;
+    }
+    if (argc - optind != 5 || (options->arrayFields > 0 && options->arrayLength == 0) ||
+        (options->generatedLayout && (options->scalarFields > 0 || options->arrayFields > 0))) {
+        return false;
+    }
+    if (options->batchSize > 1 && (options->txtimeOffset_ns > 0 || options->txTimestamps || options->generatedLayout || options->publishBenchmarkCycles > 0)) {
+        // launch times and tx timestamps belong to frames, not to the samples of a batch, and the schema has no batch fields
+        rejectOptions("--batch-size cannot be combined with --txtime-offset, --tx-timestamps, --generated-layout or --benchmark-publish");
+    }
+    if (options->publishCpusSize > 1 && (options->xdp || options->publishBenchmarkCycles > 0)) {
+        // the xdp socket takes the only queue of the interface and the benchmark measures a single path
+        rejectOptions("several --publish-cpus cannot be combined with --xdp or --benchmark-publish");
+    }
+    if (options->writerGroupsSize > 0 && (options->publishCpusSize > 1 || options->batchSize > 1 || options->txtimeOffset_ns > 0 ||
+                                          options->txTimestamps || options->publishBenchmarkCycles > 0)) {
+        // the scheduled writer groups share one thread and publish at the events of the schedule table
+        rejectOptions("--writer-group cannot be combined with several --publish-cpus, --batch-size, --txtime-offset, --tx-timestamps or "
+                      "--benchmark-publish");
+    }
+    argv += optind - 1;
     networkAddressUrl->networkInterface = UA_STRING(argv[1]);
     networkAddressUrl->url = UA_STRING(argv[2]);
+    if (isEthernetUrl(&networkAddressUrl->url)) {
+        // launch times are attached by a send hook for udp sockets only
+        if (options->txtimeOffset_ns > 0) {
+            rejectOptions("--txtime-offset needs a udp url");
+        }
+        *transportProfile = UA_STRING(ETHERNET_TRANSPORT_PROFILE);
+    } else {
+        *transportProfile = UA_STRING(UDP_TRANSPORT_PROFILE);
+    }
+    if (options->xdp && (!isEthernetUrl(&networkAddressUrl->url) || options->blockingReceive || options->txTimestamps)) {
+        // the xdp socket carries raw ethernet frames and bypasses the socket the kernel timestamps and ppoll rely on
+        rejectOptions("--xdp needs an ethernet url and cannot be combined with --blocking-receive or --tx-timestamps");
+    }
+    if (options->echo) {
+        // the echoes travel over the interface of the measured messages, the xdp socket would take the frames of both directions
+        if (options->xdp) {
+            rejectOptions("--echo cannot be combined with --xdp");
+        }
+        options->echoAddress.networkInterface = networkAddressUrl->networkInterface;
+        options->echoTransportProfile = UA_STRING(isEthernetUrl(&options->echoAddress.url) ? ETHERNET_TRANSPORT_PROFILE : UDP_TRANSPORT_PROFILE);
+    }
+    if (options->redundant) {
+        // the copies leave through the send hook of the primary channel, which the launch time hook and the xdp socket would take over
+        if (options->xdp || options->txtimeOffset_ns > 0) {
+            rejectOptions("--redundant-path cannot be combined with --xdp or --txtime-offset");
+        }
+        options->redundantTransportProfile = UA_STRING(isEthernetUrl(&options->redundantAddress.url) ? ETHERNET_TRANSPORT_PROFILE : UDP_TRANSPORT_PROFILE);
+    }
     *port = atoi(argv[3]);
-    unsigned long long temp;
-    sscanf(argv[4], "%llu", &temp);
-    *cycle_time_ns = temp;
-    sscanf(argv[5], "%llu", &temp);
-    *measurements = temp;
+    return parseUnsigned(argv[4], cycle_time_ns) && *cycle_time_ns > options->txtimeOffset_ns && *cycle_time_ns > options->cooperativeMargin_ns &&
+           parseUnsigned(argv[5], measurements);
+}
+
+void
+createDataSetLayout(DataSetLayout *layout, PubSubOptions *options) {
+    // build the field layout shared by publisher and subscriber, the first field is always the counter used for the measurements,
+    // the generated layout takes the fields of the schema the codec was generated from
+    static const UA_UInt16 scalarFieldTypes[] = {UA_TYPES_UINT32, UA_TYPES_INT16, UA_TYPES_DOUBLE, UA_TYPES_BOOLEAN,
+                                                 UA_TYPES_FLOAT, UA_TYPES_INT64, UA_TYPES_BYTE};
+    layout->generated = options->generatedLayout;
+    layout->batchSize = options->batchSize > 1 ? options->batchSize : 0;
+    layout->fieldsSize = layout->generated ? DATASET_FIELDS_SIZE : 1 + options->scalarFields + options->arrayFields + (layout->batchSize > 0 ? BATCH_FIELDS : 0);
+    layout->fields = (DataSetFieldLayout *) UA_calloc(layout->fieldsSize, sizeof(DataSetFieldLayout));
+    if (!layout->fields) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_calloc failed");
+        exit(EXIT_FAILURE);
+    }
+    if (layout->generated) {
+        for (size_t i = 0; i < layout->fieldsSize; i++) {
+            layout->fields[i].typeIndex = dataSetSchema[i].typeIndex;
+            layout->fields[i].arrayLength = dataSetSchema[i].arrayLength;
+            snprintf(layout->fields[i].name, FIELD_NAME_LENGTH, "%s", dataSetSchema[i].name);
+        }
+        return;
+    }
+    layout->fields[0].typeIndex = UA_TYPES_UINT64;
+    snprintf(layout->fields[0].name, FIELD_NAME_LENGTH, "%s", VARIABLE_NAME);
+    // the field counts are limited to UINT16_MAX, the casts tell the truncation check that the names fit
+    for (UA_UInt32 i = 0; i < options->scalarFields; i++) {
+        DataSetFieldLayout *field = &layout->fields[1 + i];
+        field->typeIndex = scalarFieldTypes[i % (sizeof(scalarFieldTypes) / sizeof(scalarFieldTypes[0]))];
+        snprintf(field->name, FIELD_NAME_LENGTH, "Scalar%u", (unsigned) (UA_UInt16) i);
+    }
+    for (UA_UInt32 i = 0; i < options->arrayFields; i++) {
+        DataSetFieldLayout *field = &layout->fields[1 + options->scalarFields + i];
+        field->typeIndex = ARRAY_FIELD_TYPE;
+        field->arrayLength = options->arrayLength;
+        snprintf(field->name, FIELD_NAME_LENGTH, "Array%u", (unsigned) (UA_UInt16) i);
+    }
+    if (layout->batchSize > 0) {
+        // the last two fields carry the values and timestamps of all samples of a batch, the counter holds the last sample
+        DataSetFieldLayout *batchFields = &layout->fields[layout->fieldsSize - BATCH_FIELDS];
+        batchFields[0].typeIndex = UA_TYPES_UINT64;
+        batchFields[0].arrayLength = layout->batchSize;
+        snprintf(batchFields[0].name, FIELD_NAME_LENGTH, "SampleValues");
+        batchFields[1].typeIndex = UA_TYPES_UINT64;
+        batchFields[1].arrayLength = layout->batchSize;
+        snprintf(batchFields[1].name, FIELD_NAME_LENGTH, "SampleTimes");
+    }
+}
+
+void
+deleteDataSetLayout(DataSetLayout *layout) {
+    // free the memory of the field layout
+    UA_free(layout->fields);
+    layout->fields = NULL;
+    layout->fieldsSize = 0;
+}
+
+size_t
+getDataSetPayloadSize(DataSetLayout *layout) {
+    // returns the number of value bytes of all fields without any encoding overhead
+    size_t payloadSize = 0;
+    for (size_t i = 0; i < layout->fieldsSize; i++) {
+        UA_UInt32 elements = layout->fields[i].arrayLength > 0 ? layout->fields[i].arrayLength : 1;
+        payloadSize += elements * UA_TYPES[layout->fields[i].typeIndex].memSize;
+    }
+    return payloadSize;
+}
+
+void
+setDerivedSample(UA_UInt16 typeIndex, void *values, UA_UInt32 index, UA_UInt64 sample) {
+    // store the sample as element index of a field of the given type, the publisher derives its fields from the counter this way and the
+    // subscriber checks them the same way
+    switch (typeIndex) {
+        case UA_TYPES_BOOLEAN:
+            ((UA_Boolean *) values)[index] = (UA_Boolean) (sample & 1);
+            break;
+        case UA_TYPES_BYTE:
+            ((UA_Byte *) values)[index] = (UA_Byte) sample;
+            break;
+        case UA_TYPES_INT16:
+            ((UA_Int16 *) values)[index] = (UA_Int16) sample;
+            break;
+        case UA_TYPES_UINT32:
+            ((UA_UInt32 *) values)[index] = (UA_UInt32) sample;
+            break;
+        case UA_TYPES_INT64:
+            ((UA_Int64 *) values)[index] = (UA_Int64) sample;
+            break;
+        case UA_TYPES_UINT64:
+            ((UA_UInt64 *) values)[index] = sample;
+            break;
+        case UA_TYPES_FLOAT:
+            ((UA_Float *) values)[index] = (UA_Float) sample;
+            break;
+        case UA_TYPES_DOUBLE:
+            ((UA_Double *) values)[index] = (UA_Double) sample;
+            break;
+        default:
+            break;
+    }
+}
+
+static void
+fillRandomValues(DataSetValues *values) {
+    // fill all fields with random bytes, booleans only take the values the decoders produce
+    memset(values, 0, sizeof(DataSetValues));
+    for (size_t i = 0; i < DATASET_FIELDS_SIZE; i++) {
+        const DataSetFieldSchema *field = &dataSetSchema[i];
+        UA_Byte *value = (UA_Byte *) values + field->valueOffset;
+        size_t elements = field->arrayLength > 0 ? field->arrayLength : 1;
+        for (size_t j = 0; j < elements * UA_TYPES[field->typeIndex].memSize; j++) {
+            value[j] = (UA_Byte) (field->typeIndex == UA_TYPES_BOOLEAN ? rand() & 1 : rand());
+        }
+    }
+}
+
+static UA_Boolean
+encodeDataSetVariants(const DataSetValues *values, UA_Byte *encoded) {
+    // encode all fields with the generic variant encoder the writer group uses, returns false if they do not fill the field region
+    UA_Byte *position = encoded;
+    for (size_t i = 0; i < DATASET_FIELDS_SIZE; i++) {
+        const DataSetFieldSchema *field = &dataSetSchema[i];
+        void *value = (void *) ((const UA_Byte *) values + field->valueOffset);
+        UA_Variant variant;
+        if (field->arrayLength > 0) {
+            UA_Variant_setArray(&variant, value, field->arrayLength, &UA_TYPES[field->typeIndex]);
+        } else {
+            UA_Variant_setScalar(&variant, value, &UA_TYPES[field->typeIndex]);
+        }
+        if (UA_Variant_encodeBinary(&variant, &position, &encoded[DATASET_ENCODED_SIZE]) != UA_STATUSCODE_GOOD) {
+            return false;
+        }
+    }
+    return position == &encoded[DATASET_ENCODED_SIZE];
+}
+
+static UA_Boolean
+decodeDataSetVariants(const UA_ByteString *encoded, DataSetValues *values) {
+    // decode all fields with the generic variant decoder the reader uses, returns false if a field does not have the type of the schema
+    size_t offset = 0;
+    for (size_t i = 0; i < DATASET_FIELDS_SIZE; i++) {
+        const DataSetFieldSchema *field = &dataSetSchema[i];
+        UA_Variant variant;
+        UA_Variant_init(&variant);
+        if (UA_Variant_decodeBinary(encoded, &offset, &variant) != UA_STATUSCODE_GOOD) {
+            return false;
+        }
+        UA_Boolean matches = variant.type == &UA_TYPES[field->typeIndex] &&
+                             (field->arrayLength > 0 ? !UA_Variant_isScalar(&variant) && variant.arrayLength == field->arrayLength : UA_Variant_isScalar(&variant));
+        if (matches) {
+            memcpy((UA_Byte *) values + field->valueOffset, variant.data, (field->arrayLength > 0 ? field->arrayLength : 1) * variant.type->memSize);
+        }
+        UA_Variant_deleteMembers(&variant);
+        if (!matches) {
+            return false;
+        }
+    }
+    return offset == encoded->length;
+}
+
+UA_Boolean
+checkGeneratedCodec(UA_UInt64 iterations) {
+    // round trip random values through the generated codec and compare the bytes and values with the generic variant codec of open62541,
+    // then time both codecs on the same data set
+    static const char *codecNames[] = {"generic encode", "generated encode", "generic decode", "generated decode"};
+    DataSetValues values, generatedValues, genericValues;
+    UA_Byte generated[DATASET_ENCODED_SIZE], generic[DATASET_ENCODED_SIZE];
+    UA_ByteString genericMessage = {DATASET_ENCODED_SIZE, generic};
+    srand(1);
+    for (UA_UInt64 i = 0; i < iterations; i++) {
+        fillRandomValues(&values);
+        memset(&generatedValues, 0, sizeof(DataSetValues));
+        memset(&genericValues, 0, sizeof(DataSetValues));
+        encodeDataSetFields(&values, generated);
+        if (!encodeDataSetVariants(&values, generic) || memcmp(generated, generic, DATASET_ENCODED_SIZE) != 0 ||
+            !decodeDataSetFields(generated, &generatedValues) || !decodeDataSetVariants(&genericMessage, &genericValues) ||
+            memcmp(&generatedValues, &values, sizeof(DataSetValues)) != 0 || memcmp(&genericValues, &values, sizeof(DataSetValues)) != 0) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "round trip %llu of the generated codec differs from the generic codec",
+                        (unsigned long long) i);
+            return false;
+        }
+    }
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "%llu round trips of %d fields in %d bytes match the generic codec",
+                (unsigned long long) iterations, DATASET_FIELDS_SIZE, DATASET_ENCODED_SIZE);
+    // the sink keeps the compiler from dropping the codec calls of the timed loops
+    volatile UA_Byte sink = 0;
+    for (size_t codec = 0; codec < sizeof(codecNames) / sizeof(codecNames[0]); codec++) {
+        UA_UInt64 startTimestamp = getCurrentTimestamp();
+        for (UA_UInt64 i = 0; i < iterations; i++) {
+            values.counter = i;
+            switch (codec) {
+                case 0:
+                    encodeDataSetVariants(&values, generic);
+                    sink = generic[1];
+                    break;
+                case 1:
+                    encodeDataSetFields(&values, generated);
+                    sink = generated[1];
+                    break;
+                case 2:
+                    decodeDataSetVariants(&genericMessage, &genericValues);
+                    sink = (UA_Byte) genericValues.counter;
+                    break;
+                default:
+                    decodeDataSetFields(generated, &generatedValues);
+                    sink = (UA_Byte) generatedValues.counter;
+                    break;
+            }
+        }
+        UA_UInt64 duration = getCurrentTimestamp() - startTimestamp;
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "%s: %.1f ns per data set", codecNames[codec], (UA_Double) duration / (UA_Double) iterations);
+    }
+    (void) sink;
+    return true;
+}
+
+// the trace buffer the cycle of the calling thread is recorded into, the hooks of the channels find it here
+static __thread TraceBuffer *currentTrace = NULL;
+
+static UA_UInt64
+getTraceTimestamp(void) {
+    // returns the current timestamp of the trace clock, which the clock synchronization does not slew and ftrace can use as trace_clock
+    struct timespec timespecTimestamp;
+    clock_gettime(TRACE_CLOCK, &timespecTimestamp);
+    return timespecToTimestamp(&timespecTimestamp);
+}
+
+void
+createTraceBuffer(TraceBuffer *trace, const char *name, const char *const *stageNames, size_t stagesSize, PubSubOptions *options) {
+    // allocate and touch the records of an empty trace buffer, the cycles are written to the trace marker of ftrace as well if enabled
+    memset(trace, 0, sizeof(TraceBuffer));
+    trace->name = name;
+    trace->stageNames = stageNames;
+    trace->stagesSize = stagesSize;
+    trace->records = (TraceRecord *) allocateCacheLineAligned(TRACE_BUFFER_CYCLES * sizeof(TraceRecord));
+    memset(trace->records, 0, TRACE_BUFFER_CYCLES * sizeof(TraceRecord));
+    trace->current = &trace->records[0];
+    trace->markerFd = -1;
+    if (options->traceMarker) {
+        trace->markerFd = open(TRACE_MARKER_FILE_NAME, O_WRONLY);
+        if (trace->markerFd < 0) {
+            trace->markerFd = open(LEGACY_TRACE_MARKER_FILE_NAME, O_WRONLY);
+        }
+        if (trace->markerFd < 0) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "opening the trace marker failed: %s", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+void
+deleteTraceBuffer(TraceBuffer *trace) {
+    // free the records and close the trace marker
+    if (trace->markerFd >= 0) {
+        close(trace->markerFd);
+    }
+    free(trace->records);
+    trace->records = NULL;
+}
+
+void
+beginTraceCycle(TraceBuffer *trace) {
+    // start the record of the next cycle of the calling thread, a cycle that was not ended is overwritten, the offset of the log clock to
+    // the trace clock is taken anew every cycle as the clock synchronization slews the log clock
+    currentTrace = trace;
+    trace->current = &trace->records[trace->head & (TRACE_BUFFER_CYCLES - 1)];
+    memset(trace->current->stamps, 0, sizeof(trace->current->stamps));
+    UA_UInt64 traceTimestamp = getTraceTimestamp();
+    trace->clockOffset = (UA_Int64) getCurrentTimestamp() - (UA_Int64) traceTimestamp;
+}
+
+void
+traceStage(size_t stage) {
+    // timestamp the end of a stage in the current cycle of the calling thread, threads without a trace buffer record nothing
+    if (currentTrace != NULL) {
+        currentTrace->current->stamps[stage] = getTraceTimestamp();
+    }
+}
+
+void
+traceStageAt(size_t stage, UA_UInt64 timestamp) {
+    // record a timestamp of the log clock taken elsewhere, like a deadline or a kernel receive timestamp, on the trace clock
+    if (currentTrace != NULL && timestamp > 0) {
+        currentTrace->current->stamps[stage] = (UA_UInt64) ((UA_Int64) timestamp - currentTrace->clockOffset);
+    }
+}
+
+static void
+writeTraceMarker(TraceBuffer *trace, TraceRecord *record) {
+    // write the stages of the cycle as one line into the ftrace buffer, with trace_clock mono_raw the stamps line up with the kernel events
+    char line[TRACE_MARKER_LENGTH];
+    int length = snprintf(line, TRACE_MARKER_LENGTH, "opcua_%s: cycle=%llu value=%llu", trace->name,
+                          (unsigned long long) record->cycle, (unsigned long long) record->value);
+    for (size_t i = 0; i < trace->stagesSize && length < TRACE_MARKER_LENGTH; i++) {
+        if (record->stamps[i] > 0) {
+            length += snprintf(&line[length], (size_t) (TRACE_MARKER_LENGTH - length), " %s=%llu", trace->stageNames[i],
+                               (unsigned long long) record->stamps[i]);
+        }
+    }
+    if (length >= TRACE_MARKER_LENGTH) {
+        length = TRACE_MARKER_LENGTH - 1;
+    }
+    if (write(trace->markerFd, line, (size_t) length) != length) {
+        trace->droppedMarkers++;
+    }
+}
+
+void
+endTraceCycle(UA_UInt64 cycle, UA_UInt64 value) {
+    // keep the record of the current cycle of the calling thread, the oldest record is overwritten once the buffer is full
+    TraceBuffer *trace = currentTrace;
+    if (trace == NULL) {
+        return;
+    }
+    trace->current->cycle = cycle;
+    trace->current->value = value;
+    if (trace->markerFd >= 0) {
+        writeTraceMarker(trace, trace->current);
+    }
+    trace->head++;
+}
+
+void
+writeTraceFile(TraceBuffer *trace, const char *fileName) {
+    // write the records in the buffer from the oldest to the newest behind a header with the stage names, after the traced thread ended
+    TraceFileHeader header;
+    UA_UInt64 records = trace->head < TRACE_BUFFER_CYCLES ? trace->head : TRACE_BUFFER_CYCLES;
+    UA_UInt64 first = trace->head - records;
+    memset(&header, 0, sizeof(TraceFileHeader));
+    memcpy(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_FILE_VERSION;
+    header.stagesSize = (UA_UInt32) trace->stagesSize;
+    header.records = records;
+    header.overwrittenRecords = first;
+    for (size_t i = 0; i < trace->stagesSize; i++) {
+        snprintf(header.stageNames[i], FIELD_NAME_LENGTH, "%s", trace->stageNames[i]);
+    }
+    FILE *traceFile = fopen(fileName, "wb");
+    if (traceFile == NULL) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "fopen failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    UA_Boolean written = fwrite(&header, sizeof(TraceFileHeader), 1, traceFile) == 1;
+    for (UA_UInt64 i = first; i < trace->head && written; i++) {
+        written = fwrite(&trace->records[i & (TRACE_BUFFER_CYCLES - 1)], sizeof(TraceRecord), 1, traceFile) == 1;
+    }
+    if (!written || fclose(traceFile)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "writing the trace file failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "%llu traced cycles written to %s, %llu overwritten, %llu trace markers dropped",
+                (unsigned long long) records, fileName, (unsigned long long) first, (unsigned long long) trace->droppedMarkers);
+}
+
+void
+initHistogram(Histogram *histogram, const char *name) {
+    // reset the histogram, the name is the browse name of its object in the statistics folder
+    memset(histogram, 0, sizeof(Histogram));
+    histogram->name = name;
+    histogram->min = UINT64_MAX;
+}
+
+static size_t
+getHistogramIndex(UA_UInt64 value) {
+    // map a value to its log linear bucket, every power of two is split into HISTOGRAM_HALF_SUB_BUCKETS sub buckets
+    if (value >= (1ULL << HISTOGRAM_MAX_VALUE_BITS)) {
+        value = (1ULL << HISTOGRAM_MAX_VALUE_BITS) - 1;
+    }
+    if (value < (1ULL << HISTOGRAM_SUB_BUCKET_BITS)) {
+        return (size_t) value;
+    }
+    unsigned shift = (unsigned) (63 - __builtin_clzll(value)) - (HISTOGRAM_SUB_BUCKET_BITS - 1);
+    return shift * HISTOGRAM_HALF_SUB_BUCKETS + (size_t) (value >> shift);
+}
+
+static UA_UInt64
+getHistogramBucketMax(size_t index) {
+    // returns the highest value that is mapped to the bucket
+    if (index < (1U << HISTOGRAM_SUB_BUCKET_BITS)) {
+        return index;
+    }
+    unsigned shift = (unsigned) (index / HISTOGRAM_HALF_SUB_BUCKETS) - 1;
+    UA_UInt64 lowest = (UA_UInt64) (index - shift * HISTOGRAM_HALF_SUB_BUCKETS) << shift;
+    return lowest + (1ULL << shift) - 1;
+}
+
+void
+recordHistogramValue(Histogram *histogram, UA_UInt64 value) {
+    // add a value in constant time, only called by a single thread while the server thread may read the histogram at any time
+    size_t index = getHistogramIndex(value);
+    __atomic_store_n(&histogram->counts[index], histogram->counts[index] + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&histogram->count, histogram->count + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&histogram->sum, histogram->sum + value, __ATOMIC_RELAXED);
+    if (value < histogram->min) {
+        __atomic_store_n(&histogram->min, value, __ATOMIC_RELAXED);
+    }
+    if (value > histogram->max) {
+        __atomic_store_n(&histogram->max, value, __ATOMIC_RELAXED);
+    }
+}
+
+UA_UInt64
+getHistogramPercentile(Histogram *histogram, UA_Double percentile) {
+    // returns the value at the given percentile (0 - 100) with the precision of the buckets using the nearest rank method
+    UA_UInt64 count = __atomic_load_n(&histogram->count, __ATOMIC_RELAXED);
+    UA_UInt64 max = __atomic_load_n(&histogram->max, __ATOMIC_RELAXED);
+    UA_Double exactRank = percentile / 100.0 * (UA_Double) count;
+    UA_UInt64 rank = (UA_UInt64) exactRank;
+    if ((UA_Double) rank < exactRank || rank == 0) {
+        rank++;
+    }
+    UA_UInt64 cumulativeCount = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS && count > 0; i++) {
+        cumulativeCount += __atomic_load_n(&histogram->counts[i], __ATOMIC_RELAXED);
+        if (cumulativeCount >= rank) {
+            UA_UInt64 bucketMax = getHistogramBucketMax(i);
+            return bucketMax < max ? bucketMax : max;
+        }
+    }
+    return max;
+}
+
+static void
+updateStatistics(UA_Server *server, void *data) {
+    // repeated server callback that writes a snapshot of all histograms into their variables
+    Statistics *statistics = (Statistics *) data;
+    for (size_t i = 0; i < statistics->histogramsSize; i++) {
+        Histogram *histogram = &statistics->histograms[i];
+        UA_UInt64 count = __atomic_load_n(&histogram->count, __ATOMIC_RELAXED);
+        UA_UInt64 values[HISTOGRAM_STATISTICS] = {
+                count,
+                count > 0 ? __atomic_load_n(&histogram->min, __ATOMIC_RELAXED) : 0,
+                __atomic_load_n(&histogram->max, __ATOMIC_RELAXED),
+                count > 0 ? __atomic_load_n(&histogram->sum, __ATOMIC_RELAXED) / count : 0,
+                getHistogramPercentile(histogram, 50.0),
+                getHistogramPercentile(histogram, 99.0),
+                getHistogramPercentile(histogram, 99.9)
+        };
+        for (size_t j = 0; j < HISTOGRAM_STATISTICS; j++) {
+            UA_Variant variant;
+            UA_Variant_setScalar(&variant, &values[j], &UA_TYPES[UA_TYPES_UINT64]);
+            UA_Server_writeValue(server, histogram->statisticIds[j], variant);
+        }
+    }
+}
+
+void
+addStatistics(UA_Server *server, Statistics *statistics) {
+    // add an object with the statistic variables of every histogram to the statistics folder and update them periodically
+    static char *statisticNames[HISTOGRAM_STATISTICS] = {"Count", "Min", "Max", "Mean", "P50", "P99", "P999"};
+    UA_NodeId folderId;
+    UA_ObjectAttributes folderAttributes = UA_ObjectAttributes_default;
+    folderAttributes.displayName = UA_LOCALIZEDTEXT("en-US", STATISTICS_FOLDER_NAME);
+    if (UA_Server_addObjectNode(server, UA_NODEID_NULL, UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER), UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                UA_QUALIFIEDNAME(VARIABLE_NAMESPACE_INDEX, STATISTICS_FOLDER_NAME), UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                folderAttributes, NULL, &folderId) != UA_STATUSCODE_GOOD) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_addObjectNode failed");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < statistics->histogramsSize; i++) {
+        Histogram *histogram = &statistics->histograms[i];
+        UA_NodeId histogramId;
+        UA_ObjectAttributes histogramAttributes = UA_ObjectAttributes_default;
+        histogramAttributes.displayName = UA_LOCALIZEDTEXT("en-US", (char *) histogram->name);
+        if (UA_Server_addObjectNode(server, UA_NODEID_NULL, folderId, UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                    UA_QUALIFIEDNAME(VARIABLE_NAMESPACE_INDEX, (char *) histogram->name), UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                    histogramAttributes, NULL, &histogramId) != UA_STATUSCODE_GOOD) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_addObjectNode failed");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t j = 0; j < HISTOGRAM_STATISTICS; j++) {
+            UA_UInt64 startValue = 0;
+            UA_VariableAttributes variableAttributes = UA_VariableAttributes_default;
+            UA_Variant_setScalar(&variableAttributes.value, &startValue, &UA_TYPES[UA_TYPES_UINT64]);
+            variableAttributes.dataType = UA_TYPES[UA_TYPES_UINT64].typeId;
+            variableAttributes.displayName = UA_LOCALIZEDTEXT("en-US", statisticNames[j]);
+            if (UA_Server_addVariableNode(server, UA_NODEID_NULL, histogramId, UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                          UA_QUALIFIEDNAME(VARIABLE_NAMESPACE_INDEX, statisticNames[j]),
+                                          UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), variableAttributes, NULL,
+                                          &histogram->statisticIds[j]) != UA_STATUSCODE_GOOD) {
+                UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_addVariableNode failed");
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    if (UA_Server_addRepeatedCallback(server, updateStatistics, statistics, STATISTICS_UPDATE_INTERVAL_MS, NULL) != UA_STATUSCODE_GOOD) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_addRepeatedCallback failed");
+        exit(EXIT_FAILURE);
+    }
 }
 
 UA_Server *
@@ -256,12 +2453,14 @@ createServer(int port) {
     }
     UA_ServerConfig *config = UA_Server_getConfig(server);
     UA_ServerConfig_setMinimal(config, port, NULL);
-    config->pubsubTransportLayers = (UA_PubSubTransportLayer *) UA_calloc(1, sizeof(UA_PubSubTransportLayer));
+    config->pubsubTransportLayers = (UA_PubSubTransportLayer *) UA_calloc(2, sizeof(UA_PubSubTransportLayer));
     if (!config->pubsubTransportLayers) {
         UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_calloc failed");
         exit(EXIT_FAILURE);
     }
     config->pubsubTransportLayers[0] = UA_PubSubTransportLayerUDPMP();
     config->pubsubTransportLayersSize++;
+    config->pubsubTransportLayers[1] = UA_PubSubTransportLayerEthernet();
+    config->pubsubTransportLayersSize++;
     return server;
 }
@@ -4,7 +4,32 @@
 #include "open62541.c"
 
 #include <pthread.h>
+#include <getopt.h>
+#include <poll.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
 #include <linux/ip.h>
+#include <linux/sockios.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <malloc.h>
+#include <fcntl.h>
+#include <netpacket/packet.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <net/ethernet.h>
+#include <linux/if_xdp.h>
+#include <linux/if_link.h>
+#include <linux/bpf.h>
+#include <linux/perf_event.h>
+#include <sys/random.h>
+
+// generated by generate_dataset.py from dataset.json, holds the identifiers and the codec of the data set
+#include "opcua_dataset.h"
+
+// the uadp message security, signing and encryption with the preconfigured keys of PubSub-Aes128-CTR
+#include "opcua_security.h"
 
 // do not change defines
 #define NS_IN_ONE_SECOND 1000000000ULL
@@ -15,40 +40,475 @@
 #define CLOCK CLOCK_REALTIME
 #define SOCKET_PRIORITY 7
 #define TYPE_OF_SERVICE (IPTOS_MINCOST | IPTOS_RELIABILITY | IPTOS_THROUGHPUT)
-#define PUBLISH_LOG_FILE_NAME "publish.csv"
-#define SUBSCRIBE_LOG_FILE_NAME "subscribe.csv"
-#define TRANSPORT_PROFILE "http://opcfoundation.org/UA-Profile/Transport/pubsub-udp-uadp"
+#define PUBLISH_LOG_FILE_NAME "publish.bin"
+#define SUBSCRIBE_LOG_FILE_NAME "subscribe.bin"
+#define LOG_FILE_MAGIC "OPCUALOG"
+#define LOG_FILE_VERSION 1
+#define CACHE_LINE_SIZE 64
+#define HISTOGRAM_SUB_BUCKET_BITS 6
+#define HISTOGRAM_MAX_VALUE_BITS 40
+#define HISTOGRAM_HALF_SUB_BUCKETS (1U << (HISTOGRAM_SUB_BUCKET_BITS - 1))
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_VALUE_BITS - HISTOGRAM_SUB_BUCKET_BITS + 2) * HISTOGRAM_HALF_SUB_BUCKETS)
+#define HISTOGRAM_STATISTICS 7
+#define STATISTICS_FOLDER_NAME "Statistics"
+#define UDP_TRANSPORT_PROFILE "http://opcfoundation.org/UA-Profile/Transport/pubsub-udp-uadp"
+#define ETHERNET_TRANSPORT_PROFILE "http://opcfoundation.org/UA-Profile/Transport/pubsub-eth-uadp"
+#define ETHERNET_URL_PREFIX "opc.eth://"
 #define VARIABLE_NAMESPACE_INDEX 1
+#define ERROR_QUEUE_PAYLOAD_SIZE 64
+#define FIELD_NAME_LENGTH 16
+#define UADP_ETHERTYPE 0xB62C
+#define VLAN_TAG_LENGTH 4
+#define XDP_MAX_QUEUES 64
+#define VARIANT_ARRAY_ENCODING_MASK 0x80
+#define BATCH_FIELDS 2
+#define UADP_VERSION 0x01
+#define UADP_FLAGS_PUBLISHERID 0x10
+#define UADP_FLAGS_GROUPHEADER 0x20
+#define UADP_FLAGS_PAYLOADHEADER 0x40
+#define UADP_FLAGS_EXTENDEDFLAGS1 0x80
+#define UADP_EXTENDEDFLAGS1_PUBLISHERIDTYPE 0x07
+#define UADP_EXTENDEDFLAGS1_DATASETCLASSID 0x08
+#define UADP_EXTENDEDFLAGS1_SECURITY 0x10
+#define UADP_EXTENDEDFLAGS1_TIMESTAMP 0x20
+#define UADP_EXTENDEDFLAGS1_PICOSECONDS 0x40
+#define UADP_EXTENDEDFLAGS1_EXTENDEDFLAGS2 0x80
+#define UADP_EXTENDEDFLAGS2_CHUNK_OR_NOT_DATASET 0x1D
+#define UADP_EXTENDEDFLAGS2_PROMOTEDFIELDS 0x02
+#define UADP_GROUPFLAGS_WRITERGROUPID 0x01
+#define UADP_GROUPFLAGS_GROUPVERSION 0x02
+#define UADP_GROUPFLAGS_NETWORKMESSAGENUMBER 0x04
+#define UADP_GROUPFLAGS_SEQUENCENUMBER 0x08
+#define UADP_DATASETCLASSID_LENGTH 16
+#define UADP_TIMESTAMP_LENGTH 8
+#define UADP_PICOSECONDS_LENGTH 2
+#define NODE_NAME_LENGTH 32
+#define PUBLISH_THREAD_LOG_FILE_NAME "publish%zu.bin"
+#define ECHO_LOG_FILE_NAME "echo.bin"
+#define ECHO_FIELD_NAME "Echo"
+#define TRACE_FILE_MAGIC "OPCUATRC"
+#define TRACE_FILE_VERSION 1
+#define TRACE_CLOCK CLOCK_MONOTONIC_RAW
+#define TRACE_MAX_STAGES 8
+#define PUBLISH_TRACE_FILE_NAME "publish_trace.bin"
+#define PUBLISH_THREAD_TRACE_FILE_NAME "publish%u_trace.bin"
+#define SUBSCRIBE_TRACE_FILE_NAME "subscribe_trace.bin"
+#define TRACE_MARKER_FILE_NAME "/sys/kernel/tracing/trace_marker"
+#define LEGACY_TRACE_MARKER_FILE_NAME "/sys/kernel/debug/tracing/trace_marker"
 
 // change defines as you wish
 #define VARIABLE_START_VALUE 0
 #define VARIABLE_NAME "Counter"
-#define PUBLISHER_ID 1
-#define WRITER_GROUP_ID 1
-#define DATA_SET_WRITER_ID 1
+#define RECEIVE_DEADLINE_CYCLES 2
+#define ARRAY_FIELD_TYPE UA_TYPES_FLOAT
+// the number of records in the log ring has to be a power of two
+#define LOG_RING_SIZE 65536
+#define LOG_WRITER_PERIOD_NS 10000000ULL
+#define TX_TIMESTAMP_WINDOW 64
+#define STATISTICS_UPDATE_INTERVAL_MS 1000.0
+#define HEAP_PREFAULT_SIZE (64 * 1024 * 1024)
+#define STACK_PREFAULT_SIZE (512 * 1024)
+#define RECEIVE_BUFFER_SIZE 2048
+#define RECEIVE_TIMEOUT_US 1000
+#define TEMPLATE_VECTOR_SIZE 16
+// the umem holds XDP_RING_SIZE frames for receiving and as many for sending, the ring size has to be a power of two
+#define XDP_RING_SIZE 128
+#define XDP_FRAME_SIZE 2048
+#define XDP_QUEUE_ID 0
+// the sample values and timestamps of a batch have to fit into one frame
+#define MAX_BATCH_SIZE 64
+// the subscriber dispatches the messages of up to MAX_SOURCES publishers through a hash table with twice as many slots
+#define MAX_SOURCES 256
+// every publish thread owns a connection, a writer group and a log writer thread
+#define MAX_PUBLISH_THREADS 8
+// every publish thread hooks the send of its connection, the xdp socket and the subscriber hook one channel each
+#define MAX_HOOKED_CHANNELS (MAX_PUBLISH_THREADS + 2)
+// the schedule table of the writer groups of one thread holds every publish of a hyperperiod
+#define MAX_SCHEDULED_GROUPS 8
+#define MAX_SCHEDULE_EVENTS 4096
+#define SCHEDULE_CALIBRATION_PUBLISHES 32
+// the spin wakeup sleeps until the percentile of the wake up latencies of the last window plus the margin before the deadline
+#define SPIN_WAKEUP_INITIAL_OFFSET_NS 100000
+#define SPIN_WAKEUP_PERCENTILE 99.9
+#define SPIN_WAKEUP_MARGIN_NS 5000
+#define SPIN_WAKEUP_WINDOW 1000
+// threads that hammer the latest sample snapshots of the subscriber with reads to check their consistency
+#define MAX_SNAPSHOT_READERS 8
+// the publisher keeps the send times of the last ECHO_WINDOW values to match the echoes of the subscriber, a power of two, and waits
+// ECHO_DRAIN_CYCLES cycles for the last echoes after its last publish
+#define ECHO_WINDOW 1024
+#define ECHO_DRAIN_CYCLES 100
+// every frame leaves over the primary and the redundant path, the subscriber remembers the first copies of the last DUPLICATE_WINDOW
+// messages of a source to drop the second ones, the window has to fit into the bits of a UA_UInt64
+#define REDUNDANT_PATHS 2
+#define DUPLICATE_WINDOW 64
+// the trace buffer of a thread keeps the stage timestamps of its last TRACE_BUFFER_CYCLES cycles, a power of two, a trace marker line
+// holds all stages of one cycle
+#define TRACE_BUFFER_CYCLES 65536
+#define TRACE_MARKER_LENGTH 512
+// the cooperative server stops iterating its longest iteration of the last two windows of cycles plus the margin before the next deadline,
+// the startup calibration stands in for the older window until the first window of cycles is done
+#define COOPERATIVE_WINDOW_CYCLES 1000
+#define COOPERATIVE_CALIBRATION_ITERATIONS 32
+
+// the trace points of the publish and subscribe loops are only compiled in with -DPUBSUB_TRACE, without it they are dead code
+#ifdef PUBSUB_TRACE
+#define TRACE_ENABLED 1
+#else
+#define TRACE_ENABLED 0
+#endif
+#define TRACE_BEGIN(trace) do { if (TRACE_ENABLED) beginTraceCycle(trace); } while (0)
+#define TRACE_STAGE(stage) do { if (TRACE_ENABLED) traceStage(stage); } while (0)
+#define TRACE_STAGE_AT(stage, timestamp) do { if (TRACE_ENABLED) traceStageAt(stage, timestamp); } while (0)
+#define TRACE_END(cycle, value) do { if (TRACE_ENABLED) endTraceCycle(cycle, value); } while (0)
+
+typedef struct {
+    UA_UInt16 typeIndex;
+    UA_UInt32 arrayLength;
+    char name[FIELD_NAME_LENGTH];
+} DataSetFieldLayout;
+
+typedef struct {
+    size_t fieldsSize;
+    DataSetFieldLayout *fields;
+    UA_Boolean generated;
+    UA_UInt32 batchSize;
+} DataSetLayout;
+
+typedef struct {
+    UA_UInt16 publisherId;
+    UA_UInt16 writerGroupId;
+    UA_UInt16 dataSetWriterId;
+} SourceKey;
+
+typedef struct {
+    UA_UInt64 period_ns;
+    UA_UInt64 phase_ns;
+} ScheduledGroup;
+
+typedef enum {
+    PUBLISH_TRACE_DEADLINE,
+    PUBLISH_TRACE_WAKE_UP,
+    PUBLISH_TRACE_PREPARED,
+    PUBLISH_TRACE_SEND_START,
+    PUBLISH_TRACE_SEND_END,
+    PUBLISH_TRACE_PUBLISHED,
+    PUBLISH_TRACE_STAGES
+} PublishTraceStage;
+
+typedef enum {
+    SUBSCRIBE_TRACE_ARRIVAL,
+    SUBSCRIBE_TRACE_WAKE_UP,
+    SUBSCRIBE_TRACE_RECEIVED,
+    SUBSCRIBE_TRACE_DECODED,
+    SUBSCRIBE_TRACE_WRITTEN,
+    SUBSCRIBE_TRACE_SNAPSHOT,
+    SUBSCRIBE_TRACE_LOGGED,
+    SUBSCRIBE_TRACE_STAGES
+} SubscribeTraceStage;
+
+typedef enum {
+    OVERRUN_POLICY_SKIP,
+    OVERRUN_POLICY_CATCH_UP
+} OverrunPolicy;
+
+typedef struct {
+    UA_UInt32 scalarFields;
+    UA_UInt32 arrayFields;
+    UA_UInt32 arrayLength;
+    UA_Boolean blockingReceive;
+    UA_UInt32 busyPoll_us;
+    UA_UInt64 txtimeOffset_ns;
+    UA_Boolean txTimestamps;
+    UA_Boolean lockMemory;
+    UA_UInt64 warmupCycles;
+    UA_Boolean xdp;
+    UA_Boolean fastPublish;
+    UA_UInt64 publishBenchmarkCycles;
+    UA_Boolean fastSubscribe;
+    UA_UInt64 decodeBenchmarkMessages;
+    UA_Boolean generatedLayout;
+    UA_UInt64 codecCheckIterations;
+    UA_UInt32 batchSize;
+    SourceKey sources[MAX_SOURCES];
+    size_t sourcesSize;
+    int publishCpus[MAX_PUBLISH_THREADS];
+    size_t publishCpusSize;
+    ScheduledGroup writerGroups[MAX_SCHEDULED_GROUPS];
+    size_t writerGroupsSize;
+    UA_Boolean spinWakeup;
+    OverrunPolicy overrunPolicy;
+    size_t snapshotReaders;
+    UA_Boolean echo;
+    UA_NetworkAddressUrlDataType echoAddress;
+    UA_String echoTransportProfile;
+    UA_Boolean redundant;
+    UA_NetworkAddressUrlDataType redundantAddress;
+    UA_String redundantTransportProfile;
+    UA_Boolean traceMarker;
+    UA_Boolean cooperativeServer;
+    UA_UInt64 cooperativeMargin_ns;
+    SecurityMode securityMode;
+    UA_Byte securityKeys[SECURITY_KEYS_LENGTH];
+    UA_Boolean securityCheck;
+} PubSubOptions;
+
+typedef struct {
+    UA_UInt64 value;
+    UA_UInt64 timestamp;
+    UA_UInt64 processedTimestamp;
+    UA_UInt64 scheduledTimestamp;
+    UA_UInt64 txTimestamp;
+    UA_UInt64 hardwareTxTimestamp;
+    UA_UInt64 sampleTimestamp;
+    UA_UInt64 source;
+    UA_UInt64 cycle;
+    UA_UInt64 path;
+} LogRecord;
+
+typedef struct {
+    UA_UInt64 cycle;
+    UA_UInt64 value;
+    UA_UInt64 stamps[TRACE_MAX_STAGES];
+} TraceRecord;
+
+typedef struct {
+    char magic[8];
+    UA_UInt32 version;
+    UA_UInt32 stagesSize;
+    UA_UInt64 records;
+    UA_UInt64 overwrittenRecords;
+    char stageNames[TRACE_MAX_STAGES][FIELD_NAME_LENGTH];
+} TraceFileHeader;
+
+typedef struct {
+    const char *name;
+    const char *const *stageNames;
+    size_t stagesSize;
+    TraceRecord *records;
+    TraceRecord *current;
+    UA_UInt64 head;
+    UA_Int64 clockOffset;
+    int markerFd;
+    UA_UInt64 droppedMarkers;
+} TraceBuffer;
+
+typedef struct {
+    char magic[8];
+    UA_UInt32 version;
+    UA_UInt32 recordSize;
+    UA_UInt64 cycle_time_ns;
+    UA_UInt64 records;
+    UA_UInt64 droppedRecords;
+} LogFileHeader;
+
+typedef struct {
+    UA_UInt64 head __attribute__((aligned(CACHE_LINE_SIZE)));
+    UA_UInt64 droppedRecords;
+    UA_UInt64 tail __attribute__((aligned(CACHE_LINE_SIZE)));
+    UA_Boolean closed;
+    LogRecord *records __attribute__((aligned(CACHE_LINE_SIZE)));
+} LogRing;
+
+typedef struct {
+    int sockfd;
+    struct sockaddr_storage destination;
+    socklen_t destinationLength;
+    UA_Int64 taiOffset;
+    UA_UInt64 launchTime;
+} ChannelSendContext;
+
+typedef struct {
+    UA_UInt32 *producer;
+    UA_UInt32 *consumer;
+    void *descriptors;
+    void *map;
+    size_t mapLength;
+} XdpRing;
+
+typedef struct {
+    int fd;
+    UA_Byte *umem;
+    XdpRing fill;
+    XdpRing completion;
+    XdpRing rx;
+    XdpRing tx;
+    UA_UInt32 txFrame;
+    UA_UInt32 txOutstanding;
+    unsigned int ifindex;
+    int mapFd;
+    int programFd;
+    int linkFd;
+    UA_Byte header[ETHER_HDR_LEN + VLAN_TAG_LENGTH];
+    size_t headerLength;
+} XdpSocket;
+
+typedef struct {
+    UA_PubSubChannel *channel;
+    UA_StatusCode (*send)(UA_PubSubChannel *channel, UA_ExtensionObject *transportSettings, const UA_ByteString *buf);
+    UA_StatusCode (*receive)(UA_PubSubChannel *channel, UA_ByteString *message, UA_ExtensionObject *transportSettings, UA_UInt32 timeout);
+    ChannelSendContext *context;
+    XdpSocket *xdp;
+    UA_PubSubChannel *redundantChannel;
+    SecureChannel *secure;
+} ChannelHook;
+
+typedef struct {
+    UA_Byte *target;
+    const void *source;
+    size_t length;
+    UA_UInt16 *sequenceNumber;
+} BufferPatch;
+
+typedef struct {
+    UA_PubSubChannel *channel;
+    UA_ExtensionObject *transportSettings;
+    UA_ByteString *message;
+    BufferPatch *patches;
+    size_t patchesSize;
+    const DataSetValues *generatedValues;
+    UA_Byte *fieldRegion;
+    int sockfd;
+    struct sockaddr_storage destination;
+    socklen_t destinationLength;
+} FastPublisher;
+
+typedef struct {
+    int cyclesFd;
+    int instructionsFd;
+} PerfCounters;
+
+typedef struct {
+    const char *name;
+    UA_UInt64 counts[HISTOGRAM_BUCKETS];
+    UA_UInt64 count;
+    UA_UInt64 min;
+    UA_UInt64 max;
+    UA_UInt64 sum;
+    UA_NodeId statisticIds[HISTOGRAM_STATISTICS];
+} Histogram;
+
+typedef struct {
+    Histogram *histograms;
+    size_t histogramsSize;
+} Statistics;
+
+typedef struct {
+    UA_UInt64 offset_ns;
+    UA_UInt64 maxOffset_ns;
+    Histogram window;
+    UA_UInt64 wakeUpLatency_ns;
+    UA_UInt64 spinTime_ns;
+    UA_UInt64 deadlineError_ns;
+} SpinWaiter;
+
+typedef struct {
+    UA_Server *server;
+    UA_UInt64 margin_ns;
+    UA_UInt64 windowIterations_ns[2];
+    UA_UInt64 windowCycles;
+    Histogram *work;
+    UA_UInt64 cycles;
+    UA_UInt64 iterations;
+    UA_UInt64 idleCycles;
+    UA_UInt64 lateIterations;
+    UA_UInt64 maxLate_ns;
+} CooperativeServer;
+
+typedef struct {
+    OverrunPolicy policy;
+    UA_UInt64 startEpoch_ns;
+    UA_UInt64 cycle_time_ns;
+    UA_UInt64 cycle;
+    UA_UInt64 overruns;
+    UA_UInt64 lateCycles;
+    UA_UInt64 missedCycles;
+    UA_UInt64 maxOverrun_ns;
+} CycleAccount;
 
 typedef struct {
     UA_Server *server;
     void *data;
     UA_UInt64 cycle_time_ns;
     void *variable;
-    UA_UInt64 *values;
-    UA_UInt64 *timestamps;
+    LogRing *ring;
     UA_UInt64 measurements;
     UA_Boolean *running;
+    PubSubOptions *options;
+    int sockfd;
 } ThreadArguments;
 
 void
 usage(char *name);
 
+void *
+allocateCacheLineAligned(size_t size);
+
+void
+createLogRing(LogRing *ring);
+
+void
+deleteLogRing(LogRing *ring);
+
+UA_Boolean
+pushLogRecord(LogRing *ring, const LogRecord *record);
+
+void
+startLogWriterThread(LogRing *ring, char *fileName, UA_UInt64 cycle_time_ns, pthread_t *thread, int cpu);
+
 void
-writeLogFile(char *fileName, UA_UInt64 *values, UA_UInt64 *timestamps, UA_UInt64 measurements);
+stopLogWriterThread(LogRing *ring, pthread_t thread);
+
+UA_UInt64
+timespecToTimestamp(const struct timespec *timespecTimestamp);
 
 UA_UInt64
 getCurrentTimestamp(void);
 
 void
-waitUntilNextEvent(UA_UInt64 ns_offset, UA_UInt64 cycle_time_ns);
+sleepUntilTimestamp(UA_UInt64 timestamp);
+
+void
+initSpinWaiter(SpinWaiter *waiter, UA_UInt64 maxOffset_ns);
+
+UA_UInt64
+waitUntilTimestamp(SpinWaiter *waiter, UA_UInt64 timestamp);
+
+UA_UInt64
+getNextEventTimestamp(UA_UInt64 ns_offset, UA_UInt64 cycle_time_ns);
+
+UA_UInt64
+waitUntilNextEvent(SpinWaiter *waiter, UA_UInt64 ns_offset, UA_UInt64 cycle_time_ns);
+
+void
+initCycleAccount(CycleAccount *account, OverrunPolicy policy, UA_UInt64 ns_offset, UA_UInt64 cycle_time_ns);
+
+UA_UInt64
+getCycleDeadline(CycleAccount *account);
+
+UA_UInt64
+finishCycle(CycleAccount *account, UA_UInt64 finishedTimestamp);
+
+void
+reportCycleAccount(CycleAccount *account, const char *threadName);
+
+UA_Int64
+getTaiOffset(void);
+
+void
+lockMemory(void);
+
+void
+prefaultStack(void);
+
+void
+getThreadPageFaults(UA_UInt64 *minorFaults, UA_UInt64 *majorFaults);
+
+UA_UInt64
+getThreadCpuTime(void);
+
+void
+reportThreadPageFaults(const char *threadName, UA_UInt64 measurementMinorFaults, UA_UInt64 measurementMajorFaults);
 
 void
 startThread(pthread_t *thread, void *(*routine)(void *), ThreadArguments *args, int priority, int cpu);
@@ -57,11 +517,66 @@ UA_StatusCode
 waitForThreadTermination(pthread_t thread, UA_Boolean useReturnValue);
 
 void
-setupSocket(int sockfd);
+setupSocket(int sockfd, UA_NetworkAddressUrlDataType *networkAddressUrl, PubSubOptions *options);
+
+UA_Boolean
+isEthernetUrl(const UA_String *url);
+
+UA_Boolean
+waitForMessage(int sockfd, UA_UInt64 deadline, UA_UInt64 *arrivalTimestamp);
+
+int
+waitForFirstMessage(const int *sockfds, size_t sockfdsSize, UA_UInt64 deadline, UA_UInt64 *arrivalTimestamp);
+
+UA_UInt64
+drainErrorQueue(int sockfd, LogRecord *window, UA_UInt64 sentFrames);
+
+void
+hookChannelSend(UA_PubSubChannel *channel, ChannelSendContext *context, UA_NetworkAddressUrlDataType *networkAddressUrl);
+
+void
+hookRedundantChannel(UA_PubSubChannel *channel, UA_PubSubChannel *redundantChannel);
+
+void
+createXdpSocket(XdpSocket *xdp, UA_PubSubChannel *channel, UA_NetworkAddressUrlDataType *networkAddressUrl);
+
+void
+deleteXdpSocket(XdpSocket *xdp);
+
+UA_Boolean
+hasXdpFrame(XdpSocket *xdp);
+
+size_t
+getFixedVariantHeaderSize(const UA_Byte *encoded, const UA_DataType *type, size_t arrayLength);
+
+void
+createFastPublisher(FastPublisher *fastPublisher, UA_WriterGroup *writerGroup, UA_PubSubChannel *channel,
+                    UA_NetworkAddressUrlDataType *networkAddressUrl, PubSubOptions *options, const DataSetValues *generatedValues);
+
+void
+deleteFastPublisher(FastPublisher *fastPublisher);
+
+UA_StatusCode
+fastPublish(FastPublisher *fastPublisher);
+
+UA_Boolean
+openPerfCounters(PerfCounters *counters);
+
+void
+startPerfCounters(PerfCounters *counters);
+
+void
+stopPerfCounters(PerfCounters *counters, UA_UInt64 *cycles, UA_UInt64 *instructions);
+
+void
+closePerfCounters(PerfCounters *counters);
 
 void
 signalHandler(int sig);
 
+void
+setupSignalHandler(UA_Boolean *running);
+
 UA_StatusCode
 UA_PubSubManager_addRepeatedCallback(UA_Server *server, UA_ServerCallback callback, void *data, UA_Double interval_ms, UA_UInt64 *callbackId);
 
@@ -75,15 +590,91 @@ void
 startServerThread(UA_Server *server, UA_Boolean *running, pthread_t *serverThread, int cpu);
 
 void
-addPubSubConnection(UA_Server *server, UA_String *transportProfile, UA_NetworkAddressUrlDataType *networkAddressUrl, UA_NodeId *connectionIdent);
+startCooperativeServer(CooperativeServer *cooperative, UA_Server *server, UA_UInt64 margin_ns, Histogram *work);
+
+UA_UInt64
+runCooperativeServer(CooperativeServer *cooperative, UA_UInt64 deadline);
+
+UA_StatusCode
+stopCooperativeServer(CooperativeServer *cooperative);
+
+void
+addPubSubConnection(UA_Server *server, UA_String *transportProfile, UA_NetworkAddressUrlDataType *networkAddressUrl, UA_UInt16 publisherId,
+                    UA_NodeId *connectionIdent);
+
+void
+addPublishedDataSet(UA_Server *server, UA_NodeId *publishedDataSetIdent);
+
+void
+addStaticDataSetField(UA_Server *server, UA_NodeId publishedDataSetIdent, char *name, UA_DataValue **staticValueSource);
+
+void
+addWriterGroup(UA_Server *server, UA_UInt64 cycle_time_ns, UA_UInt16 writerGroupId, UA_NodeId connectionIdent, UA_NodeId *writerGroupIdent);
+
+void
+addDataSetWriter(UA_Server *server, UA_UInt16 dataSetWriterId, UA_NodeId writerGroupIdent, UA_NodeId publishedDataSetIdent);
 
 void
 startPubSubThread(UA_Server *server, void *(*routine)(void *), UA_UInt64 cycle_time_ns, void *variable, void *group, pthread_t *thread,
-                  UA_UInt64 **values, UA_UInt64 **timestamps, UA_UInt64 measurements, UA_Boolean *running, int cpu);
+                  LogRing *ring, UA_UInt64 measurements, UA_Boolean *running, PubSubOptions *options, int sockfd, int priority, int cpu);
+
+UA_Boolean
+fillArguments(int argc, char **argv, UA_String *transportProfile, UA_NetworkAddressUrlDataType *networkAddressUrl,
+              int *port, UA_UInt64 *cycle_time_ns, UA_UInt64 *measurements, PubSubOptions *options);
+
+void
+createDataSetLayout(DataSetLayout *layout, PubSubOptions *options);
+
+void
+deleteDataSetLayout(DataSetLayout *layout);
+
+size_t
+getDataSetPayloadSize(DataSetLayout *layout);
+
+void
+setDerivedSample(UA_UInt16 typeIndex, void *values, UA_UInt32 index, UA_UInt64 sample);
+
+UA_Boolean
+checkGeneratedCodec(UA_UInt64 iterations);
+
+void
+createTraceBuffer(TraceBuffer *trace, const char *name, const char *const *stageNames, size_t stagesSize, PubSubOptions *options);
+
+void
+deleteTraceBuffer(TraceBuffer *trace);
+
+void
+beginTraceCycle(TraceBuffer *trace);
+
+void
+traceStage(size_t stage);
+
+void
+traceStageAt(size_t stage, UA_UInt64 timestamp);
+
+void
+endTraceCycle(UA_UInt64 cycle, UA_UInt64 value);
+
+void
+writeTraceFile(TraceBuffer *trace, const char *fileName);
+
+void
+hookTraceChannel(UA_PubSubChannel *channel);
+
+void
+hookSecureChannel(UA_PubSubChannel *channel, SecureChannel *secure);
+
+void
+initHistogram(Histogram *histogram, const char *name);
+
+void
+recordHistogramValue(Histogram *histogram, UA_UInt64 value);
+
+UA_UInt64
+getHistogramPercentile(Histogram *histogram, UA_Double percentile);
 
 void
-fillArguments(char **argv, UA_String *transportProfile, UA_NetworkAddressUrlDataType *networkAddressUrl,
-              int *port, UA_UInt64 *cycle_time_ns, UA_UInt64 *measurements);
+addStatistics(UA_Server *server, Statistics *statistics);
 
 UA_Server *
 createServer(int port);
@@ -0,0 +1,957 @@
+#include "opcua_pubsub.h"
+
+static const UA_UInt32 sha256InitialState[SHA256_STATE_WORDS] = {
+        0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+};
+
+static const UA_UInt32 sha256RoundConstants[64] = {
+        0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+        0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+        0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+        0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+        0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+        0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+        0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+        0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+static UA_UInt32
+loadBigEndian(const UA_Byte *data) {
+    // read a big endian word, the byte order of sha-256 and of the aes state
+    return (UA_UInt32) data[0] << 24 | (UA_UInt32) data[1] << 16 | (UA_UInt32) data[2] << 8 | (UA_UInt32) data[3];
+}
+
+static void
+storeBigEndian(UA_Byte *data, UA_UInt32 value) {
+    // write a big endian word
+    data[0] = (UA_Byte) (value >> 24);
+    data[1] = (UA_Byte) (value >> 16);
+    data[2] = (UA_Byte) (value >> 8);
+    data[3] = (UA_Byte) value;
+}
+
+static UA_UInt32
+rotateRight(UA_UInt32 value, unsigned int bits) {
+    // rotate a word, bits has to be between 1 and 31
+    return value >> bits | value << (32 - bits);
+}
+
+static void
+compressSha256Block(UA_UInt32 *state, const UA_Byte *block) {
+    // run the 64 rounds of sha-256 over one block and add the result to the state
+    UA_UInt32 schedule[64];
+    for (size_t i = 0; i < 16; i++) {
+        schedule[i] = loadBigEndian(&block[4 * i]);
+    }
+    for (size_t i = 16; i < 64; i++) {
+        UA_UInt32 sigma0 = rotateRight(schedule[i - 15], 7) ^ rotateRight(schedule[i - 15], 18) ^ schedule[i - 15] >> 3;
+        UA_UInt32 sigma1 = rotateRight(schedule[i - 2], 17) ^ rotateRight(schedule[i - 2], 19) ^ schedule[i - 2] >> 10;
+        schedule[i] = schedule[i - 16] + sigma0 + schedule[i - 7] + sigma1;
+    }
+    UA_UInt32 a = state[0], b = state[1], c = state[2], d = state[3], e = state[4], f = state[5], g = state[6], h = state[7];
+    for (size_t i = 0; i < 64; i++) {
+        UA_UInt32 temp1 = h + (rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25)) + ((e & f) ^ (~e & g)) + sha256RoundConstants[i] +
+                          schedule[i];
+        UA_UInt32 temp2 = (rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp1;
+        d = c;
+        c = b;
+        b = a;
+        a = temp1 + temp2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+static void
+finishSha256(UA_UInt32 *state, const UA_Byte *data, size_t length, size_t absorbedLength, UA_Byte *digest) {
+    // absorb the data into a state that already absorbed absorbedLength bytes in whole blocks, pad the message and write the digest, the
+    // work only depends on the lengths
+    size_t blocksLength = length - length % SHA256_BLOCK_SIZE;
+    size_t tailLength = length - blocksLength;
+    UA_Byte tail[2 * SHA256_BLOCK_SIZE];
+    for (size_t i = 0; i < blocksLength; i += SHA256_BLOCK_SIZE) {
+        compressSha256Block(state, &data[i]);
+    }
+    // the padding is a one bit, zeros and the bit length of the message, which takes a second block if the tail leaves no room for it
+    size_t tailBlocks = tailLength + 1 + sizeof(UA_UInt64) > SHA256_BLOCK_SIZE ? 2 : 1;
+    UA_UInt64 bits = (UA_UInt64) (absorbedLength + length) * 8;
+    memset(tail, 0, sizeof(tail));
+    memcpy(tail, &data[blocksLength], tailLength);
+    tail[tailLength] = 0x80;
+    for (size_t i = 0; i < sizeof(UA_UInt64); i++) {
+        tail[tailBlocks * SHA256_BLOCK_SIZE - 1 - i] = (UA_Byte) (bits >> (8 * i));
+    }
+    for (size_t i = 0; i < tailBlocks; i++) {
+        compressSha256Block(state, &tail[i * SHA256_BLOCK_SIZE]);
+    }
+    for (size_t i = 0; i < SHA256_STATE_WORDS; i++) {
+        storeBigEndian(&digest[4 * i], state[i]);
+    }
+}
+
+static void
+signMessage(SecureChannel *secure, const UA_Byte *data, size_t length, UA_Byte *signature) {
+    // write the hmac-sha256 of the data, the states after the inner and the outer key block were computed once with the channel
+    UA_UInt32 state[SHA256_STATE_WORDS];
+    UA_Byte innerDigest[SECURITY_SIGNATURE_LENGTH];
+    memcpy(state, secure->innerState, sizeof(state));
+    finishSha256(state, data, length, SHA256_BLOCK_SIZE, innerDigest);
+    memcpy(state, secure->outerState, sizeof(state));
+    finishSha256(state, innerDigest, sizeof(innerDigest), SHA256_BLOCK_SIZE, signature);
+}
+
+static UA_UInt32
+loadLittleEndian(const UA_Byte *data) {
+    // read a little endian word, the byte order of the bitsliced aes state
+    return (UA_UInt32) data[0] | (UA_UInt32) data[1] << 8 | (UA_UInt32) data[2] << 16 | (UA_UInt32) data[3] << 24;
+}
+
+static void
+storeLittleEndian(UA_Byte *data, UA_UInt32 value) {
+    // write a little endian word
+    data[0] = (UA_Byte) value;
+    data[1] = (UA_Byte) (value >> 8);
+    data[2] = (UA_Byte) (value >> 16);
+    data[3] = (UA_Byte) (value >> 24);
+}
+
+static void
+swapAesBits(UA_UInt32 *x, UA_UInt32 *y, UA_UInt32 mask, unsigned int shift) {
+    // exchange the bits of x outside the mask with the bits of y inside it, one step of the transposition into the bitsliced state
+    UA_UInt32 a = *x, b = *y;
+    *x = (a & mask) | (b & mask) << shift;
+    *y = (a >> shift & mask) | (b & ~mask);
+}
+
+static void
+transposeAesState(UA_UInt32 *q) {
+    // move between two blocks held in the little endian words q[0], q[2], q[4], q[6] and q[1], q[3], q[5], q[7] and the bitsliced state,
+    // where q[i] holds bit i of all 32 bytes, the transposition is its own inverse
+    for (size_t i = 0; i < 8; i += 2) {
+        swapAesBits(&q[i], &q[i + 1], 0x55555555, 1);
+    }
+    for (size_t i = 0; i < 8; i += 4) {
+        swapAesBits(&q[i], &q[i + 2], 0x33333333, 2);
+        swapAesBits(&q[i + 1], &q[i + 3], 0x33333333, 2);
+    }
+    for (size_t i = 0; i < 4; i++) {
+        swapAesBits(&q[i], &q[i + 4], 0x0F0F0F0F, 4);
+    }
+}
+
+static void
+substituteAesState(UA_UInt32 *q) {
+    // run all 32 bytes of the bitsliced state through the s-box circuit of Boyar and Peralta, "A new combinational logic minimization
+    // technique with applications to cryptology", as in the aes_ct of BearSSL, x0 and s0 are the highest bits
+    UA_UInt32 x0 = q[7], x1 = q[6], x2 = q[5], x3 = q[4], x4 = q[3], x5 = q[2], x6 = q[1], x7 = q[0];
+    // top linear transformation
+    UA_UInt32 y14 = x3 ^ x5;
+    UA_UInt32 y13 = x0 ^ x6;
+    UA_UInt32 y9 = x0 ^ x3;
+    UA_UInt32 y8 = x0 ^ x5;
+    UA_UInt32 t0 = x1 ^ x2;
+    UA_UInt32 y1 = t0 ^ x7;
+    UA_UInt32 y4 = y1 ^ x3;
+    UA_UInt32 y12 = y13 ^ y14;
+    UA_UInt32 y2 = y1 ^ x0;
+    UA_UInt32 y5 = y1 ^ x6;
+    UA_UInt32 y3 = y5 ^ y8;
+    UA_UInt32 t1 = x4 ^ y12;
+    UA_UInt32 y15 = t1 ^ x5;
+    UA_UInt32 y20 = t1 ^ x1;
+    UA_UInt32 y6 = y15 ^ x7;
+    UA_UInt32 y10 = y15 ^ t0;
+    UA_UInt32 y11 = y20 ^ y9;
+    UA_UInt32 y7 = x7 ^ y11;
+    UA_UInt32 y17 = y10 ^ y11;
+    UA_UInt32 y19 = y10 ^ y8;
+    UA_UInt32 y16 = t0 ^ y11;
+    UA_UInt32 y21 = y13 ^ y16;
+    UA_UInt32 y18 = x0 ^ y16;
+    // non-linear section, the inversion in GF(2^4)
+    UA_UInt32 t2 = y12 & y15;
+    UA_UInt32 t3 = y3 & y6;
+    UA_UInt32 t4 = t3 ^ t2;
+    UA_UInt32 t5 = y4 & x7;
+    UA_UInt32 t6 = t5 ^ t2;
+    UA_UInt32 t7 = y13 & y16;
+    UA_UInt32 t8 = y5 & y1;
+    UA_UInt32 t9 = t8 ^ t7;
+    UA_UInt32 t10 = y2 & y7;
+    UA_UInt32 t11 = t10 ^ t7;
+    UA_UInt32 t12 = y9 & y11;
+    UA_UInt32 t13 = y14 & y17;
+    UA_UInt32 t14 = t13 ^ t12;
+    UA_UInt32 t15 = y8 & y10;
+    UA_UInt32 t16 = t15 ^ t12;
+    UA_UInt32 t17 = t4 ^ t14;
+    UA_UInt32 t18 = t6 ^ t16;
+    UA_UInt32 t19 = t9 ^ t14;
+    UA_UInt32 t20 = t11 ^ t16;
+    UA_UInt32 t21 = t17 ^ y20;
+    UA_UInt32 t22 = t18 ^ y19;
+    UA_UInt32 t23 = t19 ^ y21;
+    UA_UInt32 t24 = t20 ^ y18;
+    UA_UInt32 t25 = t21 ^ t22;
+    UA_UInt32 t26 = t21 & t23;
+    UA_UInt32 t27 = t24 ^ t26;
+    UA_UInt32 t28 = t25 & t27;
+    UA_UInt32 t29 = t28 ^ t22;
+    UA_UInt32 t30 = t23 ^ t24;
+    UA_UInt32 t31 = t22 ^ t26;
+    UA_UInt32 t32 = t31 & t30;
+    UA_UInt32 t33 = t32 ^ t24;
+    UA_UInt32 t34 = t23 ^ t33;
+    UA_UInt32 t35 = t27 ^ t33;
+    UA_UInt32 t36 = t24 & t35;
+    UA_UInt32 t37 = t36 ^ t34;
+    UA_UInt32 t38 = t27 ^ t36;
+    UA_UInt32 t39 = t29 & t38;
+    UA_UInt32 t40 = t25 ^ t39;
+    UA_UInt32 t41 = t40 ^ t37;
+    UA_UInt32 t42 = t29 ^ t33;
+    UA_UInt32 t43 = t29 ^ t40;
+    UA_UInt32 t44 = t33 ^ t37;
+    UA_UInt32 t45 = t42 ^ t41;
+    UA_UInt32 z0 = t44 & y15;
+    UA_UInt32 z1 = t37 & y6;
+    UA_UInt32 z2 = t33 & x7;
+    UA_UInt32 z3 = t43 & y16;
+    UA_UInt32 z4 = t40 & y1;
+    UA_UInt32 z5 = t29 & y7;
+    UA_UInt32 z6 = t42 & y11;
+    UA_UInt32 z7 = t45 & y17;
+    UA_UInt32 z8 = t41 & y10;
+    UA_UInt32 z9 = t44 & y12;
+    UA_UInt32 z10 = t37 & y3;
+    UA_UInt32 z11 = t33 & y4;
+    UA_UInt32 z12 = t43 & y13;
+    UA_UInt32 z13 = t40 & y5;
+    UA_UInt32 z14 = t29 & y2;
+    UA_UInt32 z15 = t42 & y9;
+    UA_UInt32 z16 = t45 & y14;
+    UA_UInt32 z17 = t41 & y8;
+    // bottom linear transformation
+    UA_UInt32 t46 = z15 ^ z16;
+    UA_UInt32 t47 = z10 ^ z11;
+    UA_UInt32 t48 = z5 ^ z13;
+    UA_UInt32 t49 = z9 ^ z10;
+    UA_UInt32 t50 = z2 ^ z12;
+    UA_UInt32 t51 = z2 ^ z5;
+    UA_UInt32 t52 = z7 ^ z8;
+    UA_UInt32 t53 = z0 ^ z3;
+    UA_UInt32 t54 = z6 ^ z7;
+    UA_UInt32 t55 = z16 ^ z17;
+    UA_UInt32 t56 = z12 ^ t48;
+    UA_UInt32 t57 = t50 ^ t53;
+    UA_UInt32 t58 = z4 ^ t46;
+    UA_UInt32 t59 = z3 ^ t54;
+    UA_UInt32 t60 = t46 ^ t57;
+    UA_UInt32 t61 = z14 ^ t57;
+    UA_UInt32 t62 = t52 ^ t58;
+    UA_UInt32 t63 = t49 ^ t58;
+    UA_UInt32 t64 = z4 ^ t59;
+    UA_UInt32 t65 = t61 ^ t62;
+    UA_UInt32 t66 = z1 ^ t63;
+    UA_UInt32 s0 = t59 ^ t63;
+    UA_UInt32 s6 = t56 ^ ~t62;
+    UA_UInt32 s7 = t48 ^ ~t60;
+    UA_UInt32 t67 = t64 ^ t65;
+    UA_UInt32 s3 = t53 ^ t66;
+    UA_UInt32 s4 = t51 ^ t66;
+    UA_UInt32 s5 = t47 ^ t65;
+    UA_UInt32 s1 = t64 ^ ~s3;
+    UA_UInt32 s2 = t55 ^ ~t67;
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+static void
+shiftAesRows(UA_UInt32 *q) {
+    // rotate the rows of both blocks, every byte of a bitsliced word sits in its own bit position
+    for (size_t i = 0; i < 8; i++) {
+        UA_UInt32 x = q[i];
+        q[i] = (x & 0x000000FF) | (x & 0x0000FC00) >> 2 | (x & 0x00000300) << 6 | (x & 0x00F00000) >> 4 | (x & 0x000F0000) << 4 |
+               (x & 0xC0000000) >> 6 | (x & 0x3F000000) << 2;
+    }
+}
+
+static void
+mixAesColumns(UA_UInt32 *q) {
+    // multiply the columns of both blocks with the mix matrix, the doubling in GF(2^8) shifts the bit planes and folds the highest one
+    // back in, the rotations pick the other rows of a column
+    UA_UInt32 r[8];
+    for (size_t i = 0; i < 8; i++) {
+        r[i] = rotateRight(q[i], 8);
+    }
+    UA_UInt32 mixed[8];
+    mixed[0] = q[7] ^ r[7] ^ r[0] ^ rotateRight(q[0] ^ r[0], 16);
+    mixed[1] = q[0] ^ r[0] ^ q[7] ^ r[7] ^ r[1] ^ rotateRight(q[1] ^ r[1], 16);
+    mixed[2] = q[1] ^ r[1] ^ r[2] ^ rotateRight(q[2] ^ r[2], 16);
+    mixed[3] = q[2] ^ r[2] ^ q[7] ^ r[7] ^ r[3] ^ rotateRight(q[3] ^ r[3], 16);
+    mixed[4] = q[3] ^ r[3] ^ q[7] ^ r[7] ^ r[4] ^ rotateRight(q[4] ^ r[4], 16);
+    mixed[5] = q[4] ^ r[4] ^ r[5] ^ rotateRight(q[5] ^ r[5], 16);
+    mixed[6] = q[5] ^ r[5] ^ r[6] ^ rotateRight(q[6] ^ r[6], 16);
+    mixed[7] = q[6] ^ r[6] ^ r[7] ^ rotateRight(q[7] ^ r[7], 16);
+    memcpy(q, mixed, sizeof(mixed));
+}
+
+static void
+addAesRoundKey(UA_UInt32 *q, const UA_UInt32 *roundKey) {
+    // xor the bitsliced round key into both blocks
+    for (size_t i = 0; i < 8; i++) {
+        q[i] ^= roundKey[i];
+    }
+}
+
+static UA_UInt32
+substituteAesWord(UA_UInt32 word) {
+    // run the bytes of a little endian word through the s-box circuit, so the key expansion does no lookups either
+    UA_UInt32 q[8];
+    for (size_t i = 0; i < 8; i++) {
+        q[i] = word;
+    }
+    transposeAesState(q);
+    substituteAesState(q);
+    transposeAesState(q);
+    return q[0];
+}
+
+static void
+expandAesKey(UA_UInt32 *roundKeys, const UA_Byte *key) {
+    // expand the aes-128 key into the little endian words of all rounds and bitslice every round key for both blocks of the state
+    static const UA_Byte roundConstants[AES128_ROUNDS] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36};
+    UA_UInt32 words[4 * (AES128_ROUNDS + 1)];
+    for (size_t i = 0; i < 4; i++) {
+        words[i] = loadLittleEndian(&key[4 * i]);
+    }
+    for (size_t i = 4; i < 4 * (AES128_ROUNDS + 1); i++) {
+        UA_UInt32 temp = words[i - 1];
+        if (i % 4 == 0) {
+            temp = substituteAesWord(temp << 24 | temp >> 8) ^ roundConstants[i / 4 - 1];
+        }
+        words[i] = words[i - 4] ^ temp;
+    }
+    for (size_t round = 0; round <= AES128_ROUNDS; round++) {
+        UA_UInt32 *q = &roundKeys[8 * round];
+        for (size_t i = 0; i < 4; i++) {
+            q[2 * i] = words[4 * round + i];
+            q[2 * i + 1] = words[4 * round + i];
+        }
+        transposeAesState(q);
+    }
+}
+
+static void
+encryptAesBlocks(const UA_UInt32 *roundKeys, const UA_Byte *input, UA_Byte *output) {
+    // encrypt two consecutive blocks with aes-128 in the bitsliced state, all rounds are logic operations on the whole state without
+    // lookups or branches that depend on the key or the data
+    UA_UInt32 q[8];
+    for (size_t i = 0; i < 4; i++) {
+        q[2 * i] = loadLittleEndian(&input[4 * i]);
+        q[2 * i + 1] = loadLittleEndian(&input[AES_BLOCK_SIZE + 4 * i]);
+    }
+    transposeAesState(q);
+    addAesRoundKey(q, roundKeys);
+    for (size_t round = 1; round < AES128_ROUNDS; round++) {
+        substituteAesState(q);
+        shiftAesRows(q);
+        mixAesColumns(q);
+        addAesRoundKey(q, &roundKeys[8 * round]);
+    }
+    // the last round has no column mix
+    substituteAesState(q);
+    shiftAesRows(q);
+    addAesRoundKey(q, &roundKeys[8 * AES128_ROUNDS]);
+    transposeAesState(q);
+    for (size_t i = 0; i < 4; i++) {
+        storeLittleEndian(&output[4 * i], q[2 * i]);
+        storeLittleEndian(&output[AES_BLOCK_SIZE + 4 * i], q[2 * i + 1]);
+    }
+}
+
+static void
+writeMessageNonce(UA_Byte *nonce, UA_UInt32 random, UA_UInt32 sequenceNumber) {
+    // a message nonce of PubSub-Aes128-CTR is 4 random bytes followed by the little endian sequence number of the message
+    memcpy(nonce, &random, sizeof(UA_UInt32));
+    for (size_t i = 0; i < sizeof(UA_UInt32); i++) {
+        nonce[sizeof(UA_UInt32) + i] = (UA_Byte) (sequenceNumber >> (8 * i));
+    }
+}
+
+static void
+computeKeystream(SecureChannel *secure, UA_UInt32 random, UA_UInt32 sequenceNumber, UA_Byte *keystream, size_t length) {
+    // encrypt the counter blocks of a message nonce, a counter block is the key nonce, the message nonce and the big endian block counter
+    // starting at 1, the keystream is rounded up to pairs of blocks, which the bitsliced aes encrypts at once
+    UA_Byte counters[2 * AES_BLOCK_SIZE];
+    for (size_t i = 0; i < 2; i++) {
+        memcpy(&counters[i * AES_BLOCK_SIZE], secure->keyNonce, SECURITY_KEY_NONCE_LENGTH);
+        writeMessageNonce(&counters[i * AES_BLOCK_SIZE + SECURITY_KEY_NONCE_LENGTH], random, sequenceNumber);
+    }
+    for (UA_UInt32 block = 0; block * AES_BLOCK_SIZE < length; block += 2) {
+        storeBigEndian(&counters[AES_BLOCK_SIZE - sizeof(UA_UInt32)], block + 1);
+        storeBigEndian(&counters[2 * AES_BLOCK_SIZE - sizeof(UA_UInt32)], block + 2);
+        encryptAesBlocks(secure->roundKeys, counters, &keystream[block * AES_BLOCK_SIZE]);
+    }
+}
+
+static UA_Boolean
+isKeystreamReady(KeystreamSlot *slot, UA_UInt32 random, UA_UInt32 sequenceNumber, size_t length) {
+    // returns true if the slot holds at least length bytes of the keystream of the message nonce
+    return slot->random == random && slot->sequenceNumber == sequenceNumber && slot->length >= length;
+}
+
+static const UA_Byte *
+getKeystream(SecureChannel *secure, UA_UInt32 random, UA_UInt32 sequenceNumber, size_t length) {
+    // returns the keystream of the message nonce from its slot, it is only computed now if it was not precomputed or is too short
+    KeystreamSlot *slot = &secure->slots[sequenceNumber & (KEYSTREAM_RING_SIZE - 1)];
+    if (isKeystreamReady(slot, random, sequenceNumber, length)) {
+        secure->precomputedKeystreams++;
+        return slot->keystream;
+    }
+    computeKeystream(secure, random, sequenceNumber, slot->keystream, length);
+    slot->random = random;
+    slot->sequenceNumber = sequenceNumber;
+    slot->length = length;
+    secure->inlineKeystreams++;
+    return slot->keystream;
+}
+
+static void
+xorKeystream(UA_Byte *target, const UA_Byte *source, const UA_Byte *keystream, size_t length) {
+    // xor the source with the keystream a word at a time, the target may overlap the source if it starts in front of it
+    size_t i = 0;
+    for (; i + sizeof(UA_UInt64) <= length; i += sizeof(UA_UInt64)) {
+        UA_UInt64 word, key;
+        memcpy(&word, &source[i], sizeof(UA_UInt64));
+        memcpy(&key, &keystream[i], sizeof(UA_UInt64));
+        word ^= key;
+        memcpy(&target[i], &word, sizeof(UA_UInt64));
+    }
+    for (; i < length; i++) {
+        target[i] = source[i] ^ keystream[i];
+    }
+}
+
+static void
+drawNonceRandom(SecureChannel *secure) {
+    // the random half of the message nonces keeps them unique across restarts under the same key, the subscribers bind it to the
+    // source at its first frame
+    if (getrandom(&secure->random, sizeof(UA_UInt32), 0) != sizeof(UA_UInt32)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "getrandom failed: %s", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+}
+
+static UA_UInt64
+loadLittleEndianBytes(const UA_Byte *data, size_t length) {
+    // read an unsigned little endian integer of up to eight bytes
+    UA_UInt64 value = 0;
+    for (size_t i = 0; i < length; i++) {
+        value |= (UA_UInt64) data[i] << (8 * i);
+    }
+    return value;
+}
+
+static size_t
+getUadpPayloadOffset(const UA_ByteString *message, UA_UInt64 *publisherId, UA_UInt16 *writerGroupId) {
+    // returns the offset of the payload behind the headers of a uadp network message, which is where the security header goes, or 0 for
+    // chunks, discovery messages, promoted fields, string publisher ids and frames that end within their headers, the publisher id and the
+    // writer group id are 0 if the headers do not carry them
+    const UA_Byte *data = message->data;
+    size_t length = message->length;
+    size_t position = 1;
+    UA_Byte extendedFlags1 = 0, extendedFlags2 = 0;
+    *publisherId = 0;
+    *writerGroupId = 0;
+    if (length < 1) {
+        return 0;
+    }
+    if (data[0] & UADP_FLAGS_EXTENDEDFLAGS1) {
+        if (position >= length) {
+            return 0;
+        }
+        extendedFlags1 = data[position++];
+    }
+    if (extendedFlags1 & UADP_EXTENDEDFLAGS1_EXTENDEDFLAGS2) {
+        if (position >= length) {
+            return 0;
+        }
+        extendedFlags2 = data[position++];
+    }
+    UA_Byte publisherIdType = extendedFlags1 & UADP_EXTENDEDFLAGS1_PUBLISHERIDTYPE;
+    if ((extendedFlags2 & (UADP_EXTENDEDFLAGS2_CHUNK_OR_NOT_DATASET | UADP_EXTENDEDFLAGS2_PROMOTEDFIELDS)) ||
+        publisherIdType > UA_PUBLISHERDATATYPE_UINT64) {
+        return 0;
+    }
+    if (data[0] & UADP_FLAGS_PUBLISHERID) {
+        if (position + ((size_t) 1 << publisherIdType) > length) {
+            return 0;
+        }
+        *publisherId = loadLittleEndianBytes(&data[position], (size_t) 1 << publisherIdType);
+        position += (size_t) 1 << publisherIdType;
+    }
+    position += (extendedFlags1 & UADP_EXTENDEDFLAGS1_DATASETCLASSID) ? UADP_DATASETCLASSID_LENGTH : 0;
+    if (data[0] & UADP_FLAGS_GROUPHEADER) {
+        if (position >= length) {
+            return 0;
+        }
+        UA_Byte groupFlags = data[position++];
+        if (groupFlags & UADP_GROUPFLAGS_WRITERGROUPID) {
+            if (position + sizeof(UA_UInt16) > length) {
+                return 0;
+            }
+            *writerGroupId = (UA_UInt16) loadLittleEndianBytes(&data[position], sizeof(UA_UInt16));
+            position += sizeof(UA_UInt16);
+        }
+        position += (groupFlags & UADP_GROUPFLAGS_GROUPVERSION) ? sizeof(UA_UInt32) : 0;
+        position += (groupFlags & UADP_GROUPFLAGS_NETWORKMESSAGENUMBER) ? sizeof(UA_UInt16) : 0;
+        position += (groupFlags & UADP_GROUPFLAGS_SEQUENCENUMBER) ? sizeof(UA_UInt16) : 0;
+    }
+    if (data[0] & UADP_FLAGS_PAYLOADHEADER) {
+        // the payload header is the count of data set messages and their data set writer ids
+        if (position >= length) {
+            return 0;
+        }
+        position += 1 + data[position] * sizeof(UA_UInt16);
+    }
+    position += (extendedFlags1 & UADP_EXTENDEDFLAGS1_TIMESTAMP) ? UADP_TIMESTAMP_LENGTH : 0;
+    position += (extendedFlags1 & UADP_EXTENDEDFLAGS1_PICOSECONDS) ? UADP_PICOSECONDS_LENGTH : 0;
+    return position < length ? position : 0;
+}
+
+static UA_Byte
+getSecurityFlags(SecureChannel *secure) {
+    // every secured frame is signed, encrypted only in the sign and encrypt mode
+    return secure->mode == SECURITY_MODE_SIGN_AND_ENCRYPT ? UADP_SECURITYFLAGS_SIGNED | UADP_SECURITYFLAGS_ENCRYPTED : UADP_SECURITYFLAGS_SIGNED;
+}
+
+UA_Boolean
+secureMessage(SecureChannel *secure, const UA_ByteString *message, UA_ByteString *secured) {
+    // copy the frame into the buffer of the channel with the security header in front of its payload, encrypt the payload on the way in
+    // the sign and encrypt mode and append the signature over everything before it, returns false for frames whose headers are unknown
+    // and once the sequence numbers of the random are used up, the subscribers only accept the random bound to the publisher, so the
+    // keys have to be replaced before that
+    UA_UInt64 publisherId;
+    UA_UInt16 writerGroupId;
+    size_t payloadOffset = getUadpPayloadOffset(message, &publisherId, &writerGroupId);
+    if (payloadOffset == 0 || message->length + 1 + SECURITY_HEADER_LENGTH + SECURITY_SIGNATURE_LENGTH > RECEIVE_BUFFER_SIZE ||
+        (secure->sequenceNumber == 0 && secure->messages > 0)) {
+        return false;
+    }
+    UA_Byte *data = secure->buffer;
+    size_t position = payloadOffset;
+    if (message->data[0] & UADP_FLAGS_EXTENDEDFLAGS1) {
+        memcpy(data, message->data, payloadOffset);
+        data[1] |= UADP_EXTENDEDFLAGS1_SECURITY;
+    } else {
+        // the security flag needs the extended flags, without them the publisher id is of type byte, which stays the same
+        data[0] = message->data[0] | UADP_FLAGS_EXTENDEDFLAGS1;
+        data[1] = UADP_EXTENDEDFLAGS1_SECURITY;
+        memcpy(&data[2], &message->data[1], payloadOffset - 1);
+        position++;
+    }
+    UA_UInt32 sequenceNumber = secure->sequenceNumber;
+    data[position++] = getSecurityFlags(secure);
+    for (size_t i = 0; i < sizeof(UA_UInt32); i++) {
+        data[position++] = (UA_Byte) (SECURITY_TOKEN_ID >> (8 * i));
+    }
+    data[position++] = SECURITY_MESSAGE_NONCE_LENGTH;
+    writeMessageNonce(&data[position], secure->random, sequenceNumber);
+    position += SECURITY_MESSAGE_NONCE_LENGTH;
+    size_t payloadLength = message->length - payloadOffset;
+    if (secure->mode == SECURITY_MODE_SIGN_AND_ENCRYPT) {
+        xorKeystream(&data[position], &message->data[payloadOffset], getKeystream(secure, secure->random, sequenceNumber, payloadLength),
+                     payloadLength);
+    } else {
+        memcpy(&data[position], &message->data[payloadOffset], payloadLength);
+    }
+    position += payloadLength;
+    signMessage(secure, data, position, &data[position]);
+    secured->data = data;
+    secured->length = position + SECURITY_SIGNATURE_LENGTH;
+    secure->keystreamLength = payloadLength;
+    secure->messages++;
+    secure->sequenceNumber++;
+    return true;
+}
+
+static UA_Boolean
+acceptMessageNonce(SecureChannel *secure, UA_PubSubChannel *channel, UA_UInt64 publisherId, UA_UInt16 writerGroupId, UA_UInt32 random,
+                   UA_UInt32 sequenceNumber) {
+    // returns true if the random is the one bound to the session of the source on the channel and the sequence number is newer than the
+    // newest one accepted in it, the first signed frame of a source binds its random, without a key service nothing proves that another
+    // random is a restart and not a replay of an earlier run, so it stays rejected until the keys are replaced, the copies of the
+    // redundant paths come in on channels of their own and still reach the duplicate filter
+    for (size_t i = 0; i < secure->sessionsSize; i++) {
+        SecuritySession *session = &secure->sessions[i];
+        if (session->channel == channel && session->publisherId == publisherId && session->writerGroupId == writerGroupId) {
+            if (random != session->random) {
+                secure->unboundMessages++;
+                return false;
+            }
+            if (sequenceNumber <= session->newestSequenceNumber) {
+                return false;
+            }
+            session->newestSequenceNumber = sequenceNumber;
+            return true;
+        }
+    }
+    if (secure->sessionsSize == SECURITY_SESSIONS) {
+        // a bound session is never given to another source
+        secure->unboundMessages++;
+        return false;
+    }
+    SecuritySession *session = &secure->sessions[secure->sessionsSize++];
+    session->channel = channel;
+    session->publisherId = publisherId;
+    session->writerGroupId = writerGroupId;
+    session->random = random;
+    session->newestSequenceNumber = sequenceNumber;
+    return true;
+}
+
+UA_Boolean
+verifyMessage(SecureChannel *secure, UA_PubSubChannel *channel, UA_ByteString *message) {
+    // check the security header, the signature and the freshness of the frame and turn it back into the plain frame in place, the payload
+    // is decrypted on its way to the place of the security header, the signature is cut off and the security flag cleared, returns false
+    // for frames without the security of the channel, with a wrong signature, with a random that is not bound to their source or with a
+    // sequence number that was accepted before, the headers are public and a frame with unknown ones is dropped right away, the signature
+    // is compared without an early exit
+    UA_UInt64 publisherId;
+    UA_UInt16 writerGroupId;
+    size_t payloadOffset = getUadpPayloadOffset(message, &publisherId, &writerGroupId);
+    UA_Byte *data = message->data;
+    if (payloadOffset == 0 || !(data[0] & UADP_FLAGS_EXTENDEDFLAGS1) || !(data[1] & UADP_EXTENDEDFLAGS1_SECURITY) ||
+        message->length <= payloadOffset + SECURITY_HEADER_LENGTH + SECURITY_SIGNATURE_LENGTH) {
+        secure->unsecuredMessages++;
+        return false;
+    }
+    const UA_Byte *header = &data[payloadOffset];
+    UA_UInt32 tokenId = 0;
+    for (size_t i = 0; i < sizeof(UA_UInt32); i++) {
+        tokenId |= (UA_UInt32) header[1 + i] << (8 * i);
+    }
+    if (header[0] != getSecurityFlags(secure) || tokenId != SECURITY_TOKEN_ID || header[1 + sizeof(UA_UInt32)] != SECURITY_MESSAGE_NONCE_LENGTH) {
+        secure->rejectedMessages++;
+        return false;
+    }
+    size_t signedLength = message->length - SECURITY_SIGNATURE_LENGTH;
+    UA_Byte signature[SECURITY_SIGNATURE_LENGTH];
+    UA_Byte difference = 0;
+    signMessage(secure, data, signedLength, signature);
+    for (size_t i = 0; i < SECURITY_SIGNATURE_LENGTH; i++) {
+        difference |= signature[i] ^ data[signedLength + i];
+    }
+    if (difference != 0) {
+        secure->rejectedMessages++;
+        return false;
+    }
+    const UA_Byte *nonce = &header[2 + sizeof(UA_UInt32)];
+    UA_UInt32 random, sequenceNumber = 0;
+    memcpy(&random, nonce, sizeof(UA_UInt32));
+    for (size_t i = 0; i < sizeof(UA_UInt32); i++) {
+        sequenceNumber |= (UA_UInt32) nonce[sizeof(UA_UInt32) + i] << (8 * i);
+    }
+    if (!acceptMessageNonce(secure, channel, publisherId, writerGroupId, random, sequenceNumber)) {
+        // a replayed frame carries a valid signature of an old nonce
+        secure->rejectedMessages++;
+        return false;
+    }
+    size_t payloadLength = signedLength - payloadOffset - SECURITY_HEADER_LENGTH;
+    if (secure->mode == SECURITY_MODE_SIGN_AND_ENCRYPT) {
+        xorKeystream(&data[payloadOffset], &data[payloadOffset + SECURITY_HEADER_LENGTH], getKeystream(secure, random, sequenceNumber, payloadLength),
+                     payloadLength);
+    } else {
+        memmove(&data[payloadOffset], &data[payloadOffset + SECURITY_HEADER_LENGTH], payloadLength);
+    }
+    data[1] &= (UA_Byte) ~UADP_EXTENDEDFLAGS1_SECURITY;
+    message->length = payloadOffset + payloadLength;
+    // the next frame of the publisher most likely carries the next sequence number of the same random, only fresh frames get here
+    secure->random = random;
+    secure->sequenceNumber = sequenceNumber + 1;
+    secure->keystreamLength = payloadLength;
+    secure->messages++;
+    return true;
+}
+
+static void
+initSigningKey(SecureChannel *secure, const UA_Byte *signingKey) {
+    // absorb the inner and the outer key block of hmac-sha256 once, every signature starts from these states
+    UA_Byte innerBlock[SHA256_BLOCK_SIZE], outerBlock[SHA256_BLOCK_SIZE];
+    for (size_t i = 0; i < SHA256_BLOCK_SIZE; i++) {
+        UA_Byte keyByte = i < SECURITY_SIGNING_KEY_LENGTH ? signingKey[i] : 0;
+        innerBlock[i] = keyByte ^ 0x36;
+        outerBlock[i] = keyByte ^ 0x5C;
+    }
+    memcpy(secure->innerState, sha256InitialState, sizeof(sha256InitialState));
+    compressSha256Block(secure->innerState, innerBlock);
+    memcpy(secure->outerState, sha256InitialState, sizeof(sha256InitialState));
+    compressSha256Block(secure->outerState, outerBlock);
+}
+
+static size_t
+decodeHex(const char *hex, UA_Byte *bytes) {
+    // decode a string of hex digits into bytes, returns the number of bytes
+    size_t length = strlen(hex) / 2;
+    for (size_t i = 0; i < length; i++) {
+        unsigned int value = 0;
+        sscanf(&hex[2 * i], "%2x", &value);
+        bytes[i] = (UA_Byte) value;
+    }
+    return length;
+}
+
+static UA_Boolean
+checkKnownAnswers(void) {
+    // compare aes-128, sha-256 and hmac-sha256 with the known answers of FIPS-197, SP 800-38A, FIPS 180-4 and RFC 4231, every aes vector
+    // fills both blocks of the bitsliced state, the hmac keys are zero padded to the signing key length like hmac pads them anyway
+    static const SecurityTestVector aesVectors[] = {
+            {"000102030405060708090a0b0c0d0e0f", "00112233445566778899aabbccddeeff00112233445566778899aabbccddeeff",
+             "69c4e0d86a7b0430d8cdb78070b4c55a69c4e0d86a7b0430d8cdb78070b4c55a"},
+            {"2b7e151628aed2a6abf7158809cf4f3c", "3243f6a8885a308d313198a2e03707346bc1bee22e409f96e93d7e117393172a",
+             "3925841d02dc09fbdc118597196a0b323ad77bb40d7a3660a89ecaf32466ef97"},
+            {"2b7e151628aed2a6abf7158809cf4f3c", "ae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52ef",
+             "f5d3d58503b9699de785895a96fdbaaf43b1cd7f598ece23881b00e3ed030688"}
+    };
+    static const SecurityTestVector sha256Vectors[] = {
+            {NULL, "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+            {NULL, "616263", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+            {NULL, "6162636462636465636465666465666765666768666768696768696a68696a6b696a6b6c6a6b6c6d6b6c6d6e6c6d6e6f6d6e6f706e6f7071",
+             "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"}
+    };
+    static const SecurityTestVector hmacVectors[] = {
+            {"0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b", "4869205468657265", "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7"},
+            {"4a656665", "7768617420646f2079612077616e7420666f72206e6f7468696e673f",
+             "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843"},
+            {"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa",
+             "dddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddd",
+             "773ea91e36800e46854db8ebd09181a72959098b3ef8c122d9635514ced565fe"},
+            {"0102030405060708090a0b0c0d0e0f10111213141516171819",
+             "cdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcd",
+             "82558a389a443c0ea4cc819899f2083a85f0faa3e578f8077a2e3ff46729665b"}
+    };
+    SecureChannel secure;
+    UA_Byte key[SECURITY_SIGNING_KEY_LENGTH], input[2 * SHA256_BLOCK_SIZE], expected[SECURITY_SIGNATURE_LENGTH], output[SECURITY_SIGNATURE_LENGTH];
+    for (size_t i = 0; i < sizeof(aesVectors) / sizeof(aesVectors[0]); i++) {
+        decodeHex(aesVectors[i].key, key);
+        decodeHex(aesVectors[i].input, input);
+        decodeHex(aesVectors[i].output, expected);
+        expandAesKey(secure.roundKeys, key);
+        encryptAesBlocks(secure.roundKeys, input, output);
+        if (memcmp(output, expected, 2 * AES_BLOCK_SIZE) != 0) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "aes-128 differs from known answer %zu", i);
+            return false;
+        }
+    }
+    for (size_t i = 0; i < sizeof(sha256Vectors) / sizeof(sha256Vectors[0]); i++) {
+        UA_UInt32 state[SHA256_STATE_WORDS];
+        size_t length = decodeHex(sha256Vectors[i].input, input);
+        decodeHex(sha256Vectors[i].output, expected);
+        memcpy(state, sha256InitialState, sizeof(state));
+        finishSha256(state, input, length, 0, output);
+        if (memcmp(output, expected, SECURITY_SIGNATURE_LENGTH) != 0) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "sha-256 differs from known answer %zu", i);
+            return false;
+        }
+    }
+    for (size_t i = 0; i < sizeof(hmacVectors) / sizeof(hmacVectors[0]); i++) {
+        memset(key, 0, sizeof(key));
+        decodeHex(hmacVectors[i].key, key);
+        size_t length = decodeHex(hmacVectors[i].input, input);
+        decodeHex(hmacVectors[i].output, expected);
+        initSigningKey(&secure, key);
+        signMessage(&secure, input, length, output);
+        if (memcmp(output, expected, SECURITY_SIGNATURE_LENGTH) != 0) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "hmac-sha256 differs from known answer %zu", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+createSecureChannel(SecureChannel *secure, SecurityMode mode, const UA_Byte *keys) {
+    // derive the hmac states and the aes round keys from the preconfigured keys and allocate the frame buffer, the keystream slots and
+    // the sessions, the random half of the message nonces is drawn per channel, the primitives have to match their known answers
+    if (!checkKnownAnswers()) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "createSecureChannel failed: the self test of the security failed");
+        exit(EXIT_FAILURE);
+    }
+    memset(secure, 0, sizeof(SecureChannel));
+    secure->mode = mode;
+    initSigningKey(secure, keys);
+    expandAesKey(secure->roundKeys, &keys[SECURITY_SIGNING_KEY_LENGTH]);
+    memcpy(secure->keyNonce, &keys[SECURITY_SIGNING_KEY_LENGTH + SECURITY_ENCRYPTING_KEY_LENGTH], SECURITY_KEY_NONCE_LENGTH);
+    drawNonceRandom(secure);
+    secure->buffer = (UA_Byte *) allocateCacheLineAligned(RECEIVE_BUFFER_SIZE);
+    secure->sessions = (SecuritySession *) allocateCacheLineAligned(SECURITY_SESSIONS * sizeof(SecuritySession));
+    for (size_t i = 0; i < KEYSTREAM_RING_SIZE && secure->mode == SECURITY_MODE_SIGN_AND_ENCRYPT; i++) {
+        secure->slots[i].keystream = (UA_Byte *) allocateCacheLineAligned(KEYSTREAM_LENGTH);
+    }
+}
+
+void
+deleteSecureChannel(SecureChannel *secure, const char *name) {
+    // log what the channel secured or verified and free its buffers
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "%s: %llu secured messages, %llu precomputed and %llu inline keystreams, %llu unsecured "
+                                                      "and %llu rejected messages, %llu of them with a random not bound to their source or "
+                                                      "without a free session", name, (unsigned long long) secure->messages,
+                (unsigned long long) secure->precomputedKeystreams, (unsigned long long) secure->inlineKeystreams,
+                (unsigned long long) secure->unsecuredMessages, (unsigned long long) secure->rejectedMessages,
+                (unsigned long long) secure->unboundMessages);
+    free(secure->buffer);
+    free(secure->sessions);
+    for (size_t i = 0; i < KEYSTREAM_RING_SIZE; i++) {
+        free(secure->slots[i].keystream);
+    }
+}
+
+void
+precomputeKeystreams(SecureChannel *secure) {
+    // compute the keystreams of the next message nonces with the length of the last payload, called by the rt thread in the slack after
+    // its cycle so the payload of a frame is only xored with a ready keystream, the slot of the last nonce is kept for the copy of its
+    // frame on the redundant path
+    if (secure->mode != SECURITY_MODE_SIGN_AND_ENCRYPT || secure->keystreamLength == 0) {
+        return;
+    }
+    for (UA_UInt32 i = 0; i < KEYSTREAM_RING_SIZE - 1; i++) {
+        UA_UInt32 sequenceNumber = secure->sequenceNumber + i;
+        KeystreamSlot *slot = &secure->slots[sequenceNumber & (KEYSTREAM_RING_SIZE - 1)];
+        if (!isKeystreamReady(slot, secure->random, sequenceNumber, secure->keystreamLength)) {
+            computeKeystream(secure, secure->random, sequenceNumber, slot->keystream, secure->keystreamLength);
+            slot->random = secure->random;
+            slot->sequenceNumber = sequenceNumber;
+            slot->length = secure->keystreamLength;
+        }
+    }
+}
+
+UA_Boolean
+checkSecurity(void) {
+    // check the primitives against their known answers, then secure frames in both modes with a random key and check that the receiver
+    // restores them and rejects replayed and tampered copies and the frames of a restarted publisher, and time the keystream and the
+    // signature of a frame
+    if (!checkKnownAnswers()) {
+        return false;
+    }
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "aes-128, sha-256 and hmac-sha256 match their known answers");
+    UA_Byte keys[SECURITY_KEYS_LENGTH];
+    if (getrandom(keys, SECURITY_KEYS_LENGTH, 0) != SECURITY_KEYS_LENGTH) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "getrandom failed: %s", strerror(errno));
+        return false;
+    }
+    // a frame with publisher id, writer group id and one data set writer id but without extended flags, which the sender has to insert,
+    // the receiver restores it with the inserted extended flags cleared
+    UA_Byte plain[SECURITY_CHECK_FRAME_LENGTH], restored[SECURITY_CHECK_FRAME_LENGTH + 1], received[RECEIVE_BUFFER_SIZE];
+    size_t payloadOffset = 8;
+    plain[0] = UADP_VERSION | UADP_FLAGS_PUBLISHERID | UADP_FLAGS_GROUPHEADER | UADP_FLAGS_PAYLOADHEADER;
+    plain[1] = 1;
+    plain[2] = UADP_GROUPFLAGS_WRITERGROUPID;
+    plain[3] = 1;
+    plain[4] = 0;
+    plain[5] = 1;
+    plain[6] = 1;
+    plain[7] = 0;
+    for (size_t i = payloadOffset; i < SECURITY_CHECK_FRAME_LENGTH; i++) {
+        plain[i] = (UA_Byte) i;
+    }
+    restored[0] = plain[0] | UADP_FLAGS_EXTENDEDFLAGS1;
+    restored[1] = 0;
+    memcpy(&restored[2], &plain[1], SECURITY_CHECK_FRAME_LENGTH - 1);
+    UA_ByteString message = {SECURITY_CHECK_FRAME_LENGTH, plain};
+    UA_PubSubChannel channel;
+    memset(&channel, 0, sizeof(UA_PubSubChannel));
+    UA_Boolean passed = true;
+    for (SecurityMode mode = SECURITY_MODE_SIGN; mode <= SECURITY_MODE_SIGN_AND_ENCRYPT && passed; mode++) {
+        SecureChannel sender, receiver;
+        createSecureChannel(&sender, mode, keys);
+        createSecureChannel(&receiver, mode, keys);
+        for (size_t i = 0; i < KEYSTREAM_RING_SIZE + 1 && passed; i++) {
+            UA_ByteString secured, copy = {0, received};
+            if (!secureMessage(&sender, &message, &secured)) {
+                passed = false;
+                break;
+            }
+            // the payload goes behind the inserted extended flags and the security header, encrypted or in plain
+            const UA_Byte *securedPayload = &secured.data[payloadOffset + 1 + SECURITY_HEADER_LENGTH];
+            size_t payloadLength = SECURITY_CHECK_FRAME_LENGTH - payloadOffset;
+            passed = (memcmp(securedPayload, &plain[payloadOffset], payloadLength) == 0) == (mode == SECURITY_MODE_SIGN);
+            memcpy(received, secured.data, secured.length);
+            copy.length = secured.length;
+            passed = passed && verifyMessage(&receiver, &channel, &copy) && copy.length == sizeof(restored) &&
+                     memcmp(received, restored, sizeof(restored)) == 0;
+            // the same frame again is a replay, a flipped bit of its payload breaks the signature
+            memcpy(received, secured.data, secured.length);
+            copy.length = secured.length;
+            passed = passed && !verifyMessage(&receiver, &channel, &copy);
+            memcpy(received, secured.data, secured.length);
+            received[secured.length / 2] ^= 1;
+            copy.length = secured.length;
+            passed = passed && !verifyMessage(&receiver, &channel, &copy);
+            precomputeKeystreams(&sender);
+            precomputeKeystreams(&receiver);
+        }
+        // a restarted publisher draws another random for its source, which stays rejected as it could be a replay of an earlier run,
+        // the same frame of another writer group binds a session of its own
+        SecureChannel restarted;
+        createSecureChannel(&restarted, mode, keys);
+        restarted.random = sender.random + 1;
+        for (UA_Byte writerGroupId = 1; writerGroupId <= 2 && passed; writerGroupId++) {
+            UA_ByteString secured, copy = {0, received};
+            plain[3] = writerGroupId;
+            passed = secureMessage(&restarted, &message, &secured);
+            if (passed) {
+                memcpy(received, secured.data, secured.length);
+                copy.length = secured.length;
+                passed = verifyMessage(&receiver, &channel, &copy) == (writerGroupId == 2) && receiver.unboundMessages == 1;
+            }
+        }
+        plain[3] = 1;
+        deleteSecureChannel(&restarted, mode == SECURITY_MODE_SIGN ? "sign restarted sender" : "sign and encrypt restarted sender");
+        if (!passed) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the round trip of mode %d failed", (int) mode);
+        } else if (mode == SECURITY_MODE_SIGN_AND_ENCRYPT) {
+            // the sink keeps the compiler from dropping the calls of the timed loops
+            volatile UA_Byte sink = 0;
+            UA_Byte *keystream = sender.slots[0].keystream;
+            UA_UInt64 startTimestamp = getCurrentTimestamp();
+            for (UA_UInt32 i = 0; i < SECURITY_CHECK_ITERATIONS; i++) {
+                computeKeystream(&sender, sender.random, i, keystream, SECURITY_CHECK_FRAME_LENGTH);
+                sink = keystream[0];
+            }
+            UA_UInt64 keystreamDuration = getCurrentTimestamp() - startTimestamp;
+            UA_Byte signature[SECURITY_SIGNATURE_LENGTH];
+            startTimestamp = getCurrentTimestamp();
+            for (UA_UInt32 i = 0; i < SECURITY_CHECK_ITERATIONS; i++) {
+                plain[payloadOffset] = (UA_Byte) i;
+                signMessage(&sender, plain, SECURITY_CHECK_FRAME_LENGTH, signature);
+                sink = signature[0];
+            }
+            UA_UInt64 signatureDuration = getCurrentTimestamp() - startTimestamp;
+            (void) sink;
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "keystream: %.1f ns per aes block, signature: %.1f ns per frame of %d bytes",
+                        (UA_Double) keystreamDuration / ((UA_Double) SECURITY_CHECK_ITERATIONS * SECURITY_CHECK_FRAME_LENGTH / AES_BLOCK_SIZE),
+                        (UA_Double) signatureDuration / SECURITY_CHECK_ITERATIONS, SECURITY_CHECK_FRAME_LENGTH);
+        }
+        deleteSecureChannel(&sender, mode == SECURITY_MODE_SIGN ? "sign sender" : "sign and encrypt sender");
+        deleteSecureChannel(&receiver, mode == SECURITY_MODE_SIGN ? "sign receiver" : "sign and encrypt receiver");
+    }
+    return passed;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+// do not change defines
+#define UADP_SECURITYFLAGS_SIGNED 0x01
+#define UADP_SECURITYFLAGS_ENCRYPTED 0x02
+// PubSub-Aes128-CTR of part 14, a key file holds the signing key, the encrypting key and the key nonce in this order
+#define SECURITY_SIGNING_KEY_LENGTH 32
+#define SECURITY_ENCRYPTING_KEY_LENGTH 16
+#define SECURITY_KEY_NONCE_LENGTH 4
+#define SECURITY_KEYS_LENGTH (SECURITY_SIGNING_KEY_LENGTH + SECURITY_ENCRYPTING_KEY_LENGTH + SECURITY_KEY_NONCE_LENGTH)
+#define SECURITY_MESSAGE_NONCE_LENGTH 8
+#define SECURITY_HEADER_LENGTH (2 + sizeof(UA_UInt32) + SECURITY_MESSAGE_NONCE_LENGTH)
+#define SECURITY_SIGNATURE_LENGTH 32
+#define AES_BLOCK_SIZE 16
+#define AES128_ROUNDS 10
+#define SHA256_BLOCK_SIZE 64
+#define SHA256_STATE_WORDS 8
+
+// change defines as you wish
+// without a security key service all publishers and subscribers share the preconfigured key of this token, the rt threads compute the
+// keystreams of the next KEYSTREAM_RING_SIZE message nonces ahead in their slack, a power of two, a keystream covers a whole frame in
+// pairs of aes blocks
+#define SECURITY_TOKEN_ID 1
+#define KEYSTREAM_RING_SIZE 4
+#define KEYSTREAM_LENGTH RECEIVE_BUFFER_SIZE
+// a receiver binds the nonce random of the first signed frame of every publisher, writer group and path to a session of its own and
+// rejects any other random of that source, once all SECURITY_SESSIONS are bound the frames of further sources are rejected
+#define SECURITY_SESSIONS (MAX_SOURCES * REDUNDANT_PATHS)
+// --check-security times the keystream and the signature over this many frames of SECURITY_CHECK_FRAME_LENGTH bytes
+#define SECURITY_CHECK_ITERATIONS 10000
+#define SECURITY_CHECK_FRAME_LENGTH 1024
+
+typedef enum {
+    SECURITY_MODE_NONE,
+    SECURITY_MODE_SIGN,
+    SECURITY_MODE_SIGN_AND_ENCRYPT
+} SecurityMode;
+
+typedef struct {
+    UA_UInt32 random;
+    UA_UInt32 sequenceNumber;
+    size_t length;
+    UA_Byte *keystream;
+} KeystreamSlot;
+
+typedef struct {
+    UA_PubSubChannel *channel;
+    UA_UInt64 publisherId;
+    UA_UInt16 writerGroupId;
+    UA_UInt32 random;
+    UA_UInt32 newestSequenceNumber;
+} SecuritySession;
+
+typedef struct {
+    const char *key;
+    const char *input;
+    const char *output;
+} SecurityTestVector;
+
+typedef struct {
+    SecurityMode mode;
+    UA_UInt32 innerState[SHA256_STATE_WORDS];
+    UA_UInt32 outerState[SHA256_STATE_WORDS];
+    UA_UInt32 roundKeys[8 * (AES128_ROUNDS + 1)];
+    UA_Byte keyNonce[SECURITY_KEY_NONCE_LENGTH];
+    UA_UInt32 random;
+    UA_UInt32 sequenceNumber;
+    size_t keystreamLength;
+    KeystreamSlot slots[KEYSTREAM_RING_SIZE];
+    SecuritySession *sessions;
+    size_t sessionsSize;
+    UA_Byte *buffer;
+    UA_UInt64 messages;
+    UA_UInt64 precomputedKeystreams;
+    UA_UInt64 inlineKeystreams;
+    UA_UInt64 unsecuredMessages;
+    UA_UInt64 rejectedMessages;
+    UA_UInt64 unboundMessages;
+} SecureChannel;
+
+void
+createSecureChannel(SecureChannel *secure, SecurityMode mode, const UA_Byte *keys);
+
+void
+deleteSecureChannel(SecureChannel *secure, const char *name);
+
+UA_Boolean
+secureMessage(SecureChannel *secure, const UA_ByteString *message, UA_ByteString *secured);
+
+UA_Boolean
+verifyMessage(SecureChannel *secure, UA_PubSubChannel *channel, UA_ByteString *message);
+
+void
+precomputeKeystreams(SecureChannel *secure);
+
+UA_Boolean
+checkSecurity(void);
@@ -1,5 +1,118 @@
 #include "opcua_pubsub.h"
 
+typedef struct {
+    UA_UInt64 sequence __attribute__((aligned(CACHE_LINE_SIZE)));
+    size_t size;
+    UA_Byte *values;
+} SampleSnapshot;
+
+typedef struct {
+    UA_NodeId nodeId;
+    const UA_DataType *type;
+    size_t arrayLength;
+    void *value;
+    UA_Boolean *updated;
+    SampleSnapshot *snapshot;
+    size_t snapshotOffset;
+} ReceivedField;
+
+typedef struct {
+    DataSetLayout *layout;
+    ReceivedField *fields;
+    UA_Boolean updated;
+    DataSetValues *generatedValues;
+    SampleSnapshot *snapshot;
+} ReceivedFields;
+
+typedef UA_Byte TemplateVector __attribute__((vector_size(TEMPLATE_VECTOR_SIZE)));
+
+typedef struct {
+    size_t offset;
+    size_t length;
+    void *value;
+} FixedField;
+
+typedef struct {
+    UA_Boolean learned;
+    size_t length;
+    size_t vectorsSize;
+    TemplateVector *template;
+    TemplateVector *mask;
+    FixedField *fields;
+    size_t fieldsSize;
+    DataSetValues *generatedValues;
+    size_t fieldRegionOffset;
+    UA_UInt64 fixedDecodes;
+    UA_UInt64 fullDecodes;
+} FixedLayoutDecoder;
+
+typedef struct {
+    UA_UInt64 newest;
+    UA_UInt64 seen;
+    UA_UInt64 arrivals[DUPLICATE_WINDOW];
+    UA_Byte paths[DUPLICATE_WINDOW];
+} DuplicateFilter;
+
+typedef enum {
+    SUBSCRIBE_INTERVAL_HISTOGRAM,
+    PROCESSING_DURATION_HISTOGRAM,
+    SUBSCRIBE_HISTOGRAMS
+} SubscribeHistogram;
+
+typedef struct {
+    SourceKey key;
+    UA_UInt64 index;
+    char dataSetName[NODE_NAME_LENGTH];
+    char histogramNames[SUBSCRIBE_HISTOGRAMS][NODE_NAME_LENGTH];
+    UA_NodeId readerGroupIdent;
+    UA_DataSetReader *reader;
+    ReceivedFields fields;
+    FixedLayoutDecoder decoder;
+    Histogram *histograms;
+    UA_UInt64 writeIndex;
+    UA_UInt64 receivedMessages;
+    UA_UInt64 previousTimestamp;
+    UA_UInt64 nextValue;
+    UA_UInt64 lostMessages;
+    UA_UInt64 reorderedMessages;
+    DuplicateFilter duplicateFilter;
+} Source;
+
+typedef struct {
+    Source *sources;
+    size_t sourcesSize;
+    Source **slots;
+    size_t slotsMask;
+    UA_Boolean fixedLayout;
+    UA_UInt64 unknownMessages;
+    XdpSocket xdp;
+    UA_PubSubChannel *channels[REDUNDANT_PATHS];
+    int sockfds[REDUNDANT_PATHS];
+    UA_ByteString message;
+    Histogram *histograms;
+    Statistics statistics;
+    UA_WriterGroup *echoWriterGroup;
+    UA_DataValue *echoValue;
+    UA_UInt64 echoCounter;
+    Histogram *echoHistogram;
+    Histogram *pathLeads;
+    TraceBuffer trace;
+    CooperativeServer *cooperative;
+    SecureChannel secure;
+    UA_UInt64 receivedCopies[REDUNDANT_PATHS];
+    UA_UInt64 pathWins[REDUNDANT_PATHS];
+    UA_UInt64 firstCopies;
+    UA_UInt64 lateCopies;
+} Subscriber;
+
+typedef struct {
+    Subscriber *subscriber;
+    UA_UInt64 reads;
+    UA_UInt64 retries;
+    UA_UInt64 inconsistentReads;
+    pthread_t thread;
+} SnapshotReader;
+
 static void
 addReaderGroup(UA_Server *server, UA_NodeId connectionIdent, UA_NodeId *readerGroupIdent) {
     // add a reader group to the pubsub connection
@@ -14,38 +127,50 @@ addReaderGroup(UA_Server *server, UA_NodeId connectionIdent, UA_NodeId *readerGr
 }
 
 static void
-addDataSetReader(UA_Server *server, UA_DataSetReaderConfig *readerConfig, UA_NodeId readerGroupIdent, UA_NodeId *readerIdent) {
-    // add a data set reader to the reader group
-    UA_UInt16 publisherIdentifier = PUBLISHER_ID;
+addDataSetReader(UA_Server *server, UA_DataSetReaderConfig *readerConfig, DataSetLayout *layout, Source *source, UA_NodeId *readerIdent) {
+    // add a data set reader for the source to its reader group
+    UA_UInt16 publisherIdentifier = source->key.publisherId;
     memset(readerConfig, 0, sizeof(UA_DataSetReaderConfig));
     readerConfig->name = UA_STRING("ReaderConfig");
     readerConfig->publisherId.type = &UA_TYPES[UA_TYPES_UINT16];
     readerConfig->publisherId.data = &publisherIdentifier;
-    readerConfig->writerGroupId = WRITER_GROUP_ID;
-    readerConfig->dataSetWriterId = DATA_SET_WRITER_ID;
+    readerConfig->writerGroupId = source->key.writerGroupId;
+    readerConfig->dataSetWriterId = source->key.dataSetWriterId;
     readerConfig->messageSettings.encoding = UA_EXTENSIONOBJECT_DECODED;
     readerConfig->messageSettings.content.decoded.type = &UA_TYPES[UA_TYPES_UADPDATASETREADERMESSAGEDATATYPE];
     UA_UadpDataSetReaderMessageDataType *dataSetReaderMessage = UA_UadpDataSetReaderMessageDataType_new();
-    dataSetReaderMessage->networkMessageContentMask = (UA_UadpNetworkMessageContentMask) UA_UADPNETWORKMESSAGECONTENTMASK_PUBLISHERID |
-                                                      (UA_UadpNetworkMessageContentMask) UA_UADPNETWORKMESSAGECONTENTMASK_GROUPHEADER |
-                                                      (UA_UadpNetworkMessageContentMask) UA_UADPNETWORKMESSAGECONTENTMASK_WRITERGROUPID |
-                                                      (UA_UadpNetworkMessageContentMask) UA_UADPNETWORKMESSAGECONTENTMASK_PAYLOADHEADER;
+    dataSetReaderMessage->networkMessageContentMask = NETWORK_MESSAGE_CONTENT_MASK;
     readerConfig->messageSettings.content.decoded.data = dataSetReaderMessage;
     UA_DataSetMetaDataType *metaData = &readerConfig->dataSetMetaData;
     UA_DataSetMetaDataType_init(metaData);
-    metaData->name = UA_STRING("SubscribedDataSet");
-    metaData->fieldsSize = 1;
+    metaData->name = UA_STRING(source->dataSetName);
+    metaData->fieldsSize = layout->fieldsSize;
     metaData->fields = (UA_FieldMetaData *) UA_Array_new(metaData->fieldsSize, &UA_TYPES[UA_TYPES_FIELDMETADATA]);
     if (!metaData->fields) {
         UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Array_new failed");
         exit(EXIT_FAILURE);
     }
-    UA_FieldMetaData_init(&metaData->fields[0]);
-    UA_NodeId_copy(&UA_TYPES[UA_TYPES_UINT64].typeId, &metaData->fields[0].dataType);
-    metaData->fields[0].builtInType = UA_NS0ID_UINT64;
-    metaData->fields[0].name = UA_STRING(VARIABLE_NAME);
-    metaData->fields[0].valueRank = -1;
-    if (UA_Server_addDataSetReader(server, readerGroupIdent, readerConfig, readerIdent) != UA_STATUSCODE_GOOD) {
+    for (size_t i = 0; i < layout->fieldsSize; i++) {
+        const UA_DataType *type = &UA_TYPES[layout->fields[i].typeIndex];
+        UA_FieldMetaData *field = &metaData->fields[i];
+        UA_FieldMetaData_init(field);
+        UA_NodeId_copy(&type->typeId, &field->dataType);
+        field->builtInType = (UA_Byte) type->typeId.identifier.numeric;
+        field->name = UA_STRING(layout->fields[i].name);
+        if (layout->fields[i].arrayLength > 0) {
+            field->valueRank = 1;
+            field->arrayDimensions = (UA_UInt32 *) UA_Array_new(1, &UA_TYPES[UA_TYPES_UINT32]);
+            if (!field->arrayDimensions) {
+                UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Array_new failed");
+                exit(EXIT_FAILURE);
+            }
+            field->arrayDimensionsSize = 1;
+            field->arrayDimensions[0] = layout->fields[i].arrayLength;
+        } else {
+            field->valueRank = -1;
+        }
+    }
+    if (UA_Server_addDataSetReader(server, source->readerGroupIdent, readerConfig, readerIdent) != UA_STATUSCODE_GOOD) {
         UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_addDataSetReader failed");
         exit(EXIT_FAILURE);
     }
@@ -53,9 +178,136 @@ addDataSetReader(UA_Server *server, UA_DataSetReaderConfig *readerConfig, UA_Nod
 }
 
 static void
-addSubscribedVariables(UA_Server *server, UA_NodeId dataSetReaderId, UA_DataSetReaderConfig *readerConfig, UA_NodeId *subscribedValueNodeId,
-                       UA_NodeId readerGroupIdent) {
-    // add a folder for the subscribed data set to the nodeset and link it to the data set reader and initialize the field
+publishSnapshot(ReceivedFields *receivedFields) {
+    // copy the fields into the snapshot without ever waiting for a reader, the sequence is odd while the copy is in progress and
+    // readers retry until they saw the same even sequence before and after their copy
+    SampleSnapshot *snapshot = receivedFields->snapshot;
+    UA_UInt64 sequence = snapshot->sequence;
+    __atomic_store_n(&snapshot->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (size_t i = 0; i < receivedFields->layout->fieldsSize; i++) {
+        ReceivedField *field = &receivedFields->fields[i];
+        memcpy(&snapshot->values[field->snapshotOffset], field->value, (field->arrayLength > 0 ? field->arrayLength : 1) * field->type->memSize);
+    }
+    __atomic_store_n(&snapshot->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+static UA_UInt64
+readSnapshot(SampleSnapshot *snapshot, size_t offset, size_t length, void *target, UA_UInt64 *retries) {
+    // copy a consistent range of the latest sample from any thread, counts the copies the subscribe thread overwrote and returns the
+    // sequence of the copied sample
+    while (true) {
+        UA_UInt64 sequence = __atomic_load_n(&snapshot->sequence, __ATOMIC_ACQUIRE);
+        if (!(sequence & 1)) {
+            memcpy(target, &snapshot->values[offset], length);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&snapshot->sequence, __ATOMIC_RELAXED) == sequence) {
+                return sequence;
+            }
+        }
+        if (retries != NULL) {
+            (*retries)++;
+        }
+    }
+}
+
+static void
+createReceivedFields(ReceivedFields *receivedFields, DataSetLayout *layout) {
+    // preallocate the memory the reader writes the decoded fields into, nothing is allocated while subscribing, the fields of the
+    // generated layout live in one struct the generated decoder writes
+    receivedFields->layout = layout;
+    receivedFields->updated = false;
+    receivedFields->fields = (ReceivedField *) UA_calloc(layout->fieldsSize, sizeof(ReceivedField));
+    receivedFields->generatedValues = layout->generated ? (DataSetValues *) UA_calloc(1, sizeof(DataSetValues)) : NULL;
+    if (!receivedFields->fields || (layout->generated && !receivedFields->generatedValues)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_calloc failed");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < layout->fieldsSize; i++) {
+        ReceivedField *field = &receivedFields->fields[i];
+        field->type = &UA_TYPES[layout->fields[i].typeIndex];
+        field->arrayLength = layout->fields[i].arrayLength;
+        if (layout->generated) {
+            field->value = (UA_Byte *) receivedFields->generatedValues + dataSetSchema[i].valueOffset;
+        } else {
+            field->value = UA_calloc(field->arrayLength > 0 ? field->arrayLength : 1, field->type->memSize);
+        }
+        field->updated = &receivedFields->updated;
+        if (!field->value) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_calloc failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+    *(UA_UInt64 *) receivedFields->fields[0].value = VARIABLE_START_VALUE;
+    // the snapshot keeps the values of all fields back to back on cache lines of its own
+    SampleSnapshot *snapshot = (SampleSnapshot *) allocateCacheLineAligned(sizeof(SampleSnapshot));
+    memset(snapshot, 0, sizeof(SampleSnapshot));
+    for (size_t i = 0; i < layout->fieldsSize; i++) {
+        ReceivedField *field = &receivedFields->fields[i];
+        field->snapshot = snapshot;
+        field->snapshotOffset = snapshot->size;
+        snapshot->size += (field->arrayLength > 0 ? field->arrayLength : 1) * field->type->memSize;
+    }
+    snapshot->values = (UA_Byte *) allocateCacheLineAligned(snapshot->size);
+    receivedFields->snapshot = snapshot;
+    publishSnapshot(receivedFields);
+}
+
+static void
+deleteReceivedFields(ReceivedFields *receivedFields) {
+    // free the preallocated field memory
+    for (size_t i = 0; i < receivedFields->layout->fieldsSize && !receivedFields->layout->generated; i++) {
+        UA_free(receivedFields->fields[i].value);
+    }
+    UA_free(receivedFields->fields);
+    UA_free(receivedFields->generatedValues);
+    free(receivedFields->snapshot->values);
+    free(receivedFields->snapshot);
+}
+
+static UA_StatusCode
+writeReceivedField(UA_Server *server, const UA_NodeId *sessionId, void *sessionContext, const UA_NodeId *nodeId, void *nodeContext,
+                   const UA_NumericRange *range, const UA_DataValue *data) {
+    // called by the reader instead of writing the field into the nodestore, copies the value into the preallocated memory and flags
+    // the new data, the subscribe thread publishes it into the snapshot
+    ReceivedField *field = (ReceivedField *) nodeContext;
+    if (field == NULL || !data->hasValue || data->value.type != field->type || data->value.arrayLength != field->arrayLength) {
+        return UA_STATUSCODE_BADTYPEMISMATCH;
+    }
+    memcpy(field->value, data->value.data, (field->arrayLength > 0 ? field->arrayLength : 1) * field->type->memSize);
+    *field->updated = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+readReceivedField(UA_Server *server, const UA_NodeId *sessionId, void *sessionContext, const UA_NodeId *nodeId, void *nodeContext,
+                  UA_Boolean includeSourceTimeStamp, const UA_NumericRange *range, UA_DataValue *value) {
+    // serve a read of the field from the snapshot of the latest sample, the server thread never sees a value the subscribe thread is
+    // writing and the subscribe thread never waits for a client
+    ReceivedField *field = (ReceivedField *) nodeContext;
+    size_t length = (field->arrayLength > 0 ? field->arrayLength : 1) * field->type->memSize;
+    if (range != NULL) {
+        return UA_STATUSCODE_BADINDEXRANGEINVALID;
+    }
+    void *data = UA_malloc(length);
+    if (data == NULL) {
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    readSnapshot(field->snapshot, field->snapshotOffset, length, data, NULL);
+    if (field->arrayLength > 0) {
+        UA_Variant_setArray(&value->value, data, field->arrayLength, field->type);
+    } else {
+        UA_Variant_setScalar(&value->value, data, field->type);
+    }
+    value->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+addSubscribedVariables(UA_Server *server, UA_NodeId dataSetReaderId, UA_DataSetReaderConfig *readerConfig, Source *source) {
+    // add a folder for the subscribed data set of the source to the nodeset, link it to the data set reader and initialize the field,
+    // then freeze the reader group of the source, a reader group with a fixed size rt level holds a single reader
+    ReceivedFields *receivedFields = &source->fields;
     UA_NodeId folderId;
     UA_Variant variant;
     UA_String folderName = readerConfig->dataSetMetaData.name;
@@ -74,102 +326,981 @@ addSubscribedVariables(UA_Server *server, UA_NodeId dataSetReaderId, UA_DataSetR
         UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_DataSetReader_addTargetVariables failed");
         exit(EXIT_FAILURE);
     }
-    UA_QualifiedName browsePath[] = {UA_QUALIFIEDNAME(VARIABLE_NAMESPACE_INDEX, VARIABLE_NAME)};
-    UA_BrowsePathResult browsePathResult = UA_Server_browseSimplifiedBrowsePath(server, folderId, 1, browsePath);
-    if (browsePathResult.statusCode != UA_STATUSCODE_GOOD || browsePathResult.targetsSize == 0) {
-        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_browseSimplifiedBrowsePath failed");
-        exit(EXIT_FAILURE);
+    for (size_t i = 0; i < receivedFields->layout->fieldsSize; i++) {
+        UA_QualifiedName browsePath[] = {UA_QUALIFIEDNAME(VARIABLE_NAMESPACE_INDEX, receivedFields->layout->fields[i].name)};
+        UA_BrowsePathResult browsePathResult = UA_Server_browseSimplifiedBrowsePath(server, folderId, 1, browsePath);
+        if (browsePathResult.statusCode != UA_STATUSCODE_GOOD || browsePathResult.targetsSize == 0) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_browseSimplifiedBrowsePath failed");
+            exit(EXIT_FAILURE);
+        }
+        receivedFields->fields[i].nodeId = browsePathResult.targets[0].targetId.nodeId;
+        UA_BrowsePathResult_deleteMembers(&browsePathResult);
     }
-    *subscribedValueNodeId = browsePathResult.targets[0].targetId.nodeId;
-    UA_UInt64 value = VARIABLE_START_VALUE;
-    UA_Variant_setScalar(&variant, &value, &UA_TYPES[UA_TYPES_UINT64]);
-    if (UA_Server_writeValue(server, *subscribedValueNodeId, variant) != UA_STATUSCODE_GOOD) {
+    UA_Variant_setScalar(&variant, receivedFields->fields[0].value, &UA_TYPES[UA_TYPES_UINT64]);
+    if (UA_Server_writeValue(server, receivedFields->fields[0].nodeId, variant) != UA_STATUSCODE_GOOD) {
         UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_writeValue failed");
         exit(EXIT_FAILURE);
     }
-    UA_BrowsePathResult_deleteMembers(&browsePathResult);
+    // the data source keeps the values out of the nodestore, the subscribe thread and the server thread share only the snapshot
+    UA_DataSource dataSource = {readReceivedField, writeReceivedField};
+    for (size_t i = 0; i < receivedFields->layout->fieldsSize; i++) {
+        if (UA_Server_setNodeContext(server, receivedFields->fields[i].nodeId, &receivedFields->fields[i]) != UA_STATUSCODE_GOOD) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_setNodeContext failed");
+            exit(EXIT_FAILURE);
+        }
+        if (UA_Server_setVariableNode_dataSource(server, receivedFields->fields[i].nodeId, dataSource) != UA_STATUSCODE_GOOD) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_setVariableNode_dataSource failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (size_t i = 0; i < readerConfig->dataSetMetaData.fieldsSize; i++) {
+        UA_free(readerConfig->dataSetMetaData.fields[i].arrayDimensions);
+    }
     UA_free(readerConfig->dataSetMetaData.fields);
-    if (UA_Server_freezeReaderGroupConfiguration(server, readerGroupIdent) != UA_STATUSCODE_GOOD) {
+    if (UA_Server_freezeReaderGroupConfiguration(server, source->readerGroupIdent) != UA_STATUSCODE_GOOD) {
         UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_freezeReaderGroupConfiguration failed");
         exit(EXIT_FAILURE);
     }
-    if (UA_Server_setReaderGroupOperational(server, readerGroupIdent) != UA_STATUSCODE_GOOD) {
+    if (UA_Server_setReaderGroupOperational(server, source->readerGroupIdent) != UA_STATUSCODE_GOOD) {
         UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_Server_setReaderGroupOperational failed");
         exit(EXIT_FAILURE);
     }
 }
 
+static size_t
+getSourceSlot(const SourceKey *key, size_t slotsMask) {
+    // multiplicative hash of the three identifiers, the upper bits of the product mix all of them
+    UA_UInt64 packed = (UA_UInt64) key->publisherId << 32 | (UA_UInt64) key->writerGroupId << 16 | key->dataSetWriterId;
+    return (size_t) ((packed * 0x9E3779B97F4A7C15ULL) >> 32) & slotsMask;
+}
+
+static Source *
+findSource(Subscriber *subscriber, const SourceKey *key) {
+    // look the source up by linear probing, the table is at most half full so a miss ends at an empty slot soon
+    size_t slot = getSourceSlot(key, subscriber->slotsMask);
+    while (subscriber->slots[slot] != NULL) {
+        Source *source = subscriber->slots[slot];
+        if (source->key.publisherId == key->publisherId && source->key.writerGroupId == key->writerGroupId &&
+            source->key.dataSetWriterId == key->dataSetWriterId) {
+            return source;
+        }
+        slot = (slot + 1) & subscriber->slotsMask;
+    }
+    return NULL;
+}
+
+static void
+createSources(Subscriber *subscriber, DataSetLayout *layout, PubSubOptions *options) {
+    // create the state of every source and the hash table that maps the identifiers of a message to its source, the receive buffer
+    // has padding for the template compare to read whole vectors
+    subscriber->sourcesSize = options->sourcesSize;
+    subscriber->sources = (Source *) UA_calloc(subscriber->sourcesSize, sizeof(Source));
+    subscriber->histograms = (Histogram *) UA_calloc(subscriber->sourcesSize * SUBSCRIBE_HISTOGRAMS + (options->echo ? 1 : 0) +
+                                                     (options->redundant ? REDUNDANT_PATHS : 0) + (options->cooperativeServer ? 1 : 0), sizeof(Histogram));
+    size_t slotsSize = 1;
+    while (slotsSize < 2 * subscriber->sourcesSize) {
+        slotsSize *= 2;
+    }
+    subscriber->slotsMask = slotsSize - 1;
+    subscriber->slots = (Source **) UA_calloc(slotsSize, sizeof(Source *));
+    subscriber->message.data = (UA_Byte *) UA_calloc(RECEIVE_BUFFER_SIZE + TEMPLATE_VECTOR_SIZE, 1);
+    if (!subscriber->sources || !subscriber->histograms || !subscriber->slots || !subscriber->message.data) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_calloc failed");
+        exit(EXIT_FAILURE);
+    }
+    subscriber->message.length = RECEIVE_BUFFER_SIZE;
+    subscriber->unknownMessages = 0;
+    subscriber->echoWriterGroup = NULL;
+    subscriber->echoHistogram = NULL;
+    if (options->echo) {
+        // the turnaround of the echoes follows the histograms of the sources
+        subscriber->echoHistogram = &subscriber->histograms[subscriber->sourcesSize * SUBSCRIBE_HISTOGRAMS];
+        initHistogram(subscriber->echoHistogram, "EchoTurnaround");
+    }
+    subscriber->pathLeads = NULL;
+    if (options->redundant) {
+        // the lead of every path over the other one when its copy arrived first follows behind
+        subscriber->pathLeads = &subscriber->histograms[subscriber->sourcesSize * SUBSCRIBE_HISTOGRAMS + (options->echo ? 1 : 0)];
+        initHistogram(&subscriber->pathLeads[0], "PrimaryPathLead");
+        initHistogram(&subscriber->pathLeads[1], "RedundantPathLead");
+    }
+    for (size_t i = 0; i < subscriber->sourcesSize; i++) {
+        // a single source keeps the names the statistics and data set had before sources were introduced
+        static const char *histogramNames[SUBSCRIBE_HISTOGRAMS] = {"SubscribeInterval", "ProcessingDuration"};
+        Source *source = &subscriber->sources[i];
+        source->key = options->sources[i];
+        source->index = i;
+        source->histograms = &subscriber->histograms[i * SUBSCRIBE_HISTOGRAMS];
+        if (subscriber->sourcesSize > 1) {
+            snprintf(source->dataSetName, NODE_NAME_LENGTH, "SubscribedDataSet%zu", i);
+        } else {
+            snprintf(source->dataSetName, NODE_NAME_LENGTH, "SubscribedDataSet");
+        }
+        for (size_t j = 0; j < SUBSCRIBE_HISTOGRAMS; j++) {
+            if (subscriber->sourcesSize > 1) {
+                snprintf(source->histogramNames[j], NODE_NAME_LENGTH, "%s%zu", histogramNames[j], i);
+            } else {
+                snprintf(source->histogramNames[j], NODE_NAME_LENGTH, "%s", histogramNames[j]);
+            }
+            initHistogram(&source->histograms[j], source->histogramNames[j]);
+        }
+        createReceivedFields(&source->fields, layout);
+        size_t slot = getSourceSlot(&source->key, subscriber->slotsMask);
+        while (subscriber->slots[slot] != NULL) {
+            slot = (slot + 1) & subscriber->slotsMask;
+        }
+        subscriber->slots[slot] = source;
+    }
+}
+
+static void
+deleteSources(Subscriber *subscriber) {
+    // free the receive buffer, the learned templates and the fields of all sources
+    for (size_t i = 0; i < subscriber->sourcesSize; i++) {
+        free(subscriber->sources[i].decoder.template);
+        free(subscriber->sources[i].decoder.mask);
+        UA_free(subscriber->sources[i].decoder.fields);
+        deleteReceivedFields(&subscriber->sources[i].fields);
+    }
+    UA_free(subscriber->message.data);
+    UA_free(subscriber->slots);
+    UA_free(subscriber->histograms);
+    UA_free(subscriber->sources);
+}
+
+static void
+addEchoWriterGroup(UA_Server *server, Subscriber *subscriber, UA_UInt64 cycle_time_ns, PubSubOptions *options) {
+    // add a connection to the echo address and a writer group with the identifiers of the source that carries the counter of every
+    // received message back to the publisher, the subscribe thread publishes it right after the message was decoded
+    SourceKey *key = &subscriber->sources[0].key;
+    UA_NodeId connectionIdent, publishedDataSetIdent, writerGroupIdent;
+    PubSubOptions echoOptions = *options;
+    subscriber->echoCounter = VARIABLE_START_VALUE;
+    subscriber->echoValue = UA_DataValue_new();
+    if (!subscriber->echoValue) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_DataValue_new failed");
+        exit(EXIT_FAILURE);
+    }
+    UA_Variant_setScalar(&subscriber->echoValue->value, &subscriber->echoCounter, &UA_TYPES[UA_TYPES_UINT64]);
+    addPubSubConnection(server, &options->echoTransportProfile, &options->echoAddress, key->publisherId, &connectionIdent);
+    // the echoes leave as soon as they are published and nobody collects their tx timestamps
+    echoOptions.blockingReceive = false;
+    echoOptions.txtimeOffset_ns = 0;
+    echoOptions.txTimestamps = false;
+    setupSocket(UA_PubSubConnection_findConnectionbyId(server, connectionIdent)->channel->sockfd, &options->echoAddress, &echoOptions);
+    addPublishedDataSet(server, &publishedDataSetIdent);
+    addStaticDataSetField(server, publishedDataSetIdent, ECHO_FIELD_NAME, &subscriber->echoValue);
+    addWriterGroup(server, cycle_time_ns, key->writerGroupId, connectionIdent, &writerGroupIdent);
+    addDataSetWriter(server, key->dataSetWriterId, writerGroupIdent, publishedDataSetIdent);
+    subscriber->echoWriterGroup = UA_WriterGroup_findWGbyId(server, writerGroupIdent);
+}
+
+static UA_Boolean
+parseSourceKey(const UA_ByteString *message, SourceKey *key) {
+    // read the identifiers of a uadp network message with a single data set message from its headers without decoding it, returns
+    // false for chunks, discovery messages, string publisher ids and everything the readers of the sources cannot take
+    const UA_Byte *data = message->data;
+    size_t length = message->length;
+    size_t position = 1;
+    UA_Byte flags, extendedFlags1 = 0, extendedFlags2 = 0;
+    UA_UInt64 publisherId = 0;
+    if (length < 1) {
+        return false;
+    }
+    flags = data[0];
+    if (flags & UADP_FLAGS_EXTENDEDFLAGS1) {
+        if (position >= length) {
+            return false;
+        }
+        extendedFlags1 = data[position++];
+    }
+    if (extendedFlags1 & UADP_EXTENDEDFLAGS1_EXTENDEDFLAGS2) {
+        if (position >= length) {
+            return false;
+        }
+        extendedFlags2 = data[position++];
+    }
+    if (!(flags & UADP_FLAGS_PUBLISHERID) || !(flags & UADP_FLAGS_GROUPHEADER) || !(flags & UADP_FLAGS_PAYLOADHEADER) ||
+        (extendedFlags2 & UADP_EXTENDEDFLAGS2_CHUNK_OR_NOT_DATASET)) {
+        return false;
+    }
+    // the publisher id types byte, uint16, uint32 and uint64 are 1, 2, 4 and 8 bytes wide
+    UA_Byte publisherIdType = extendedFlags1 & UADP_EXTENDEDFLAGS1_PUBLISHERIDTYPE;
+    if (publisherIdType > UA_PUBLISHERDATATYPE_UINT64) {
+        return false;
+    }
+    size_t publisherIdSize = (size_t) 1 << publisherIdType;
+    if (position + publisherIdSize > length) {
+        return false;
+    }
+    for (size_t i = 0; i < publisherIdSize; i++) {
+        publisherId |= (UA_UInt64) data[position + i] << (8 * i);
+    }
+    position += publisherIdSize;
+    if (extendedFlags1 & UADP_EXTENDEDFLAGS1_DATASETCLASSID) {
+        position += UADP_DATASETCLASSID_LENGTH;
+    }
+    if (position >= length) {
+        return false;
+    }
+    UA_Byte groupFlags = data[position++];
+    if (!(groupFlags & UADP_GROUPFLAGS_WRITERGROUPID) || position + sizeof(UA_UInt16) > length) {
+        return false;
+    }
+    UA_UInt16 writerGroupId = (UA_UInt16) (data[position] | data[position + 1] << 8);
+    position += sizeof(UA_UInt16);
+    position += (groupFlags & UADP_GROUPFLAGS_GROUPVERSION) ? sizeof(UA_UInt32) : 0;
+    position += (groupFlags & UADP_GROUPFLAGS_NETWORKMESSAGENUMBER) ? sizeof(UA_UInt16) : 0;
+    position += (groupFlags & UADP_GROUPFLAGS_SEQUENCENUMBER) ? sizeof(UA_UInt16) : 0;
+    if (position + 1 + sizeof(UA_UInt16) > length || data[position] != 1 || publisherId > UINT16_MAX) {
+        return false;
+    }
+    key->publisherId = (UA_UInt16) publisherId;
+    key->writerGroupId = writerGroupId;
+    key->dataSetWriterId = (UA_UInt16) (data[position + 1] | data[position + 2] << 8);
+    return true;
+}
+
+static UA_Boolean
+getMessageSourceKey(UA_NetworkMessage *networkMessage, SourceKey *key) {
+    // returns true and the identifiers if the decoded network message carries a single data set message a reader can take
+    UA_UInt64 publisherId;
+    switch (networkMessage->publisherIdType) {
+        case UA_PUBLISHERDATATYPE_BYTE:
+            publisherId = networkMessage->publisherId.publisherIdByte;
+            break;
+        case UA_PUBLISHERDATATYPE_UINT16:
+            publisherId = networkMessage->publisherId.publisherIdUInt16;
+            break;
+        case UA_PUBLISHERDATATYPE_UINT32:
+            publisherId = networkMessage->publisherId.publisherIdUInt32;
+            break;
+        case UA_PUBLISHERDATATYPE_UINT64:
+            publisherId = networkMessage->publisherId.publisherIdUInt64;
+            break;
+        default:
+            return false;
+    }
+    if (!networkMessage->publisherIdEnabled || publisherId > UINT16_MAX || !networkMessage->groupHeaderEnabled ||
+        !networkMessage->groupHeader.writerGroupIdEnabled || !networkMessage->payloadHeaderEnabled ||
+        networkMessage->payloadHeader.dataSetPayloadHeader.count != 1) {
+        return false;
+    }
+    key->publisherId = (UA_UInt16) publisherId;
+    key->writerGroupId = networkMessage->groupHeader.writerGroupId;
+    key->dataSetWriterId = networkMessage->payloadHeader.dataSetPayloadHeader.dataSetWriterIds[0];
+    return true;
+}
+
+static void
+learnFixedLayout(Source *source, const UA_ByteString *message, UA_NetworkMessage *networkMessage) {
+    // take the message as template of the source, the offsets of its sequence numbers and field values are computed by the encoder the
+    // writer group uses for its buffered message, all other bytes are compared against the template, the decoder stays unlearned on any
+    // surprise
+    FixedLayoutDecoder *decoder = &source->decoder;
+    ReceivedFields *receivedFields = &source->fields;
+    UA_NetworkMessageOffsetBuffer offsetBuffer;
+    memset(&offsetBuffer, 0, sizeof(UA_NetworkMessageOffsetBuffer));
+    size_t fieldsSize = 0;
+    UA_Boolean fixed = UA_NetworkMessage_calcSizeBinary(networkMessage, &offsetBuffer) == message->length;
+    decoder->length = message->length;
+    decoder->vectorsSize = (message->length + TEMPLATE_VECTOR_SIZE - 1) / TEMPLATE_VECTOR_SIZE;
+    decoder->template = (TemplateVector *) allocateCacheLineAligned(decoder->vectorsSize * sizeof(TemplateVector));
+    decoder->mask = (TemplateVector *) allocateCacheLineAligned(decoder->vectorsSize * sizeof(TemplateVector));
+    decoder->fields = (FixedField *) UA_calloc(receivedFields->layout->fieldsSize, sizeof(FixedField));
+    if (!decoder->fields) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_calloc failed");
+        exit(EXIT_FAILURE);
+    }
+    UA_Byte *template = (UA_Byte *) decoder->template;
+    UA_Byte *mask = (UA_Byte *) decoder->mask;
+    memset(template, 0, decoder->vectorsSize * sizeof(TemplateVector));
+    memset(mask, 0, decoder->vectorsSize * sizeof(TemplateVector));
+    memcpy(template, message->data, message->length);
+    memset(mask, 0xFF, message->length);
+    for (size_t i = 0; i < offsetBuffer.offsetsSize && fixed; i++) {
+        UA_NetworkMessageOffset *offset = &offsetBuffer.offsets[i];
+        switch (offset->contentType) {
+            case UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_SEQUENCENUMBER:
+            case UA_PUBSUB_OFFSETTYPE_NETWORKMESSAGE_SEQUENCENUMBER:
+                memset(&mask[offset->offset], 0, sizeof(UA_UInt16));
+                break;
+            case UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT: {
+                if (fieldsSize == receivedFields->layout->fieldsSize) {
+                    fixed = false;
+                    break;
+                }
+                ReceivedField *field = &receivedFields->fields[fieldsSize];
+                size_t headerSize = getFixedVariantHeaderSize(&message->data[offset->offset], field->type, field->arrayLength);
+                size_t length = (field->arrayLength > 0 ? field->arrayLength : 1) * field->type->memSize;
+                if (headerSize == 0 || offset->offset + headerSize + length > message->length) {
+                    fixed = false;
+                    break;
+                }
+                decoder->fields[fieldsSize].offset = offset->offset + headerSize;
+                decoder->fields[fieldsSize].length = length;
+                decoder->fields[fieldsSize].value = field->value;
+                memset(&mask[offset->offset + headerSize], 0, length);
+                fieldsSize++;
+                break;
+            }
+            default:
+                fixed = false;
+                break;
+        }
+    }
+    // the offset values belong to the decoded message
+    UA_free(offsetBuffer.offsets);
+    if (!fixed || fieldsSize != receivedFields->layout->fieldsSize) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the message has no fixed layout, all messages go through the full decoder");
+        return;
+    }
+    decoder->fieldsSize = fieldsSize;
+    decoder->learned = true;
+    if (receivedFields->generatedValues != NULL) {
+        // the generated decoder replaces the copy loop if the fields fill the end of the message exactly like the schema says
+        size_t fieldRegionOffset = message->length - DATASET_ENCODED_SIZE;
+        UA_Boolean generated = message->length >= DATASET_ENCODED_SIZE;
+        for (size_t i = 0; i < fieldsSize && generated; i++) {
+            generated = decoder->fields[i].offset == fieldRegionOffset + dataSetSchema[i].encodedValueOffset;
+        }
+        if (generated) {
+            decoder->generatedValues = receivedFields->generatedValues;
+            decoder->fieldRegionOffset = fieldRegionOffset;
+        } else {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the message does not match the generated decoder, regenerate the codec");
+        }
+    }
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "fixed layout learned: %zu bytes, %zu fields", decoder->length, decoder->fieldsSize);
+}
+
+static Source *
+decodeFull(UA_Server *server, Subscriber *subscriber) {
+    // decode the message and let the reader of its source write the fields into the target variables like
+    // UA_ReaderGroup_subscribeCallback does, the first message of a source is used to learn its fixed layout, returns the source or NULL
+    UA_NetworkMessage networkMessage;
+    SourceKey key;
+    Source *source = NULL;
+    size_t offset = 0;
+    memset(&networkMessage, 0, sizeof(UA_NetworkMessage));
+    if (UA_NetworkMessage_decodeBinary(&subscriber->message, &offset, &networkMessage) == UA_STATUSCODE_GOOD &&
+        getMessageSourceKey(&networkMessage, &key)) {
+        source = findSource(subscriber, &key);
+    }
+    TRACE_STAGE(SUBSCRIBE_TRACE_DECODED);
+    if (source != NULL) {
+        if (subscriber->fixedLayout && !source->decoder.learned && source->decoder.template == NULL) {
+            learnFixedLayout(source, &subscriber->message, &networkMessage);
+        }
+        UA_Server_DataSetReader_process(server, source->reader, &networkMessage.payload.dataSetPayload.dataSetMessages[0]);
+        TRACE_STAGE(SUBSCRIBE_TRACE_WRITTEN);
+        source->decoder.fullDecodes++;
+    } else {
+        subscriber->unknownMessages++;
+    }
+    UA_NetworkMessage_clear(&networkMessage);
+    return source;
+}
+static UA_Boolean
+matchFixedLayout(FixedLayoutDecoder *decoder, const UA_ByteString *message) {
+    // compare all bytes of the message except the sequence numbers and field values with the template, a vector at a time
+    if (!decoder->learned || message->length != decoder->length) {
+        return false;
+    }
+    TemplateVector difference = {0};
+    for (size_t i = 0; i < decoder->vectorsSize; i++) {
+        TemplateVector chunk;
+        memcpy(&chunk, &message->data[i * TEMPLATE_VECTOR_SIZE], TEMPLATE_VECTOR_SIZE);
+        difference |= (chunk ^ decoder->template[i]) & decoder->mask[i];
+    }
+    UA_UInt64 words[TEMPLATE_VECTOR_SIZE / sizeof(UA_UInt64)];
+    UA_UInt64 differentBits = 0;
+    memcpy(words, &difference, TEMPLATE_VECTOR_SIZE);
+    for (size_t i = 0; i < TEMPLATE_VECTOR_SIZE / sizeof(UA_UInt64); i++) {
+        differentBits |= words[i];
+    }
+    return differentBits == 0;
+}
+
+static void
+decodeFixedLayout(FixedLayoutDecoder *decoder, const UA_ByteString *message) {
+    // copy the field values at their fixed offsets straight into the preallocated fields, the template already checked the encoding
+    // masks and array lengths the generated decoder compares again
+    if (decoder->generatedValues != NULL) {
+        decodeDataSetFields(&message->data[decoder->fieldRegionOffset], decoder->generatedValues);
+        decoder->fixedDecodes++;
+        return;
+    }
+    for (size_t i = 0; i < decoder->fieldsSize; i++) {
+        memcpy(decoder->fields[i].value, &message->data[decoder->fields[i].offset], decoder->fields[i].length);
+    }
+    decoder->fixedDecodes++;
+}
+
+static Source *
+subscribeDispatched(UA_Server *server, Subscriber *subscriber, size_t path) {
+    // receive one message from the channel of the path and dispatch it to its source by the identifiers in its headers, the message is
+    // decoded by the fixed offsets of the source if it matches its template and by the full decoder otherwise, unlike
+    // UA_ReaderGroup_subscribeCallback the fixed layout path does not pass the values through the target variables, returns the source of
+    // the message or NULL
+    UA_PubSubChannel *channel = subscriber->channels[path];
+    SourceKey key;
+    subscriber->message.length = RECEIVE_BUFFER_SIZE;
+    if (channel->receive(channel, &subscriber->message, NULL, RECEIVE_TIMEOUT_US) != UA_STATUSCODE_GOOD || subscriber->message.length == 0) {
+        return NULL;
+    }
+    if (!parseSourceKey(&subscriber->message, &key)) {
+        // the full decoder also takes the headers the parser does not know
+        return decodeFull(server, subscriber);
+    }
+    Source *source = findSource(subscriber, &key);
+    if (source == NULL) {
+        subscriber->unknownMessages++;
+        return NULL;
+    }
+    if (subscriber->fixedLayout && matchFixedLayout(&source->decoder, &subscriber->message)) {
+        decodeFixedLayout(&source->decoder, &subscriber->message);
+        TRACE_STAGE(SUBSCRIBE_TRACE_DECODED);
+        source->fields.updated = true;
+        return source;
+    }
+    return decodeFull(server, subscriber);
+}
+
+static void
+benchmarkDecode(UA_Server *server, Subscriber *subscriber, Source *source, UA_UInt64 messages) {
+    // decode the last received message with the full decoder and the fixed layout decoder of its source and log the time per message
+    static const char *decoderNames[] = {"full decode", "fixed layout decode"};
+    for (size_t decoder = 0; decoder < sizeof(decoderNames) / sizeof(decoderNames[0]); decoder++) {
+        UA_UInt64 startTimestamp = getCurrentTimestamp();
+        for (UA_UInt64 i = 0; i < messages; i++) {
+            if (decoder == 0) {
+                decodeFull(server, subscriber);
+            } else if (matchFixedLayout(&source->decoder, &subscriber->message)) {
+                decodeFixedLayout(&source->decoder, &subscriber->message);
+            }
+        }
+        UA_UInt64 duration = getCurrentTimestamp() - startTimestamp;
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "%s: %.1f ns per message of %zu bytes",
+                    decoderNames[decoder], (UA_Double) duration / (UA_Double) messages, subscriber->message.length);
+    }
+}
+
+static void
+countSequence(Source *source, UA_UInt64 value, UA_UInt64 step) {
+    // the counter of the publisher numbers its messages, a jump ahead counts the messages in between as lost, a counter behind the
+    // expected one is a reordered or duplicated message and leaves the expectation as it is
+    if (source->nextValue > 0 && value < source->nextValue) {
+        source->reorderedMessages++;
+        return;
+    }
+    if (source->nextValue > 0) {
+        source->lostMessages += (value - source->nextValue) / step;
+    }
+    source->nextValue = value + step;
+}
+
+static UA_Boolean
+acceptFirstCopy(Subscriber *subscriber, DuplicateFilter *filter, UA_UInt64 index, size_t path, UA_UInt64 arrivalTimestamp) {
+    // the sliding window remembers which of the last DUPLICATE_WINDOW messages of the source arrived and the path and arrival of their
+    // first copy, returns true for a first copy, a second copy records how far the path of the first one was ahead and a copy behind the
+    // window is dropped as late
+    subscriber->receivedCopies[path]++;
+    if (index > filter->newest) {
+        UA_UInt64 shift = index - filter->newest;
+        filter->seen = shift >= DUPLICATE_WINDOW ? 0 : filter->seen << shift;
+        filter->newest = index;
+    } else if (filter->newest - index >= DUPLICATE_WINDOW) {
+        subscriber->lateCopies++;
+        return false;
+    } else if (filter->seen & (1ULL << (filter->newest - index))) {
+        size_t slot = index & (DUPLICATE_WINDOW - 1);
+        UA_UInt64 firstArrival = filter->arrivals[slot];
+        if (filter->paths[slot] != path) {
+            // a copy of the same path is a duplicate of the network itself and no race between the paths
+            subscriber->pathWins[filter->paths[slot]]++;
+            recordHistogramValue(&subscriber->pathLeads[filter->paths[slot]], arrivalTimestamp > firstArrival ? arrivalTimestamp - firstArrival : 0);
+        }
+        return false;
+    }
+    size_t slot = index & (DUPLICATE_WINDOW - 1);
+    filter->seen |= 1ULL << (filter->newest - index);
+    filter->arrivals[slot] = arrivalTimestamp;
+    filter->paths[slot] = (UA_Byte) path;
+    subscriber->firstCopies++;
+    return true;
+}
+
+static UA_Boolean
+checkSnapshot(ReceivedFields *receivedFields, const UA_Byte *values) {
+    // the publisher derives every field of a sample from its counter, a torn snapshot mixes the fields of two samples, returns false
+    // if any field does not belong to the counter of the snapshot
+    DataSetLayout *layout = receivedFields->layout;
+    size_t fieldsSize = layout->fieldsSize - (layout->batchSize > 0 ? BATCH_FIELDS : 0);
+    UA_UInt64 counter;
+    memcpy(&counter, &values[receivedFields->fields[0].snapshotOffset], sizeof(UA_UInt64));
+    if (counter == VARIABLE_START_VALUE) {
+        // nothing was received yet
+        return true;
+    }
+    for (size_t i = 1; i < fieldsSize; i++) {
+        ReceivedField *field = &receivedFields->fields[i];
+        UA_UInt32 elements = field->arrayLength > 0 ? (UA_UInt32) field->arrayLength : 1;
+        for (UA_UInt32 j = 0; j < elements; j++) {
+            UA_Byte expected[sizeof(UA_UInt64)] = {0};
+            setDerivedSample(layout->fields[i].typeIndex, expected, 0, counter + i + j);
+            if (memcmp(expected, &values[field->snapshotOffset + j * field->type->memSize], field->type->memSize) != 0) {
+                return false;
+            }
+        }
+    }
+    if (layout->batchSize > 0) {
+        // the counter is the last sample of the batch, the samples before it count up to it
+        UA_UInt64 sampleValue;
+        for (UA_UInt32 i = 0; i < layout->batchSize; i++) {
+            memcpy(&sampleValue, &values[receivedFields->fields[fieldsSize].snapshotOffset + i * sizeof(UA_UInt64)], sizeof(UA_UInt64));
+            if (sampleValue != counter - (layout->batchSize - 1 - i)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void *
+snapshotReadLoop(void *args) {
+    // hammer the snapshots of all sources with reads while the subscribe thread publishes into them and check every copy, this is what
+    // the server thread does on every client read of a field
+    ThreadArguments *arguments = (ThreadArguments *) args;
+    SnapshotReader *reader = arguments->variable;
+    UA_Boolean *running = arguments->running;
+    Subscriber *subscriber = reader->subscriber;
+    UA_free(arguments);
+    UA_Byte *values = (UA_Byte *) allocateCacheLineAligned(subscriber->sources[0].fields.snapshot->size);
+    for (size_t i = 0; __atomic_load_n(running, __ATOMIC_RELAXED); i = (i + 1) % subscriber->sourcesSize) {
+        ReceivedFields *receivedFields = &subscriber->sources[i].fields;
+        readSnapshot(receivedFields->snapshot, 0, receivedFields->snapshot->size, values, &reader->retries);
+        reader->reads++;
+        if (!checkSnapshot(receivedFields, values)) {
+            reader->inconsistentReads++;
+        }
+    }
+    free(values);
+    return NULL;
+}
+
+static void
+startSnapshotReaders(Subscriber *subscriber, SnapshotReader *readers, size_t readersSize, UA_Boolean *running) {
+    // start the snapshot readers next to the server thread, they compete with it and not with the subscribe thread
+    for (size_t i = 0; i < readersSize; i++) {
+        ThreadArguments *args = (ThreadArguments *) UA_malloc(sizeof(ThreadArguments));
+        if (args == NULL) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "UA_malloc failed: %s", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        memset(&readers[i], 0, sizeof(SnapshotReader));
+        readers[i].subscriber = subscriber;
+        args->variable = &readers[i];
+        args->running = running;
+        startThread(&readers[i].thread, snapshotReadLoop, args, NON_RT_THREAD_PRIORITY, CPU_ONE);
+    }
+}
+
+static UA_Boolean
+stopSnapshotReaders(SnapshotReader *readers, size_t readersSize) {
+    // wait for the snapshot readers and log their reads, returns false if any read was inconsistent
+    UA_UInt64 reads = 0, retries = 0, inconsistentReads = 0;
+    for (size_t i = 0; i < readersSize; i++) {
+        waitForThreadTermination(readers[i].thread, false);
+        reads += readers[i].reads;
+        retries += readers[i].retries;
+        inconsistentReads += readers[i].inconsistentReads;
+    }
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "%zu snapshot readers: %llu reads, %llu retries, %llu inconsistent snapshots", readersSize,
+                (unsigned long long) reads, (unsigned long long) retries, (unsigned long long) inconsistentReads);
+    return inconsistentReads == 0;
+}
+
 static void *
 customSubscribeLoop(void *args) {
     // this is the function responsible for subscribing
     ThreadArguments *arguments = (ThreadArguments *) args;
     UA_Server *server = arguments->server;
     UA_ReaderGroup *readerGroup = arguments->data;
-    UA_NodeId subscribedValueNodeId = *(UA_NodeId *) arguments->variable;
-    UA_UInt64 *receivedValues = arguments->values;
-    UA_UInt64 *receivedTimestamps = arguments->timestamps;
+    Subscriber *subscriber = arguments->variable;
+    size_t fieldsSize = subscriber->sources[0].fields.layout->fieldsSize;
+    UA_UInt32 batchSize = subscriber->sources[0].fields.layout->batchSize;
+    LogRing *ring = arguments->ring;
+    UA_UInt64 cycle_time_ns = arguments->cycle_time_ns;
     UA_UInt64 measurements = arguments->measurements;
     UA_Boolean *running = arguments->running;
+    UA_Boolean blockingReceive = arguments->options->blockingReceive;
+    XdpSocket *xdp = arguments->options->xdp ? &subscriber->xdp : NULL;
+    UA_UInt64 decodeBenchmarkMessages = arguments->options->decodeBenchmarkMessages;
+    UA_Boolean redundant = arguments->options->redundant;
+    CooperativeServer *cooperative = subscriber->cooperative;
+    SecureChannel *secure = arguments->options->securityMode != SECURITY_MODE_NONE ? &subscriber->secure : NULL;
+    // a single source on a single path without the fixed layout keeps the subscribe callback of the reader group, everything else is
+    // dispatched here
+    UA_Boolean dispatch = subscriber->sourcesSize > 1 || subscriber->fixedLayout || redundant;
+    UA_UInt64 lastWarmupValue = VARIABLE_START_VALUE + arguments->options->warmupCycles;
+    int sockfd = arguments->sockfd;
+    if (arguments->options->lockMemory) {
+        prefaultStack();
+    }
     UA_free(arguments);
-    UA_UInt64 writeIndex = 0;
-    UA_Variant beforeVariant, afterVariant;
+    UA_UInt64 loggedRecords = 0;
+    UA_UInt64 completedSources = 0;
+    UA_UInt64 measuredMessages = 0;
+    UA_UInt64 measurementMinorFaults = 0, measurementMajorFaults = 0;
+    UA_UInt64 measurementCpuTime = 0;
+    UA_UInt64 arrivalTimestamp = 0;
+    UA_UInt64 expectedTimestamp = 0;
+    UA_UInt64 echoTurnaround = 0;
     while (*running) {
-        UA_Server_readValue(server, subscribedValueNodeId, &beforeVariant);
-        UA_ReaderGroup_subscribeCallback(server, readerGroup);
-        UA_UInt64 currentTimestamp = getCurrentTimestamp();
-        UA_Server_readValue(server, subscribedValueNodeId, &afterVariant);
-        UA_UInt64 beforeValue = *(UA_UInt64 *) beforeVariant.data;
-        UA_UInt64 afterValue = *(UA_UInt64 *) afterVariant.data;
-        UA_Variant_deleteMembers(&beforeVariant);
-        UA_Variant_deleteMembers(&afterVariant);
-        if (beforeValue != afterValue) {
-            receivedValues[writeIndex] = afterValue;
-            receivedTimestamps[writeIndex] = currentTimestamp;
-            writeIndex++;
-        }
-        if (writeIndex == measurements) {
+        TRACE_BEGIN(&subscriber->trace);
+        size_t path = 0;
+        if (redundant) {
+            // wait for both paths and take the copy the kernel received first, the copy of the other path is the next one to be received
+            UA_UInt64 deadline = getCurrentTimestamp() + RECEIVE_DEADLINE_CYCLES * cycle_time_ns;
+            int readyPath = waitForFirstMessage(subscriber->sockfds, REDUNDANT_PATHS, deadline, &arrivalTimestamp);
+            if (readyPath < 0) {
+                if (cooperative != NULL) {
+                    runCooperativeServer(cooperative, getCurrentTimestamp() + cycle_time_ns);
+                }
+                continue;
+            }
+            path = (size_t) readyPath;
+        } else if (blockingReceive) {
+            UA_UInt64 deadline = getCurrentTimestamp() + RECEIVE_DEADLINE_CYCLES * cycle_time_ns;
+            if (!waitForMessage(sockfd, deadline, &arrivalTimestamp)) {
+                // without messages the server still gets a cycle after every receive deadline
+                if (cooperative != NULL) {
+                    runCooperativeServer(cooperative, getCurrentTimestamp() + cycle_time_ns);
+                }
+                continue;
+            }
+        } else if (xdp != NULL) {
+            // the rx ring is shared memory, polling it costs no syscall and the frame is taken out of it by the subscribe callback
+            if (!hasXdpFrame(xdp)) {
+                continue;
+            }
+            arrivalTimestamp = getCurrentTimestamp();
+        }
+        if (redundant || blockingReceive) {
+            TRACE_STAGE_AT(SUBSCRIBE_TRACE_ARRIVAL, arrivalTimestamp);
+        }
+        TRACE_STAGE(SUBSCRIBE_TRACE_WAKE_UP);
+        Source *source;
+        if (dispatch) {
+            source = subscribeDispatched(server, subscriber, path);
+        } else {
+            UA_ReaderGroup_subscribeCallback(server, readerGroup);
+            // the subscribe callback decodes and writes the fields in one go
+            TRACE_STAGE(SUBSCRIBE_TRACE_WRITTEN);
+            source = &subscriber->sources[0];
+        }
+        if (source == NULL) {
+            if (cooperative != NULL) {
+                // foreign or rejected frames must not starve the server, it works until the next message of the stream is expected
+                UA_UInt64 currentTimestamp = getCurrentTimestamp();
+                if (expectedTimestamp <= currentTimestamp) {
+                    expectedTimestamp += ((currentTimestamp - expectedTimestamp) / cycle_time_ns + 1) * cycle_time_ns;
+                }
+                runCooperativeServer(cooperative, expectedTimestamp);
+            }
+            continue;
+        }
+        ReceivedFields *receivedFields = &source->fields;
+        UA_UInt64 *receivedValue = receivedFields->fields[0].value;
+        if (redundant && receivedFields->updated &&
+            !acceptFirstCopy(subscriber, &source->duplicateFilter, *receivedValue / (batchSize > 0 ? batchSize : 1), path, arrivalTimestamp)) {
+            // the fields hold the values of the first copy again, the snapshot and the log already have them
+            receivedFields->updated = false;
+            continue;
+        }
+        if (receivedFields->updated && subscriber->echoWriterGroup != NULL) {
+            // the echo leaves before anything else is done with the message, the turnaround starts at the arrival of the message if it is
+            // known and covers only the publish of the echo otherwise
+            UA_UInt64 echoStart = blockingReceive ? arrivalTimestamp : getCurrentTimestamp();
+            subscriber->echoCounter = *receivedValue;
+            UA_WriterGroup_publishCallback(server, subscriber->echoWriterGroup);
+            echoTurnaround = getCurrentTimestamp() - echoStart;
+        }
+        if (receivedFields->updated) {
+            publishSnapshot(receivedFields);
+            TRACE_STAGE(SUBSCRIBE_TRACE_SNAPSHOT);
+            // the warm up and the schedule calibration of the publisher send frames before its counter starts, they would count
+            // as reordered
+            if (*receivedValue > lastWarmupValue) {
+                countSequence(source, *receivedValue, batchSize > 0 ? batchSize : 1);
+            }
+        }
+        if (decodeBenchmarkMessages > 0 && matchFixedLayout(&source->decoder, &subscriber->message)) {
+            // the benchmark replaces the measurement and needs a message that matches the learned template
+            benchmarkDecode(server, subscriber, source, decodeBenchmarkMessages);
             *running = false;
+            break;
+        }
+        if (receivedFields->updated && *receivedValue <= lastWarmupValue) {
+            // frames of the warm up cycles of the publisher only exercise the code paths
+            receivedFields->updated = false;
+        }
+        if (receivedFields->updated) {
+            if (loggedRecords == 0) {
+                getThreadPageFaults(&measurementMinorFaults, &measurementMajorFaults);
+                measurementCpuTime = getThreadCpuTime();
+            }
+            UA_UInt64 currentTimestamp = getCurrentTimestamp();
+            LogRecord receivedRecord = {*receivedValue, blockingReceive || xdp != NULL ? arrivalTimestamp : currentTimestamp, currentTimestamp,
+                                        0, 0, 0, 0, source->index, 0, path};
+            UA_UInt64 previousWriteIndex = source->writeIndex;
+            receivedFields->updated = false;
+            if (batchSize > 0) {
+                // unbatch the samples, each keeps the timestamp it was taken at and shares the arrival of the message
+                UA_UInt64 *sampleValues = receivedFields->fields[fieldsSize - BATCH_FIELDS].value;
+                UA_UInt64 *sampleTimes = receivedFields->fields[fieldsSize - BATCH_FIELDS + 1].value;
+                for (UA_UInt32 i = 0; i < batchSize && (measurements == 0 || source->writeIndex < measurements); i++) {
+                    if (sampleValues[i] <= lastWarmupValue) {
+                        continue;
+                    }
+                    receivedRecord.value = sampleValues[i];
+                    receivedRecord.sampleTimestamp = sampleTimes[i];
+                    pushLogRecord(ring, &receivedRecord);
+                    source->writeIndex++;
+                }
+            } else if (measurements == 0 || source->writeIndex < measurements) {
+                pushLogRecord(ring, &receivedRecord);
+                source->writeIndex++;
+            }
+            if (source->receivedMessages > 0) {
+                recordHistogramValue(&source->histograms[SUBSCRIBE_INTERVAL_HISTOGRAM], receivedRecord.timestamp - source->previousTimestamp);
+            }
+            recordHistogramValue(&source->histograms[PROCESSING_DURATION_HISTOGRAM], receivedRecord.processedTimestamp - receivedRecord.timestamp);
+            if (subscriber->echoHistogram != NULL) {
+                recordHistogramValue(subscriber->echoHistogram, echoTurnaround);
+            }
+            source->previousTimestamp = receivedRecord.timestamp;
+            source->receivedMessages++;
+            loggedRecords += source->writeIndex - previousWriteIndex;
+            measuredMessages++;
+            if (measurements > 0 && previousWriteIndex < measurements && source->writeIndex == measurements) {
+                completedSources++;
+            }
+            TRACE_STAGE(SUBSCRIBE_TRACE_LOGGED);
+            TRACE_END(measuredMessages, *receivedValue);
+        }
+        if (measurements > 0 && completedSources == subscriber->sourcesSize) {
+            *running = false;
+        }
+        if (secure != NULL) {
+            // the keystreams of the next messages are ready before they arrive
+            precomputeKeystreams(secure);
         }
+        if (cooperative != NULL) {
+            // the server works in the slack until the next message is expected, also during the warm up
+            expectedTimestamp = arrivalTimestamp + cycle_time_ns;
+            runCooperativeServer(cooperative, expectedTimestamp);
+        }
+    }
+    reportThreadPageFaults("subscribe thread", measurementMinorFaults, measurementMajorFaults);
+    if (measuredMessages > 0) {
+        UA_UInt64 cpuTime = getThreadCpuTime() - measurementCpuTime;
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "subscribe thread cpu time: %llu us for %llu messages of %zu sources, %.3f us per message",
+                    (unsigned long long) (cpuTime / 1000), (unsigned long long) measuredMessages, subscriber->sourcesSize,
+                    (UA_Double) cpuTime / 1000.0 / (UA_Double) measuredMessages);
+    }
+    UA_UInt64 lostMessages = 0, reorderedMessages = 0;
+    for (size_t i = 0; i < subscriber->sourcesSize; i++) {
+        Source *source = &subscriber->sources[i];
+        if (subscriber->sourcesSize > 1 && (source->lostMessages > 0 || source->reorderedMessages > 0)) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "source %zu: %llu lost and %llu reordered messages", i,
+                        (unsigned long long) source->lostMessages, (unsigned long long) source->reorderedMessages);
+        }
+        lostMessages += source->lostMessages;
+        reorderedMessages += source->reorderedMessages;
+    }
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "sequence gaps: %llu lost and %llu reordered messages",
+                (unsigned long long) lostMessages, (unsigned long long) reorderedMessages);
+    if (redundant) {
+        UA_UInt64 bothPaths = subscriber->pathWins[0] + subscriber->pathWins[1];
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "redundant paths: %llu and %llu copies received, %llu messages over both paths, the "
+                                                          "primary path was first %llu times and the redundant path %llu times, %llu messages "
+                                                          "over one path only, %llu late copies", (unsigned long long) subscriber->receivedCopies[0],
+                    (unsigned long long) subscriber->receivedCopies[1], (unsigned long long) bothPaths, (unsigned long long) subscriber->pathWins[0],
+                    (unsigned long long) subscriber->pathWins[1], (unsigned long long) (subscriber->firstCopies - bothPaths),
+                    (unsigned long long) subscriber->lateCopies);
+    }
+    if (dispatch) {
+        UA_UInt64 fixedDecodes = 0, fullDecodes = 0;
+        for (size_t i = 0; i < subscriber->sourcesSize; i++) {
+            fixedDecodes += subscriber->sources[i].decoder.fixedDecodes;
+            fullDecodes += subscriber->sources[i].decoder.fullDecodes;
+        }
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "%llu messages decoded by the fixed layout, %llu by the full decoder, %llu of unknown sources",
+                    (unsigned long long) fixedDecodes, (unsigned long long) fullDecodes, (unsigned long long) subscriber->unknownMessages);
     }
     return NULL;
 }
 
 static int
-run(UA_String *transportProfile, UA_NetworkAddressUrlDataType *networkAddressUrl, int port, UA_UInt64 cycle_time_ns, UA_UInt64 measurements) {
-    // start the server and subscribe to the published fields
-    signal(SIGINT, signalHandler);
-    signal(SIGTERM, signalHandler);
+run(UA_String *transportProfile, UA_NetworkAddressUrlDataType *networkAddressUrl, int port, UA_UInt64 cycle_time_ns, UA_UInt64 measurements,
+    PubSubOptions *options) {
+    // start the server and subscribe to the published fields of all sources
+    static const char *traceStageNames[SUBSCRIBE_TRACE_STAGES] = {"Arrival", "WakeUp", "Received", "Decoded", "Written", "Snapshot", "Logged"};
+    UA_Boolean running = true;
+    UA_Boolean traced = TRACE_ENABLED;
+    if (options->publishCpusSize > 0) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the subscriber runs a single subscribe thread");
+        exit(EXIT_FAILURE);
+    }
+    if (options->writerGroupsSize > 0) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the subscriber takes the writer groups of a publisher as sources");
+        exit(EXIT_FAILURE);
+    }
+    if (options->spinWakeup) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the subscribe thread waits for messages, not for cycle boundaries");
+        exit(EXIT_FAILURE);
+    }
+    if (options->overrunPolicy != OVERRUN_POLICY_SKIP) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the subscriber counts lost messages, the overrun policy belongs to the publisher");
+        exit(EXIT_FAILURE);
+    }
+    if (options->echo && options->securityMode != SECURITY_MODE_NONE) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the echoes are not secured");
+        exit(EXIT_FAILURE);
+    }
+    if (options->echo && options->sourcesSize > 1) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the subscriber echoes the messages of exactly one source");
+        exit(EXIT_FAILURE);
+    }
+    if (options->cooperativeServer && (options->sourcesSize > 1 || options->batchSize > 1 || options->snapshotReaders > 0 || options->xdp)) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "the cooperative server shares the core of the subscribe thread with a single source "
+                                                          "without batches, snapshot readers and xdp polling");
+        exit(EXIT_FAILURE);
+    }
+    if (options->redundant || options->cooperativeServer) {
+        // both paths are waited for with ppoll, the kernel receive timestamps tell which copy arrived first
+        options->blockingReceive = true;
+    }
+    setupSignalHandler(&running);
+    if (options->lockMemory) {
+        lockMemory();
+    }
     UA_Server *server = createServer(port);
     UA_DataSetReaderConfig readerConfig;
-    UA_NodeId connectionIdent, readerGroupIdent, readerIdent, subscribedValueNodeId;
-    pthread_t subscribeThread, serverThread;
-    UA_UInt64 *receivedValues, *receivedTimestamps;
-    addPubSubConnection(server, transportProfile, networkAddressUrl, &connectionIdent);
-    setupSocket(server->pubSubManager.connections.tqh_first->channel->sockfd);
-    addReaderGroup(server, connectionIdent, &readerGroupIdent);
-    addDataSetReader(server, &readerConfig, readerGroupIdent, &readerIdent);
-    addSubscribedVariables(server, readerIdent, &readerConfig, &subscribedValueNodeId, readerGroupIdent);
-    UA_Boolean running = true;
-    startServerThread(server, &running, &serverThread, CPU_ONE);
-    startPubSubThread(server, customSubscribeLoop, cycle_time_ns, &subscribedValueNodeId, UA_ReaderGroup_findRGbyId(server, readerGroupIdent),
-                      &subscribeThread, &receivedValues, &receivedTimestamps, measurements, &running, CPU_TWO);
+    UA_NodeId connectionIdent, readerIdent;
+    pthread_t subscribeThread, serverThread, logWriterThread;
+    CooperativeServer cooperative;
+    SnapshotReader snapshotReaders[MAX_SNAPSHOT_READERS];
+    LogRing receivedRecords;
+    DataSetLayout layout;
+    Subscriber subscriber;
+    createDataSetLayout(&layout, options);
+    subscriber.fixedLayout = options->fastSubscribe || options->decodeBenchmarkMessages > 0;
+    createSources(&subscriber, &layout, options);
+    addPubSubConnection(server, transportProfile, networkAddressUrl, PUBLISHER_ID, &connectionIdent);
+    subscriber.channels[0] = UA_PubSubConnection_findConnectionbyId(server, connectionIdent)->channel;
+    subscriber.sockfds[0] = subscriber.channels[0]->sockfd;
+    int sockfd = subscriber.sockfds[0];
+    setupSocket(sockfd, networkAddressUrl, options);
+    if (options->xdp) {
+        createXdpSocket(&subscriber.xdp, subscriber.channels[0], networkAddressUrl);
+    }
+    if (options->redundant) {
+        // the copies of the redundant path arrive on a second connection, the readers of the sources are attached to the first one
+        UA_NodeId redundantConnectionIdent;
+        addPubSubConnection(server, &options->redundantTransportProfile, &options->redundantAddress, PUBLISHER_ID, &redundantConnectionIdent);
+        subscriber.channels[1] = UA_PubSubConnection_findConnectionbyId(server, redundantConnectionIdent)->channel;
+        subscriber.sockfds[1] = subscriber.channels[1]->sockfd;
+        setupSocket(subscriber.sockfds[1], &options->redundantAddress, options);
+    }
+    if (options->securityMode != SECURITY_MODE_NONE) {
+        // both paths carry the same secured frames and share the keystreams
+        createSecureChannel(&subscriber.secure, options->securityMode, options->securityKeys);
+        for (size_t i = 0; i < (options->redundant ? REDUNDANT_PATHS : 1); i++) {
+            hookSecureChannel(subscriber.channels[i], &subscriber.secure);
+        }
+    }
+    for (size_t i = 0; i < (options->redundant ? REDUNDANT_PATHS : 1) && traced; i++) {
+        // the trace hook times the receive inside the subscribe callback, around the xdp hook
+        hookTraceChannel(subscriber.channels[i]);
+    }
+    for (size_t i = 0; i < subscriber.sourcesSize; i++) {
+        Source *source = &subscriber.sources[i];
+        addReaderGroup(server, connectionIdent, &source->readerGroupIdent);
+        addDataSetReader(server, &readerConfig, &layout, source, &readerIdent);
+        addSubscribedVariables(server, readerIdent, &readerConfig, source);
+        source->reader = UA_ReaderGroup_findDSRbyId(server, readerIdent);
+    }
+    if (options->echo) {
+        addEchoWriterGroup(server, &subscriber, cycle_time_ns, options);
+    }
+    subscriber.statistics.histograms = subscriber.histograms;
+    subscriber.statistics.histogramsSize = subscriber.sourcesSize * SUBSCRIBE_HISTOGRAMS + (options->echo ? 1 : 0) +
+                                           (options->redundant ? REDUNDANT_PATHS : 0) + (options->cooperativeServer ? 1 : 0);
+    addStatistics(server, &subscriber.statistics);
+    if (traced) {
+        createTraceBuffer(&subscriber.trace, "subscribe", traceStageNames, SUBSCRIBE_TRACE_STAGES, options);
+    }
+    createLogRing(&receivedRecords);
+    startLogWriterThread(&receivedRecords, SUBSCRIBE_LOG_FILE_NAME, cycle_time_ns, &logWriterThread, CPU_ONE);
+    subscriber.cooperative = NULL;
+    if (options->cooperativeServer) {
+        // the work histogram of the cooperative server is the last one of the subscriber
+        startCooperativeServer(&cooperative, server, options->cooperativeMargin_ns,
+                               &subscriber.histograms[subscriber.statistics.histogramsSize - 1]);
+        subscriber.cooperative = &cooperative;
+    } else {
+        startServerThread(server, &running, &serverThread, CPU_ONE);
+    }
+    startSnapshotReaders(&subscriber, snapshotReaders, options->snapshotReaders, &running);
+    // without a server thread the subscribe thread shares the core of the log writer
+    startPubSubThread(server, customSubscribeLoop, cycle_time_ns, &subscriber, UA_ReaderGroup_findRGbyId(server, subscriber.sources[0].readerGroupIdent),
+                      &subscribeThread, &receivedRecords, measurements, &running, options, sockfd, RT_THREAD_PRIORITY,
+                      options->cooperativeServer ? CPU_ONE : CPU_TWO);
     waitForThreadTermination(subscribeThread, false);
-    UA_StatusCode serverReturnValue = waitForThreadTermination(serverThread, true);
-    writeLogFile(SUBSCRIBE_LOG_FILE_NAME, receivedValues, receivedTimestamps, measurements);
+    running = false;
+    UA_Boolean consistentSnapshots = options->snapshotReaders == 0 || stopSnapshotReaders(snapshotReaders, options->snapshotReaders);
+    stopLogWriterThread(&receivedRecords, logWriterThread);
+    UA_StatusCode serverReturnValue = options->cooperativeServer ? stopCooperativeServer(&cooperative) : waitForThreadTermination(serverThread, true);
+    deleteLogRing(&receivedRecords);
+    if (traced) {
+        writeTraceFile(&subscriber.trace, SUBSCRIBE_TRACE_FILE_NAME);
+        deleteTraceBuffer(&subscriber.trace);
+    }
     UA_Server_delete(server);
-    return serverReturnValue == UA_STATUSCODE_GOOD ? EXIT_SUCCESS : EXIT_FAILURE;
+    if (options->xdp) {
+        deleteXdpSocket(&subscriber.xdp);
+    }
+    if (options->securityMode != SECURITY_MODE_NONE) {
+        deleteSecureChannel(&subscriber.secure, "subscribe thread");
+    }
+    if (options->echo) {
+        // the variant of the echo does not own the counter
+        UA_free(subscriber.echoValue);
+    }
+    deleteSources(&subscriber);
+    deleteDataSetLayout(&layout);
+    return serverReturnValue == UA_STATUSCODE_GOOD && consistentSnapshots ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 int main(int argc, char **argv) {
     // parse and pass command line parameters
-    if (argc == 6) {
-        UA_String transportProfile;
-        UA_NetworkAddressUrlDataType networkAddressUrl;
-        int port;
-        UA_UInt64 cycle_time_ns;
-        UA_UInt64 measurements;
-        fillArguments(argv, &transportProfile, &networkAddressUrl, &port, &cycle_time_ns, &measurements);
-        return run(&transportProfile, &networkAddressUrl, port, cycle_time_ns, measurements);
+    UA_String transportProfile;
+    UA_NetworkAddressUrlDataType networkAddressUrl;
+    int port;
+    UA_UInt64 cycle_time_ns;
+    UA_UInt64 measurements;
+    PubSubOptions options;
+    if (fillArguments(argc, argv, &transportProfile, &networkAddressUrl, &port, &cycle_time_ns, &measurements, &options)) {
+        if (options.codecCheckIterations > 0) {
+            return checkGeneratedCodec(options.codecCheckIterations) ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        if (options.securityCheck) {
+            return checkSecurity() ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        return run(&transportProfile, &networkAddressUrl, port, cycle_time_ns, measurements, &options);
     } else {
         usage(argv[0]);
         return EXIT_SUCCESS;